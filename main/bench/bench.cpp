@@ -0,0 +1,317 @@
+/*
+ * ─────────────────────────────────────────────────────────────
+ * FemtoClaw : host benchmarks for the message hot paths.
+ *
+ * Built by [env:native_bench] on the native Arduino shim, so the
+ * firmware headers compile unchanged. Inputs are recorded payloads
+ * (bench/payloads/): a Telegram getUpdates batch, a Discord message
+ * list, OpenRouter (chunked) and Ollama completions, an LLM reply
+ * with [ACTION:] tags and CONTROL.md board files.
+ *
+ * Usage (from main/):
+ *   pio run -e native_bench
+ *   .pio/build/native_bench/program [payload dir] [results.json]
+ *
+ * Each case is calibrated to ~20 ms per run; ns/op is the median of
+ * BENCH_RUNS runs. Results go to stdout as a table and to the JSON
+ * file (default bench_results.json) for trend tracking.
+ * ─────────────────────────────────────────────────────────────
+ */
+
+#include "platform.h"
+#include "constants.h"
+#include "config.h"
+#include "board_parser.h"
+#include "json.h"
+#include "arena.h"
+#include "mcu_wifi.h"
+#include "persist.h"
+#include "spsc.h"
+#include "hist.h"
+#include "mem.h"
+#include "http.h"
+#include "scheduler.h"
+#include "llm.h"
+#include "actions.h"
+
+#include <algorithm>
+#include <chrono>
+
+static constexpr uint8_t  BENCH_RUNS    = 5;
+static constexpr uint32_t BENCH_RUN_NS  = 20000000;   // calibration target per run
+static constexpr uint8_t  BENCH_MAX     = 24;
+static constexpr uint16_t PAYLOAD_S     = 8192;
+
+// ─── Harness ──────────────────────────────────────────────────────────────────
+struct BenchResult {
+  char     name[40];
+  uint32_t iters;               // iterations per run
+  double   ns_op;               // median over BENCH_RUNS
+  uint32_t bytes;               // input bytes per op (0 = n/a)
+};
+
+static BenchResult       s_results[BENCH_MAX];
+static uint8_t           s_result_n = 0;
+static volatile uint32_t s_sink;    // keeps results observable to the optimiser
+
+static uint64_t _now_ns() {
+  return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+template <typename F>
+static uint64_t _bench_run(F &fn, uint32_t iters) {
+  uint64_t t0 = _now_ns();
+  for (uint32_t i = 0; i < iters; ++i) s_sink += fn();
+  return _now_ns() - t0;
+}
+
+// fn() returns something derived from its work (a length, a count).
+template <typename F>
+static void bench(const char *name, uint32_t bytes, F fn) {
+  uint32_t iters = 1;
+  while (iters < (1u << 30)) {
+    uint64_t t = _bench_run(fn, iters);
+    if (t >= BENCH_RUN_NS) break;
+    uint64_t want = t ? (uint64_t)iters * BENCH_RUN_NS / t + 1 : (uint64_t)iters * 16;
+    iters = (uint32_t)std::min<uint64_t>(std::max<uint64_t>(want, (uint64_t)iters * 2), 1u << 30);
+  }
+  double runs[BENCH_RUNS];
+  for (uint8_t r = 0; r < BENCH_RUNS; ++r)
+    runs[r] = (double)_bench_run(fn, iters) / iters;
+  std::sort(runs, runs + BENCH_RUNS);
+
+  if (s_result_n >= BENCH_MAX) return;
+  BenchResult &b = s_results[s_result_n++];
+  strlcpy(b.name, name, sizeof(b.name));
+  b.iters = iters;
+  b.ns_op = runs[BENCH_RUNS / 2];
+  b.bytes = bytes;
+  printf("  %-34s %10.0f ns/op", b.name, b.ns_op);
+  if (bytes) printf("  %8.1f MB/s  (%u B)", bytes * 1e3 / b.ns_op, (unsigned)bytes);
+  printf("\n");
+}
+
+static bool _write_json(const char *path) {
+  FILE *f = fopen(path, "w");
+  if (!f) return false;
+  fprintf(f, "{\"bench\":\"femtoclaw\",\"platform\":\"%s\",\"time\":%lld,\"results\":[",
+          PLATFORM_NAME, (long long)time(nullptr));
+  for (uint8_t i = 0; i < s_result_n; ++i) {
+    const BenchResult &b = s_results[i];
+    fprintf(f, "%s\n  {\"name\":\"%s\",\"iters\":%u,\"ns_per_op\":%.1f,\"bytes\":%u,\"mb_per_s\":%.2f}",
+            i ? "," : "", b.name, (unsigned)b.iters, b.ns_op, (unsigned)b.bytes,
+            b.bytes ? b.bytes * 1e3 / b.ns_op : 0.0);
+  }
+  fprintf(f, "\n]}\n");
+  return fclose(f) == 0;
+}
+
+// ─── Payloads ─────────────────────────────────────────────────────────────────
+struct Payload {
+  char     data[PAYLOAD_S];
+  uint16_t len;
+};
+
+static Payload p_tg, p_dc, p_or, p_ollama, p_reply;
+static Payload p_md[3];
+static Payload p_md_b64;        // control_home.md as the GUI's text push sends it
+static const char *k_md_files[3] = { "control_home.md", "control_display.md", "control_led.md" };
+
+static bool _load(Payload &p, const char *dir, const char *file) {
+  char path[256];
+  snprintf(path, sizeof(path), "%s/%s", dir, file);
+  FILE *f = fopen(path, "rb");
+  if (!f) { fprintf(stderr, "bench: cannot open %s\n", path); return false; }
+  size_t n = fread(p.data, 1, PAYLOAD_S - 1, f);
+  fclose(f);
+  p.data[n] = '\0';
+  p.len = (uint16_t)n;
+  return n > 0;
+}
+
+// ─── Cases ────────────────────────────────────────────────────────────────────
+// The walks mirror _tg_parse / _dc_poll_chan without the inbox and flash
+// side effects.
+static uint32_t _walk_tg(const char *resp) {
+  uint32_t n = 0;
+  char id[ALLOW_ID_LEN], text[PROMPT_S];
+  for (const char *p = resp; (p = strstr(p, "\"update_id\"")) != nullptr; ++p) {
+    n += (uint32_t)jint(p + strlen("\"update_id\"") + 1);
+    const char *msg = strstr(p, "\"message\"");
+    if (!msg) continue;
+    const char *from = strstr(msg, "\"from\"");
+    const char *v = from ? jfind(from, "id") : nullptr;
+    if (v) id_from_int64(jint(v), id, sizeof(id));
+    const char *chat = strstr(msg, "\"chat\"");
+    v = chat ? jfind(chat, "id") : nullptr;
+    if (v) id_from_int64(jint(v), id, sizeof(id));
+    if ((v = jfind(msg, "text")) && jstr(v, text, PROMPT_S)) n += (uint8_t)text[0];
+  }
+  return n;
+}
+
+static uint32_t _walk_dc(const char *resp) {
+  uint32_t n = 0;
+  char id[ALLOW_ID_LEN], content[PROMPT_S];
+  for (const char *p = resp; (p = strstr(p, "\"id\"")) != nullptr; ++p) {
+    const char *v = p + strlen("\"id\"");
+    while (*v == ' ' || *v == ':') ++v;
+    id_from_str(v, id, sizeof(id));
+    const char *auth = strstr(p, "\"author\"");
+    if (auth && (v = jfind(auth, "id"))) id_from_str(v, id, sizeof(id));
+    if ((v = jfind(p, "content")) && jstr(v, content, PROMPT_S)) n += (uint8_t)content[0];
+  }
+  return n;
+}
+
+// llm_chat's completion parse: choices → message → content.
+static uint32_t _parse_completion(const char *resp, char *out, uint16_t cap) {
+  const char *ch = strstr(resp, "\"choices\"");
+  const char *mc = ch ? strstr(ch, "\"message\"") : nullptr;
+  const char *cc = mc ? strstr(mc, "\"content\"") : nullptr;
+  if (!cc) return 0;
+  const char *v = cc + strlen("\"content\"");
+  while (*v == ' ' || *v == ':') ++v;
+  return jstr(v, out, cap) ? strlen(out) : 0;
+}
+
+// base64_decode before the reverse table: one strchr() per input char.
+static uint16_t _b64_decode_strchr(const char *in, uint16_t in_len, char *out, uint16_t out_cap) {
+  uint16_t w = 0;
+  uint32_t val = 0;
+  int valb = -8;
+  for (uint16_t i = 0; i < in_len && w + 1 < out_cap; ++i) {
+    char c = in[i];
+    if (c == '=') break;
+    const char *pos = c ? strchr(b64_table, c) : nullptr;
+    if (!pos) continue;
+    val  = ((val << 6) | (uint32_t)(pos - b64_table)) & 0xFFFFFF;
+    valb += 6;
+    if (valb >= 0) {
+      out[w++] = (char)((val >> valb) & 0xFF);
+      valb -= 8;
+    }
+  }
+  out[w] = '\0';
+  return w;
+}
+
+// The text push as the shell sees it: 200-char 'board push chunk' lines
+// decoded into board_md one at a time.
+static uint32_t _push_chunks(const char *b64, uint16_t len) {
+  B64Dec d;
+  base64_dec_init(d);
+  uint16_t w = 0;
+  for (uint16_t at = 0; at < len; at += 200) {
+    uint16_t n = len - at < 200 ? len - at : 200;
+    w += base64_decode_feed(d, b64 + at, n, g_cfg.board_md + w,
+                            (uint16_t)(sizeof(g_cfg.board_md) - 1 - w));
+  }
+  g_cfg.board_md[w] = '\0';
+  return w;
+}
+
+static void _fill_session() {
+  session_clear();
+  for (uint8_t i = 0; i < 4; ++i) {
+    session_append("user", "turn on the lamp and tell me the light level");
+    session_append("assistant", p_reply.data);
+  }
+}
+
+int main(int argc, char **argv) {
+  const char *dir  = argc > 1 ? argv[1] : "bench/payloads";
+  const char *json = argc > 2 ? argv[2] : "bench_results.json";
+
+  bool ok = _load(p_tg, dir, "tg_getupdates.json") &&
+            _load(p_dc, dir, "dc_messages.json") &&
+            _load(p_or, dir, "openrouter_chunked.txt") &&
+            _load(p_ollama, dir, "ollama_completion.json") &&
+            _load(p_reply, dir, "llm_reply.txt");
+  for (uint8_t i = 0; i < 3 && ok; ++i) ok = _load(p_md[i], dir, k_md_files[i]);
+  if (!ok) return 1;
+  p_md_b64.len = base64_encode((const uint8_t *)p_md[0].data, p_md[0].len,
+                               p_md_b64.data, PAYLOAD_S);
+
+  native_serial_mute(true);     // parser / executor logging is not under test
+  printf("FemtoClaw benchmarks (%s), median of %u runs\n", PLATFORM_NAME, BENCH_RUNS);
+
+  // ── JSON ──────────────────────────────────────────────────────────────
+  bench("json_escape_into/control_home", p_md[0].len, [] {
+    return (uint32_t)json_escape_into(g_tx_body, JSON_OUT_S, p_md[0].data);
+  });
+  bench("json_escape_into/llm_reply", p_reply.len, [] {
+    return (uint32_t)json_escape_into(g_tx_body, JSON_OUT_S, p_reply.data);
+  });
+  bench("jfind_jstr/tg_getupdates", p_tg.len, [] { return _walk_tg(p_tg.data); });
+  bench("jfind_jstr/dc_messages", p_dc.len, [] { return _walk_dc(p_dc.data); });
+
+  // ── HTTP body ─────────────────────────────────────────────────────────
+  // Includes restoring the chunked body (unchunk works in place).
+  bench("unchunk/openrouter", p_or.len, [] {
+    memcpy(g_http_resp, p_or.data, p_or.len + 1);
+    return (uint32_t)unchunk(g_http_resp, p_or.len);
+  });
+  static char reply[RESP_S];
+  bench("completion_parse/openrouter", p_or.len, [] {
+    memcpy(g_http_resp, p_or.data, p_or.len + 1);
+    g_http_resp[unchunk(g_http_resp, p_or.len)] = '\0';
+    return _parse_completion(g_http_resp, reply, RESP_S);
+  });
+  bench("completion_parse/ollama", p_ollama.len, [] {
+    return _parse_completion(p_ollama.data, reply, RESP_S);
+  });
+
+  // ── Session / request ─────────────────────────────────────────────────
+  // A full history: every append evicts the oldest message first.
+  _fill_session();
+  uint32_t pair = strlen(p_reply.data) + 48;
+  bench("session_append/evicting", pair, [] {
+    session_append("user", "turn on the lamp and tell me the light level");
+    session_append("assistant", p_reply.data);
+    return (uint32_t)g_session_len;
+  });
+
+  strlcpy(g_cfg.board_md, p_md[0].data, sizeof(g_cfg.board_md));
+  g_cfg.board_md_loaded = true;
+  _fill_session();
+  uint16_t body = _llm_build_body("blink the onboard led 3 times", false);
+  bench("llm_build_body/full_session", body, [] {
+    return (uint32_t)_llm_build_body("blink the onboard led 3 times", false);
+  });
+
+  // ── Board ─────────────────────────────────────────────────────────────
+  bench("board_parse_md/control_home", p_md[0].len, [] {
+    return (uint32_t)board_parse_md(p_md[0].data);
+  });
+  bench("board_parse_md/control_display", p_md[1].len, [] {
+    return (uint32_t)board_parse_md(p_md[1].data);
+  });
+  bench("board_parse_md/control_led", p_md[2].len, [] {
+    return (uint32_t)board_parse_md(p_md[2].data);
+  });
+
+  // Text push payload; MB/s are of the base64 input.
+  static char md[PAYLOAD_S];
+  bench("base64_decode_strchr/control_home", p_md_b64.len, [] {
+    return (uint32_t)_b64_decode_strchr(p_md_b64.data, p_md_b64.len, md, PAYLOAD_S);
+  });
+  bench("base64_decode/control_home", p_md_b64.len, [] {
+    return (uint32_t)base64_decode(p_md_b64.data, p_md_b64.len, md, PAYLOAD_S);
+  });
+  bench("push_chunks/control_home", p_md_b64.len, [] {
+    return _push_chunks(p_md_b64.data, p_md_b64.len);
+  });
+
+  board_parse_md(p_md[0].data);
+  static char results[RESP_S];
+  bench("execute_actions/llm_reply", p_reply.len, [] {
+    return (uint32_t)execute_actions_in_response(p_reply.data, results, RESP_S);
+  });
+
+  native_serial_mute(false);
+  if (!_write_json(json)) { fprintf(stderr, "bench: cannot write %s\n", json); return 1; }
+  printf("results: %s\n", json);
+  return 0;
+}
@@ -0,0 +1,131 @@
+#!/usr/bin/env python3
+"""
+bss_report.py
+━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+Static RAM (.bss / .sbss / .ext_ram.bss) per symbol from GNU ld map files,
+side by side, to see what a memory profile (constants.h) buys.
+
+Every env writes $BUILD_DIR/firmware.map (-Wl,-Map in platformio.ini):
+  pio run -e esp32c3 -e esp32c3_tiny
+  python3 bench/bss_report.py .pio/build/esp32c3/firmware.map \\
+                              .pio/build/esp32c3_tiny/firmware.map
+
+The first map is the baseline; the others get a delta column. Symbols
+come from -fdata-sections input sections (.bss.<name>), demangled with
+c++filt when it is on PATH. Input sections without a symbol name are
+listed by object file.
+
+  --top N   rows to print (default 25, by largest size in any map)
+  --all     every symbol, not only the firmware's own (src/ objects)
+━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+"""
+
+import argparse, os, re, shutil, subprocess, sys
+
+BSS_OUT = re.compile(r"^(\.\S*bss\S*)\s")           # .bss .sbss .dram0.bss .ext_ram.bss
+OUT_SEC = re.compile(r"^(\.\S+)")
+IN_SEC  = re.compile(r"^ (\.\S+|COMMON)(?:\s+(0x[0-9a-f]+)\s+(0x[0-9a-f]+)\s+(.*))?$")
+ADDR_SZ = re.compile(r"^\s+(0x[0-9a-f]+)\s+(0x[0-9a-f]+)\s+(.*)$")
+
+
+def parse_map(path):
+    """{key: (bytes, object)} for the input sections of every bss output section."""
+    syms, total = {}, 0
+    in_map = False
+    out_bss = False
+    pending = None
+    with open(path, errors="replace") as f:
+        for line in f:
+            line = line.rstrip("\r\n")
+            if not in_map:
+                in_map = line.startswith("Linker script and memory map")
+                continue
+            if pending is not None:
+                m = ADDR_SZ.match(line)
+                if m:
+                    _add(syms, pending, int(m.group(2), 16), m.group(3))
+                    total += int(m.group(2), 16)
+                pending = None
+                continue
+            if line and not line[0].isspace():
+                m = OUT_SEC.match(line)
+                out_bss = bool(m and BSS_OUT.match(line + " "))
+                continue
+            if not out_bss:
+                continue
+            m = IN_SEC.match(line)
+            if not m:
+                continue
+            if m.group(2) is None:
+                pending = m.group(1)                       # long name: address / size on the next line
+            else:
+                size = int(m.group(3), 16)
+                _add(syms, m.group(1), size, m.group(4))
+                total += size
+    return syms, total
+
+
+def _add(syms, sec, size, obj):
+    if not size:
+        return
+    name = sec
+    for pre in (".ext_ram.bss.", ".sbss.", ".bss."):
+        if sec.startswith(pre):
+            name = sec[len(pre):]
+            break
+    else:
+        name = "[%s] %s" % (sec, os.path.basename(obj.strip()))
+    old = syms.get(name)
+    syms[name] = ((old[0] if old else 0) + size, obj.strip())
+
+
+def demangle(names):
+    cf = shutil.which("c++filt")
+    if not cf or not names:
+        return {n: n for n in names}
+    out = subprocess.run([cf], input="\n".join(names), capture_output=True, text=True).stdout
+    return dict(zip(names, out.splitlines()))
+
+
+def own(obj):
+    o = obj.replace("\\", "/")
+    return "/src/" in o or "femtoclaw" in o or "/bench/" in o
+
+
+def main():
+    ap = argparse.ArgumentParser(description="Compare .bss per symbol across link maps.")
+    ap.add_argument("maps", nargs="+", help="firmware.map files; the first is the baseline")
+    ap.add_argument("--top", type=int, default=25)
+    ap.add_argument("--all", action="store_true", help="include SDK / library symbols")
+    opt = ap.parse_args()
+
+    parsed = [parse_map(p) for p in opt.maps]
+    labels = [os.path.basename(os.path.dirname(os.path.abspath(p))) or p for p in opt.maps]
+
+    keys = set()
+    for syms, _ in parsed:
+        keys |= {k for k, (_, obj) in syms.items() if opt.all or own(obj)}
+    rows = sorted(keys, key=lambda k: -max(s.get(k, (0,))[0] for s, _ in parsed))[:opt.top]
+    names = demangle(rows)
+
+    w = max([len(names[k]) for k in rows] + [24])
+    head = "  %-*s" % (w, "symbol") + "".join(" %14s" % l[:14] for l in labels)
+    if len(parsed) > 1:
+        head += "".join(" %9s" % ("Δ" + str(i)) for i in range(1, len(parsed)))
+    print(head)
+    for k in rows:
+        sizes = [s.get(k, (0,))[0] for s, _ in parsed]
+        line = "  %-*s" % (w, names[k]) + "".join(" %14d" % v for v in sizes)
+        line += "".join(" %+9d" % (v - sizes[0]) for v in sizes[1:])
+        print(line)
+
+    own_tot = [sum(v for k, (v, obj) in s.items() if own(obj)) for s, _ in parsed]
+    print("  %-*s" % (w, "firmware .bss") + "".join(" %14d" % v for v in own_tot)
+          + "".join(" %+9d" % (v - own_tot[0]) for v in own_tot[1:]))
+    print("  %-*s" % (w, "all .bss") + "".join(" %14d" % t for _, t in parsed)
+          + "".join(" %+9d" % (t - parsed[0][1]) for _, t in parsed[1:]))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,723 @@
+#!/usr/bin/env python3
+"""
+mock_upstream.py
+━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+Local stand-in for the LLM, Telegram and Discord APIs, plus a load driver.
+  • OpenAI  POST …/chat/completions       stream (SSE) and non-stream
+  • Telegram getUpdates (long poll), sendMessage, editMessageText
+  • Discord  GET / POST channels/{id}/messages, PATCH messages/{id}
+  • Discord  Gateway over ws:// (any GET with Upgrade: websocket): HELLO,
+             IDENTIFY → READY, heartbeat ACKs, RESUME → missed events +
+             RESUMED, MESSAGE_CREATE for injected messages
+  • Configurable latency, token pacing, chunked bodies, 429s, sizes
+
+Point the firmware at it (native build or a board on the LAN):
+  set llm_api_base http://<pc>:8081/v1
+  set api_host     <pc>:8081            (Telegram / Discord REST, plain HTTP)
+  set tg_token     mock
+  set dc_token     mock
+  set dc_channel_id 1288012345678901234
+
+Run:
+  python3 bench/mock_upstream.py serve
+  python3 bench/mock_upstream.py load --messages 50 --rate 0.5 --json load.json
+  python3 bench/mock_upstream.py gateway
+  python3 bench/mock_upstream.py webhook --device http://127.0.0.1:8088/ --secret s3 --rate 0
+
+`gateway` scripts a Gateway session against a device configured as above
+(dc token + one dc channel): identify, heartbeats, messages, op 7
+RECONNECT (resume, with an event missed while away replayed), op 9
+INVALID_SESSION (fresh identify) and close 4004 (REST fallback), and
+prints PASS / FAIL per step. --no-gateway answers the upgrade with 404,
+so the device falls back to REST polling.
+
+`webhook` replays the updates in payloads/tg_getupdates.json (renumbered,
+tagged m1, m2, …) as Telegram pushes to a device in webhook mode
+(`tg webhook <port> <url> [secret]`), with the secret-token header, and
+reports accepted updates/s; 503s are redelivered like Telegram does.
+--rate 0 pushes back to back.
+
+`load` injects user messages tagged "m<n>", the mock LLM answers
+"m<n>: … end-m<n>", and each message's latency is measured from the
+injection to the first reply text (first) and to the complete reply
+(reply) on the chat side, then reported as percentiles.
+Python 3.8+, standard library only.
+━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+"""
+
+import argparse, base64, hashlib, http.client, json, os, random, re, socket, struct, sys, threading, time
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+from urllib.parse import urlsplit, parse_qs
+
+DC_CHANNEL = "1288012345678901234"
+TG_CHAT    = 5123456789
+USER_ID_DC = "402981234567891234"
+BOT_ID_DC  = "1288099999999999999"
+WS_GUID    = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
+
+WORDS = ("the lamp relay is now on and the light sensor reads a comfortable "
+         "level so nothing else needs to change right now").split()
+
+TAG_RE = re.compile(r"\bm(\d+)\b")
+END_RE = re.compile(r"\bend-m(\d+)\b")
+NUM_RE = re.compile(r"\bm(\d+):")
+
+
+# ── Shared state ──────────────────────────────────────────────────────────────
+class State:
+    def __init__(self, opt):
+        self.opt  = opt
+        self.lock = threading.Condition()
+        self.tg_updates = []                 # (update_id, dict)
+        self.tg_next    = int(time.time()) * 100     # above any offset a previous run left in flash
+        self.tg_msg_id  = 1000
+        self.tg_polls   = 0
+        self.dc_msgs    = []                 # user messages, oldest first
+        self.dc_next    = (int(time.time() * 1000) - 1420070400000) << 22   # snowflake of "now"
+        self.dc_polls   = 0
+        self.sent   = {}                     # tag -> time of the first reply text
+        self.done   = {}                     # tag -> time of the complete reply
+        self.counts = {}
+        # Gateway: sessions outlive connections (resume), conn is the live one
+        self.gw_conn     = None
+        self.gw_sessions = {}                # n -> {"sid": id, "seq": s, "log": [(s, frame)]}
+        self.gw_sid      = 0
+        self.gw_rx       = []                # (monotonic, op, d) from the device
+        self.dc_msgs.append(self._dc_add(DC_CHANNEL, "hello", bot=False))   # cursor seed for the first poll
+
+    def count(self, key):
+        self.counts[key] = self.counts.get(key, 0) + 1
+
+    def _dc_add(self, chan, text, bot):
+        self.dc_next += 1
+        m = {"id": str(self.dc_next), "channel_id": chan, "content": text, "type": 0,
+             "timestamp": time.strftime("%Y-%m-%dT%H:%M:%S+00:00", time.gmtime()),
+             "author": {"id": USER_ID_DC, "username": "load", "bot": bot}}
+        if self.opt.pad:
+            m["embeds"] = [{"description": "x" * self.opt.pad}]
+        return m
+
+    def inject(self, channel, text):
+        with self.lock:
+            if channel == "tg":
+                self.tg_msg_id += 1
+                u = {"update_id": self.tg_next,
+                     "message": {"message_id": self.tg_msg_id,
+                                 "from": {"id": TG_CHAT, "is_bot": False, "first_name": "Load"},
+                                 "chat": {"id": TG_CHAT, "type": "private"},
+                                 "date": int(time.time()), "text": text}}
+                if self.opt.pad:
+                    u["message"]["pad"] = "x" * self.opt.pad
+                self.tg_updates.append((self.tg_next, u))
+                self.tg_next += 1
+            else:
+                m = self._dc_add(DC_CHANNEL, text, bot=False)
+                self.dc_msgs.append(m)
+                self.gw_event("MESSAGE_CREATE", m)
+            self.lock.notify_all()
+
+    # Gateway dispatch (op 0) into the newest session's log, and out on the
+    # live connection when it is ready. Called with the lock held.
+    def gw_event(self, t, d):
+        if not self.gw_sessions:
+            return
+        s = self.gw_sessions[max(self.gw_sessions)]
+        s["seq"] += 1
+        frame = {"op": 0, "s": s["seq"], "t": t, "d": d}
+        s["log"].append((s["seq"], frame))
+        c = self.gw_conn
+        if c and c.ready and c.sid == s["sid"]:
+            c.send(frame)
+
+    def gw_wait(self, op, since, timeout):
+        """First op received from the device after `since`, or None."""
+        end = time.monotonic() + timeout
+        with self.lock:
+            while True:
+                for t, o, d in self.gw_rx:
+                    if o == op and t > since:
+                        return d
+                left = end - time.monotonic()
+                if left <= 0:
+                    return None
+                self.lock.wait(left)
+
+    def reply_seen(self, text):
+        now = time.monotonic()
+        with self.lock:
+            for t in NUM_RE.findall(text):
+                self.sent.setdefault(int(t), now)
+            for t in END_RE.findall(text):
+                self.sent.setdefault(int(t), now)
+                self.done.setdefault(int(t), now)
+            self.lock.notify_all()
+
+
+# ── Gateway connection ────────────────────────────────────────────────────────
+class GwConn:
+    """One ws:// connection: unmasked server frames, masked client frames."""
+
+    def __init__(self, st, sock):
+        self.st, self.sock = st, sock
+        self.wlock = threading.Lock()
+        self.ready = False
+        self.sid   = None
+
+    def _frame(self, opcode, data):
+        n = len(data)
+        hdr = bytes([0x80 | opcode])
+        if n < 126:
+            hdr += bytes([n])
+        elif n < 65536:
+            hdr += bytes([126]) + struct.pack(">H", n)
+        else:
+            hdr += bytes([127]) + struct.pack(">Q", n)
+        with self.wlock:
+            try:
+                self.sock.sendall(hdr + data)
+            except OSError:
+                pass
+
+    def send(self, obj):
+        self._frame(0x1, json.dumps(obj).encode())
+
+    def close(self, code, reason=""):
+        self._frame(0x8, struct.pack(">H", code) + reason.encode())
+        try:
+            self.sock.shutdown(socket.SHUT_RDWR)
+        except OSError:
+            pass
+
+    def _read(self, n):
+        b = b""
+        while len(b) < n:
+            got = self.sock.recv(n - len(b))
+            if not got:
+                raise ConnectionError
+            b += got
+        return b
+
+    def recv(self):
+        """(opcode, payload) of the next whole message, None at EOF."""
+        try:
+            msg, op = b"", None
+            while True:
+                h = self._read(2)
+                fin, opcode = h[0] & 0x80, h[0] & 0x0F
+                n = h[1] & 0x7F
+                if n == 126:
+                    n = struct.unpack(">H", self._read(2))[0]
+                elif n == 127:
+                    n = struct.unpack(">Q", self._read(8))[0]
+                mask = self._read(4) if h[1] & 0x80 else b"\0\0\0\0"
+                data = bytes(b ^ mask[i & 3] for i, b in enumerate(self._read(n)))
+                if opcode >= 0x8:
+                    return opcode, data
+                if opcode:
+                    op = opcode
+                msg += data
+                if fin:
+                    return op, msg
+        except (ConnectionError, OSError):
+            return None
+
+    def serve(self):
+        st, opt = self.st, self.st.opt
+        self.send({"op": 10, "d": {"heartbeat_interval": opt.hb_ms}})
+        while True:
+            fr = self.recv()
+            if fr is None or fr[0] == 0x8:
+                break
+            if fr[0] == 0x9:
+                self._frame(0xA, fr[1])
+                continue
+            try:
+                msg = json.loads(fr[1])
+            except ValueError:
+                continue
+            op, d = msg.get("op"), msg.get("d")
+            with st.lock:
+                st.gw_rx.append((time.monotonic(), op, d))
+                st.count("gw_op%s" % op)
+                if op == 1:
+                    self.send({"op": 11})
+                elif op == 2:
+                    st.gw_sid += 1
+                    self.sid = "mock-session-%d" % st.gw_sid
+                    st.gw_sessions[st.gw_sid] = {"sid": self.sid, "seq": 0, "log": []}
+                    self.ready = True
+                    st.gw_event("READY", {"v": 10, "session_id": self.sid,
+                                          "resume_gateway_url": "wss://gateway-resume.mock",
+                                          "user": {"id": BOT_ID_DC, "username": "mock", "bot": True}})
+                elif op == 6:
+                    sess = [s for s in st.gw_sessions.values()
+                            if s["sid"] == (d or {}).get("session_id")]
+                    if not sess:
+                        self.send({"op": 9, "d": False})
+                    else:
+                        self.sid, self.ready = sess[0]["sid"], True
+                        seq = int((d or {}).get("seq") or 0)
+                        for s, frame in sess[0]["log"]:
+                            if s > seq:
+                                self.send(frame)
+                        st.gw_event("RESUMED", {})
+                st.lock.notify_all()
+        with st.lock:
+            if st.gw_conn is self:
+                st.gw_conn = None
+            st.lock.notify_all()
+
+
+# ── HTTP handler ──────────────────────────────────────────────────────────────
+class Handler(BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.1"
+    st = None                                # State, set in main()
+
+    def log_message(self, *a):
+        if self.st.opt.verbose:
+            sys.stderr.write("[mock] " + (a[0] % a[1:]) + "\n")
+
+    def _body(self):
+        n = int(self.headers.get("Content-Length") or 0)
+        raw = self.rfile.read(n) if n else b""
+        try:
+            return json.loads(raw) if raw else {}
+        except ValueError:
+            return {}
+
+    def _send(self, code, obj, headers=()):
+        data = obj if isinstance(obj, bytes) else json.dumps(obj).encode()
+        self.send_response(code)
+        self.send_header("Content-Type", "application/json")
+        for k, v in headers:
+            self.send_header(k, v)
+        chunk = self.st.opt.chunk
+        if chunk:
+            self.send_header("Transfer-Encoding", "chunked")
+            self.end_headers()
+            for i in range(0, len(data), chunk):
+                piece = data[i:i + chunk]
+                self.wfile.write(b"%x\r\n%s\r\n" % (len(piece), piece))
+            self.wfile.write(b"0\r\n\r\n")
+        else:
+            self.send_header("Content-Length", str(len(data)))
+            self.end_headers()
+            self.wfile.write(data)
+
+    def _delay(self):
+        if self.st.opt.latency:
+            time.sleep(self.st.opt.latency / 1000.0)
+
+    def _limited(self):
+        return self.st.opt.rate_429 and random.random() < self.st.opt.rate_429
+
+    def do_GET(self):   self._route("GET")
+    def do_POST(self):  self._route("POST")
+    def do_PATCH(self): self._route("PATCH")
+
+    def _route(self, method):
+        if self.headers.get("Upgrade", "").lower() == "websocket":
+            return self._gateway()
+        u = urlsplit(self.path)
+        path, q = u.path, parse_qs(u.query)
+        body = self._body() if method != "GET" else {}
+        if path.endswith("/chat/completions"):
+            return self._llm(body)
+        m = re.match(r"^/bot[^/]+/(\w+)$", path)
+        if m:
+            return self._tg(m.group(1), q, body)
+        m = re.match(r"^/api/v\d+/channels/(\d+)/messages(?:/(\d+))?$", path)
+        if m:
+            return self._dc(method, m.group(1), m.group(2), q, body)
+        self.st.count("404")
+        self._send(404, {"message": "not found"})
+
+    # ── Discord Gateway ───────────────────────────────────────────────────
+    def _gateway(self):
+        st = self.st
+        st.count("gw_connect")
+        key = self.headers.get("Sec-WebSocket-Key", "")
+        if st.opt.no_gateway or not key:
+            return self._send(404, {"message": "no gateway"})
+        accept = base64.b64encode(hashlib.sha1((key + WS_GUID).encode()).digest()).decode()
+        self.wfile.write(("HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\n"
+                          "Connection: Upgrade\r\nSec-WebSocket-Accept: %s\r\n\r\n" % accept).encode())
+        self.wfile.flush()
+        c = GwConn(st, self.connection)
+        with st.lock:
+            old, st.gw_conn = st.gw_conn, c
+        if old:
+            old.close(1000)
+        c.serve()
+        self.close_connection = True
+
+    # ── LLM ───────────────────────────────────────────────────────────────
+    def _llm(self, body):
+        st, opt = self.st, self.st.opt
+        msgs = body.get("messages") or [{}]
+        last = str(msgs[-1].get("content", ""))
+        tag  = TAG_RE.search(last)
+        n    = tag.group(1) if tag else "0"
+        words = [WORDS[i % len(WORDS)] for i in range(opt.reply_words)]
+        pieces = ["m%s: " % n] + [w + " " for w in words] + ["end-m%s" % n]
+        self._delay()
+        if body.get("stream"):
+            st.count("llm_stream")
+            self.send_response(200)
+            self.send_header("Content-Type", "text/event-stream")
+            self.send_header("Transfer-Encoding", "chunked")
+            self.end_headers()
+            for p in pieces:
+                ev = "data: " + json.dumps({"choices": [{"index": 0, "delta": {"content": p}}]}) + "\n\n"
+                ev = ev.encode()
+                self.wfile.write(b"%x\r\n%s\r\n" % (len(ev), ev))
+                self.wfile.flush()
+                if opt.token_ms:
+                    time.sleep(opt.token_ms / 1000.0)
+            ev = b"data: [DONE]\n\n"
+            self.wfile.write(b"%x\r\n%s\r\n0\r\n\r\n" % (len(ev), ev))
+            return
+        st.count("llm")
+        if opt.token_ms:
+            time.sleep(opt.token_ms * len(pieces) / 1000.0)   # generation time
+        self._send(200, {"id": "mock", "object": "chat.completion", "model": body.get("model", "mock"),
+                         "choices": [{"index": 0, "finish_reason": "stop",
+                                      "message": {"role": "assistant", "content": "".join(pieces)}}]})
+
+    # ── Telegram ──────────────────────────────────────────────────────────
+    def _tg(self, verb, q, body):
+        st = self.st
+        if verb == "getUpdates":
+            offset  = int(q.get("offset", ["0"])[0])
+            timeout = min(int(q.get("timeout", ["0"])[0]), 30)
+            limit   = int(q.get("limit", ["100"])[0]) or 100
+            end = time.monotonic() + timeout
+            with st.lock:
+                st.tg_polls += 1
+                st.lock.notify_all()
+                while True:
+                    res = [u for i, u in st.tg_updates if i >= offset][:limit]
+                    left = end - time.monotonic()
+                    if res or left <= 0:
+                        break
+                    st.lock.wait(left)
+            st.count("tg_getUpdates")
+            self._delay()
+            return self._send(200, {"ok": True, "result": res})
+        if verb in ("sendMessage", "editMessageText"):
+            self._delay()
+            if self._limited():
+                st.count("tg_429")
+                return self._send(429, {"ok": False, "error_code": 429,
+                                        "description": "Too Many Requests: retry after 1",
+                                        "parameters": {"retry_after": 1}},
+                                  [("Retry-After", "1")])
+            st.count("tg_" + verb)
+            st.reply_seen(str(body.get("text", "")))
+            with st.lock:
+                if verb == "sendMessage":
+                    st.tg_msg_id += 1
+                mid = int(body.get("message_id") or st.tg_msg_id)
+            return self._send(200, {"ok": True, "result": {
+                "message_id": mid, "chat": {"id": TG_CHAT, "type": "private"},
+                "date": int(time.time()), "text": body.get("text", "")}})
+        st.count("tg_" + verb)
+        self._send(200, {"ok": True, "result": True})
+
+    # ── Discord ───────────────────────────────────────────────────────────
+    def _dc(self, method, chan, msg_id, q, body):
+        st = self.st
+        self._delay()
+        rl = [("X-RateLimit-Remaining", "4"), ("X-RateLimit-Reset-After", "1.0")]
+        if method == "GET":
+            with st.lock:
+                st.dc_polls += 1
+                st.lock.notify_all()
+                after = q.get("after", [None])[0]
+                limit = int(q.get("limit", ["50"])[0])
+                ms = [m for m in st.dc_msgs if m["channel_id"] == chan]
+                if after:                                 # the oldest `limit` after the cursor
+                    ms = [m for m in ms if int(m["id"]) > int(after)][:limit]
+                res = list(reversed(ms))[:limit]          # newest first, like Discord
+            st.count("dc_poll")
+            return self._send(200, res, rl)
+        if self._limited():
+            st.count("dc_429")
+            return self._send(429, {"message": "You are being rate limited.", "retry_after": 1.0,
+                                    "global": False}, [("Retry-After", "1")] + rl)
+        text = str(body.get("content", ""))
+        st.count("dc_edit" if method == "PATCH" else "dc_send")
+        st.reply_seen(text)
+        with st.lock:
+            m = st._dc_add(chan, text, bot=True)        # bot messages are not polled back
+            if msg_id:
+                m["id"] = msg_id
+        self._send(200, m, rl)
+
+
+class Server(ThreadingHTTPServer):
+    daemon_threads = True
+
+    def handle_error(self, request, client_address):
+        if not isinstance(sys.exc_info()[1], ConnectionError):    # device dropped a socket
+            super().handle_error(request, client_address)
+
+
+# ── Load driver ───────────────────────────────────────────────────────────────
+def _pct(xs, p):
+    if not xs:
+        return 0.0
+    xs = sorted(xs)
+    k = min(len(xs) - 1, max(0, int(round(p / 100.0 * (len(xs) - 1)))))
+    return xs[k]
+
+
+def _stats(ms):
+    return {"n": len(ms), "mean": sum(ms) / len(ms) if ms else 0.0,
+            "p50": _pct(ms, 50), "p90": _pct(ms, 90), "p99": _pct(ms, 99),
+            "max": max(ms) if ms else 0.0}
+
+
+def run_load(st, opt):
+    chans = ["tg", "dc"] if opt.channel == "both" else [opt.channel]
+    print("[load] waiting for the device to poll (%s) ..." % ", ".join(chans), flush=True)
+    with st.lock:
+        while ("tg" in chans and not st.tg_polls) or \
+              ("dc" in chans and not st.dc_polls and not (st.gw_conn and st.gw_conn.ready)):
+            st.lock.wait(1.0)
+
+    t_in = {}
+    prompt = opt.prompt
+    for n in range(1, opt.messages + 1):
+        ch = chans[(n - 1) % len(chans)]
+        t_in[n] = (ch, time.monotonic())
+        st.inject(ch, "m%d %s" % (n, prompt))
+        if n < opt.messages and opt.rate > 0:
+            time.sleep(1.0 / opt.rate)
+
+    deadline = time.monotonic() + opt.timeout
+    with st.lock:
+        while len(st.done) < opt.messages and time.monotonic() < deadline:
+            st.lock.wait(1.0)
+        sent, done = dict(st.sent), dict(st.done)
+
+    res = {"messages": opt.messages, "rate": opt.rate, "channel": opt.channel,
+           "latency_ms": opt.latency, "token_ms": opt.token_ms, "reply_words": opt.reply_words,
+           "rate_429": opt.rate_429, "chunk": opt.chunk, "counts": dict(st.counts)}
+    for ch in chans + (["all"] if len(chans) > 1 else []):
+        ids = [n for n, (c, _) in t_in.items() if ch in ("all", c)]
+        first = [(sent[n] - t_in[n][1]) * 1000.0 for n in ids if n in sent]
+        reply = [(done[n] - t_in[n][1]) * 1000.0 for n in ids if n in done]
+        res[ch] = {"sent": len(ids), "lost": len(ids) - len(reply),
+                   "first": _stats(first), "reply": _stats(reply)}
+
+    print("\n%-4s %-6s %5s %5s %9s %9s %9s %9s %9s" %
+          ("ch", "stage", "n", "lost", "mean", "p50", "p90", "p99", "max"))
+    for ch in chans + (["all"] if len(chans) > 1 else []):
+        for stage in ("first", "reply"):
+            s = res[ch][stage]
+            print("%-4s %-6s %5d %5d %7.0fms %7.0fms %7.0fms %7.0fms %7.0fms" %
+                  (ch, stage, s["n"], res[ch]["lost"], s["mean"], s["p50"], s["p90"], s["p99"], s["max"]))
+    print("requests: " + ", ".join("%s=%d" % kv for kv in sorted(st.counts.items())))
+    if opt.json:
+        with open(opt.json, "w") as f:
+            json.dump(res, f, indent=1)
+        print("results: " + opt.json)
+    return 0 if all(res[c]["lost"] == 0 for c in chans) else 1
+
+
+def run_gateway(st, opt):
+    """Scripted Gateway session; one PASS / FAIL line per step."""
+    fails = []
+
+    def step(name, ok, detail=""):
+        print("[gw] %-34s %s%s" % (name, "PASS" if ok else "FAIL", "  " + detail if detail else ""),
+              flush=True)
+        if not ok:
+            fails.append(name)
+        return ok
+
+    def done(n, timeout):
+        end = time.monotonic() + timeout
+        with st.lock:
+            while n not in st.done and time.monotonic() < end:
+                st.lock.wait(1.0)
+            return n in st.done
+
+    def ask(n):
+        st.inject("dc", "m%d %s" % (n, opt.prompt))
+        return done(n, opt.timeout)
+
+    def conn():
+        with st.lock:
+            return st.gw_conn
+
+    print("[gw] waiting for the device to connect ...", flush=True)
+    t = time.monotonic()
+    d = st.gw_wait(2, 0, opt.timeout)
+    if not step("HELLO → IDENTIFY", d is not None and "token" in (d or {})):
+        return 1
+    step("heartbeat → ACK", st.gw_wait(1, t, opt.hb_ms / 1000.0 * 2 + 5) is not None)
+
+    step("MESSAGE_CREATE → reply", ask(1))
+
+    # op 7: the device resumes; m2 arrives while it is away and is replayed
+    c = conn()
+    with st.lock:
+        sid, seq = c.sid, st.gw_sessions[st.gw_sid]["seq"]
+        c.ready, st.gw_conn = False, None
+    t = time.monotonic()
+    c.send({"op": 7, "d": None})
+    st.inject("dc", "m2 " + opt.prompt)
+    d = st.gw_wait(6, t, 30) or {}
+    step("RECONNECT → RESUME", d.get("session_id") == sid and int(d.get("seq") or -1) == seq,
+         "session %s seq %s (want %s %d)" % (d.get("session_id"), d.get("seq"), sid, seq))
+    step("missed MESSAGE_CREATE replayed", done(2, opt.timeout))
+
+    # op 9 false: the session is gone, the device identifies again
+    t = time.monotonic()
+    conn().send({"op": 9, "d": False})
+    d = st.gw_wait(2, t, 30)
+    step("INVALID_SESSION → IDENTIFY", d is not None and st.gw_wait(6, t, 0) is None)
+    step("new session → reply", ask(3))
+
+    # close 4004: fatal for the Gateway, REST polling takes over
+    with st.lock:
+        polls = st.dc_polls
+    conn().close(4004, "Authentication failed.")
+    end = time.monotonic() + 30
+    with st.lock:
+        while st.dc_polls == polls and time.monotonic() < end:
+            st.lock.wait(1.0)
+        polled = st.dc_polls > polls
+    step("close 4004 → REST fallback", polled)
+    step("REST poll → reply", ask(4))
+
+    print("requests: " + ", ".join("%s=%d" % kv for kv in sorted(st.counts.items())))
+    return 1 if fails else 0
+
+
+def run_webhook(st, opt):
+    """Push payload updates to the device's webhook listener, one at a time."""
+    u = urlsplit(opt.device)
+    path = u.path or "/"
+    src = os.path.join(os.path.dirname(os.path.abspath(__file__)), "payloads", "tg_getupdates.json")
+    with open(src) as f:
+        samples = [x for x in json.load(f)["result"] if "text" in x.get("message", {})]
+
+    def post(method, body=None, hdrs={}):
+        try:
+            c = http.client.HTTPConnection(u.hostname, u.port or 80, timeout=10)
+            c.request(method, path, body, hdrs)
+            code = c.getresponse().status
+            c.close()
+            return code
+        except OSError:
+            return 0
+
+    # The listener is serving once a GET is answered (405, POST only)
+    print("[webhook] waiting for the device's listener at %s ..." % opt.device, flush=True)
+    end = time.monotonic() + opt.timeout
+    while post("GET") != 405:
+        if time.monotonic() > end:
+            print("[webhook] no listener")
+            return 1
+        time.sleep(0.5)
+
+    codes, post_ms, t_in = {}, [], {}
+    t0 = time.monotonic()
+    for n in range(1, opt.messages + 1):
+        upd = json.loads(json.dumps(samples[(n - 1) % len(samples)]))
+        with st.lock:
+            upd["update_id"] = st.tg_next
+            st.tg_next += 1
+        upd["message"]["text"] = "m%d %s" % (n, upd["message"]["text"])
+        body = json.dumps(upd).encode()
+        hdrs = {"Content-Type": "application/json"}
+        if opt.secret:
+            hdrs["X-Telegram-Bot-Api-Secret-Token"] = opt.secret
+        t_in[n] = time.monotonic()
+        while True:
+            t = time.monotonic()
+            code = post("POST", body, hdrs)
+            post_ms.append((time.monotonic() - t) * 1000.0)
+            codes[code] = codes.get(code, 0) + 1
+            if code not in (0, 503) or time.monotonic() - t_in[n] > opt.timeout:
+                break
+            time.sleep(0.05)                         # Telegram backs off longer; keep the pressure on
+        if code in (401, 403):
+            break
+        if n < opt.messages and opt.rate > 0:
+            time.sleep(1.0 / opt.rate)
+    span = time.monotonic() - t0
+    ok = codes.get(200, 0)
+
+    deadline = time.monotonic() + opt.timeout
+    with st.lock:
+        while len(st.done) < ok and time.monotonic() < deadline:
+            st.lock.wait(1.0)
+        done = dict(st.done)
+    reply = [(done[n] - t_in[n]) * 1000.0 for n in t_in if n in done]
+
+    s, r = _stats(post_ms), _stats(reply)
+    print("\npushed %d updates in %.2f s : %.1f updates/s accepted" % (ok, span, ok / span if span else 0.0))
+    print("responses: " + ", ".join("%s=%d" % (k or "error", v) for k, v in sorted(codes.items())))
+    print("post  p50 %.0fms  p90 %.0fms  p99 %.0fms  max %.0fms" % (s["p50"], s["p90"], s["p99"], s["max"]))
+    print("reply p50 %.0fms  p90 %.0fms  p99 %.0fms  max %.0fms  (%d of %d)" %
+          (r["p50"], r["p90"], r["p99"], r["max"], r["n"], ok))
+    print("requests: " + ", ".join("%s=%d" % kv for kv in sorted(st.counts.items())))
+    if opt.json:
+        with open(opt.json, "w") as f:
+            json.dump({"messages": opt.messages, "rate": opt.rate, "accepted": ok, "span_s": span,
+                       "updates_per_s": ok / span if span else 0.0, "codes": codes,
+                       "post": s, "reply": r, "counts": dict(st.counts)}, f, indent=1)
+        print("results: " + opt.json)
+    return 0 if ok == opt.messages and r["n"] == ok else 1
+
+
+def main():
+    ap = argparse.ArgumentParser(description="FemtoClaw mock upstream + load driver")
+    ap.add_argument("mode", choices=("serve", "load", "gateway", "webhook"))
+    ap.add_argument("--bind", default="0.0.0.0")
+    ap.add_argument("--port", type=int, default=8081)
+    ap.add_argument("--latency", type=int, default=0, help="ms before each response")
+    ap.add_argument("--token-ms", type=int, default=30, help="ms per streamed piece (generation time)")
+    ap.add_argument("--reply-words", type=int, default=24, help="LLM reply length in words")
+    ap.add_argument("--chunk", type=int, default=0, help="chunked bodies in N-byte pieces (0 = Content-Length)")
+    ap.add_argument("--rate-429", type=float, default=0.0, help="fraction of sends / edits answered 429")
+    ap.add_argument("--pad", type=int, default=0, help="extra bytes per update / message")
+    ap.add_argument("--verbose", action="store_true")
+    ap.add_argument("--messages", type=int, default=20, help="load / webhook: messages to inject")
+    ap.add_argument("--rate", type=float, default=0.5, help="load: messages per second")
+    ap.add_argument("--channel", choices=("tg", "dc", "both"), default="tg")
+    ap.add_argument("--prompt", default="turn on the lamp")
+    ap.add_argument("--timeout", type=float, default=120.0, help="load: seconds to wait for replies")
+    ap.add_argument("--json", help="load / webhook: write results here")
+    ap.add_argument("--device", default="http://127.0.0.1:8088/", help="webhook: the device's listener")
+    ap.add_argument("--secret", default="", help="webhook: X-Telegram-Bot-Api-Secret-Token")
+    ap.add_argument("--hb-ms", type=int, default=5000, help="Gateway heartbeat_interval")
+    ap.add_argument("--no-gateway", action="store_true", help="refuse WebSocket upgrades (REST only)")
+    opt = ap.parse_args()
+
+    st = State(opt)
+    Handler.st = st
+    srv = Server((opt.bind, opt.port), Handler)
+    threading.Thread(target=srv.serve_forever, daemon=True).start()
+    print("[mock] listening on %s:%d" % (opt.bind, opt.port), flush=True)
+    try:
+        if opt.mode == "load":
+            return run_load(st, opt)
+        if opt.mode == "gateway":
+            return run_gateway(st, opt)
+        if opt.mode == "webhook":
+            return run_webhook(st, opt)
+        while True:
+            time.sleep(3600)
+    except KeyboardInterrupt:
+        return 0
+    finally:
+        srv.shutdown()
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -16,6 +16,7 @@ Developed by : Al Mahmud Samiul
 """
 
 import sys, os, threading, time, subprocess, shutil, json, re, sysconfig, base64
+import queue, struct, zlib
 
 from PyQt6.QtCore import (Qt, QThread, pyqtSignal, QTimer, QObject, pyqtSlot)
 from PyQt6.QtGui import (QColor, QFont, QTextCursor, QTextCharFormat,
@@ -140,6 +141,39 @@ def strip_ansi(t: str) -> str:
     return re.sub(r'\033\[[0-9;]*m', '', t)
 
 
+# ── Binary board push framing (main/include/push.h) ──────────────────────────
+PUSH_ACK_TIMEOUT = 0.5    # s without ACK progress → resend the window
+PUSH_RETRIES     = 6
+PUSH_REPLY_RE    = re.compile(r"PUSH (?:READY|ACK|NAK|OK|ERR)\b.*"
+                              r"|Unknown: 'board push bin\b.*")      # firmware without the binary mode
+# Text push replies; builds older than the binary mode only print the [Board] lines.
+PUSH_TEXT_RE     = re.compile(r"PUSH (?:OK|ERR)\b.*|\[Board\] (?:Config accepted|ERROR:).*")
+PUSH_START_WAIT  = 5.0    # s for the answer to 'board push bin' (it may follow other output)
+PUSH_END_WAIT    = 5.0    # s for PUSH OK / ERR after 'board push end' (parse + flash write)
+
+
+def cobs_encode(data: bytes) -> bytes:
+    """Consistent Overhead Byte Stuffing: no 0x00 in the output."""
+    out = bytearray()
+    block = bytearray()
+    for b in data:
+        if b == 0:
+            out.append(len(block) + 1); out += block; block.clear()
+            continue
+        block.append(b)
+        if len(block) == 254:
+            out.append(255); out += block; block.clear()
+    out.append(len(block) + 1); out += block
+    return bytes(out)
+
+
+def push_frame(kind: bytes, seq: int, data: bytes = b"") -> bytes:
+    """type | seq u16 | data | crc32 u32, COBS-encoded and 0x00-terminated."""
+    body = kind + struct.pack("<H", seq) + data
+    body += struct.pack("<I", zlib.crc32(body) & 0xFFFFFFFF)
+    return cobs_encode(body) + b"\x00"
+
+
 WELCOME = r"""
   ███████╗███████╗███╗   ███╗████████╗ ██████╗  ██████╗██╗      █████╗ ██╗    ██╗
   ██╔════╝██╔════╝████╗ ████║╚══██╔══╝██╔═══██╗██╔════╝██║     ██╔══██╗██║    ██║
@@ -386,6 +420,9 @@ class SerialReader(QThread):
         self.signals = SerialSignals()
         self._ser = ser
         self._stop_event = threading.Event()
+        # Set by a binary board push: "PUSH ..." replies go here, not to the terminal.
+        self.push_q: queue.Queue | None = None
+        self.push_re: re.Pattern = PUSH_REPLY_RE
 
     def run(self):
         buf = b""
@@ -396,9 +433,14 @@ class SerialReader(QThread):
                     while b"\n" in buf:
                         line, buf = buf.split(b"\n", 1)
                         text = line.decode("utf-8", "replace").rstrip("\r").replace("\x00", "")
+                        q = self.push_q
+                        m = self.push_re.search(text) if q is not None else None
+                        if m:
+                            q.put(m.group(0))
+                            continue
                         self.signals.line_received.emit(text)
                 else:
-                    time.sleep(0.02)
+                    time.sleep(0.002 if self.push_q is not None else 0.02)
             except Exception:
                 break
 
@@ -1158,22 +1200,16 @@ class FemtoClawApp(QMainWindow):
 
         def _run():
             try:
-                b64 = base64.b64encode(md.encode("utf-8")).decode()
-                total_chunks = (len(b64) + 199) // 200
-                self._ser.write(b"board push begin\r\n")
-                time.sleep(0.08)
-                for ci, i in enumerate(range(0, len(b64), 200)):
-                    chunk = b64[i:i+200]
-                    self._ser.write(f"board push chunk {chunk}\r\n".encode())
-                    time.sleep(0.05)
-                    pct = int((ci + 1) / total_chunks * 90)
-                    sig.progress.emit(pct)                        # ← signal, not QTimer
-                time.sleep(0.05)
-                self._ser.write(b"board push end\r\n")
-                time.sleep(0.15)
-                ok_msg = f"✓ Pushed {len(md)} bytes ({total_chunks} chunks)"
+                data = md.encode("utf-8")
+                frames = self._board_push_bin(data, sig)
+                if frames is None:                                # firmware without 'board push bin'
+                    frames = self._board_push_b64(data, sig)
+                    how = "base64 chunks"
+                else:
+                    how = "frames, CRC32 verified"
+                ok_msg = f"✓ Pushed {len(data)} bytes ({frames} {how})"
                 sig.status.emit(
-                    f"[Board] CONTROL.md pushed ({len(md)} chars, {total_chunks} chunks)\n",
+                    f"[Board] CONTROL.md pushed ({len(data)} bytes, {frames} {how})\n",
                     "board")
                 sig.done.emit(True, ok_msg)
             except Exception as e:
@@ -1185,6 +1221,109 @@ class FemtoClawApp(QMainWindow):
         self._board_push_thread = threading.Thread(target=_run, daemon=True)
         self._board_push_thread.start()
 
+    def _board_push_bin(self, data: bytes, sig) -> int | None:
+        """
+        Framed binary push (push.h): COBS frames with sequence numbers and
+        CRC32, up to <window> in flight, go-back-N on NAK or ACK timeout.
+        Returns the frame count, or None when the firmware does not know
+        'board push bin' (older builds answer "Unknown: ..."). Raises on
+        any other failure, silence included: a board that is only slow to
+        answer must not get base64 lines while its binary push starts.
+        """
+        q: queue.Queue = queue.Queue()
+        self._reader.push_q = q
+        try:
+            crc = zlib.crc32(data) & 0xFFFFFFFF
+            self._ser.write(f"board push bin {len(data)} {crc:08x}\r\n".encode())
+            try:
+                line = q.get(timeout=PUSH_START_WAIT)
+            except queue.Empty:
+                self._ser.write(b"\x00" + push_frame(b"X", 0))   # in case it starts late
+                raise TimeoutError("no answer to 'board push bin'")
+            if line.startswith("Unknown:"):
+                return None
+            parts = line.split()
+            if parts[1] != "READY":
+                raise RuntimeError(f"board refused the push ({line})")
+            window, size = int(parts[2]), int(parts[3])
+            frames = [push_frame(b"D", i // size, data[i:i + size])
+                      for i in range(0, len(data), size)]
+
+            self._ser.write(b"\x00")                # ends the command line's '\n'
+            base = nxt = retries = 0
+            while True:
+                while nxt < len(frames) and nxt - base < window:
+                    self._ser.write(frames[nxt])
+                    nxt += 1
+                try:
+                    parts = q.get(timeout=PUSH_ACK_TIMEOUT).split()
+                except queue.Empty:
+                    parts = ["PUSH", "TIMEOUT"]
+                kind = parts[1]
+                if kind == "OK":
+                    sig.progress.emit(100)
+                    return len(frames)
+                if kind == "ERR":
+                    raise RuntimeError(f"board rejected the push ({' '.join(parts[2:])})")
+                if kind in ("ACK", "NAK") and int(parts[2]) > base:
+                    base = int(parts[2])                 # both acknowledge 0 … n-1
+                    retries = 0
+                    sig.progress.emit(int(base / len(frames) * 90))
+                elif kind != "ACK":
+                    retries += 1
+                    if retries > PUSH_RETRIES:
+                        self._ser.write(push_frame(b"X", 0))
+                        raise TimeoutError("no acknowledgement from the board")
+                if kind != "ACK":
+                    nxt = base                           # go back: resend from the first unacked
+        finally:
+            self._reader.push_q = None
+
+    def _board_push_b64(self, data: bytes, sig) -> int:
+        """
+        Text push for firmware without the binary mode: base64 lines, paced
+        by sleeps. Succeeds only on the board's PUSH OK; a PUSH ERR at any
+        point (busy, size, rejected ...) stops the push and raises.
+        """
+        q: queue.Queue = queue.Queue()
+        self._reader.push_re = PUSH_TEXT_RE
+        self._reader.push_q = q
+
+        def _check(timeout: float = 0.0) -> str | None:
+            try:
+                line = q.get(timeout=timeout) if timeout else q.get_nowait()
+            except queue.Empty:
+                return None
+            if line.startswith(("PUSH ERR", "[Board] ERROR:")):
+                raise RuntimeError(f"board rejected the push ({line})")
+            return line
+
+        try:
+            b64 = base64.b64encode(data).decode()
+            total_chunks = (len(b64) + 199) // 200
+            self._ser.write(b"board push begin\r\n")
+            time.sleep(0.08)
+            _check()
+            for ci, i in enumerate(range(0, len(b64), 200)):
+                chunk = b64[i:i+200]
+                self._ser.write(f"board push chunk {chunk}\r\n".encode())
+                time.sleep(0.05)
+                _check()
+                pct = int((ci + 1) / total_chunks * 90)
+                sig.progress.emit(pct)                    # ← signal, not QTimer
+            time.sleep(0.05)
+            self._ser.write(b"board push end\r\n")
+            deadline = time.monotonic() + PUSH_END_WAIT
+            while (left := deadline - time.monotonic()) > 0:
+                line = _check(left)
+                if line and line.startswith(("PUSH OK", "[Board] Config accepted")):
+                    sig.progress.emit(100)
+                    return total_chunks
+            raise TimeoutError("no PUSH OK after 'board push end'")
+        finally:
+            self._reader.push_q = None
+            self._reader.push_re = PUSH_REPLY_RE
+
     def _board_reset(self):
         if QMessageBox.question(
             self, "Board Reset",
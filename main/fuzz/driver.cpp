@@ -0,0 +1,213 @@
+/*
+ * ─────────────────────────────────────────────────────────────
+ * FemtoClaw : stand-alone driver for the fuzz targets.
+ *
+ * main() for a fuzz_<parser>.cpp when libFuzzer is not linked in (g++
+ * has no -fsanitize=fuzzer). Same calling convention, so one target
+ * source serves both:
+ *
+ *   program [-runs=N] [-seed=N] [-max_len=N] [-v] <dir | file> ...
+ *
+ * Every file named (directories: every file in them) runs once first,
+ * the regression pass. Then N mutated inputs (default 200000, 0 = replay
+ * only): bit flips, byte edits, protocol tokens, splices of two inputs.
+ * Built with -fsanitize-coverage=trace-pc, inputs that reach a new edge
+ * join the corpus, so later mutations start from them. The firmware log
+ * goes to /dev/null unless -v.
+ *
+ * A sanitizer report aborts the run; the input is written to
+ * crash-<exec> in the current directory first, to be replayed and, once
+ * fixed, added to fuzz/corpus/<parser>/ as regress-<what>.
+ * ─────────────────────────────────────────────────────────────
+ */
+
+#if !defined(FC_LIBFUZZER)
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+extern "C" void __sanitizer_set_death_callback(void (*cb)(void)) __attribute__((weak));
+
+// ─── Coverage ─────────────────────────────────────────────────────────────────
+// Edges as (previous pc, pc) pairs hashed into a bitmap, libFuzzer /
+// AFL style. Only counted while the target runs.
+static constexpr uint32_t COV_S = 1u << 16;
+
+static uint8_t   s_cov_all[COV_S];          // every edge seen so far
+static uint8_t   s_cov_run[COV_S];          // edges of the current input
+static uint32_t  s_cov_hit[COV_S];          // their indices, to clear them
+static uint32_t  s_cov_hit_n = 0;
+static uintptr_t s_cov_prev  = 0;
+static bool      s_cov_on    = false;
+static uint32_t  s_edges     = 0;
+
+extern "C" __attribute__((no_sanitize_coverage))
+void __sanitizer_cov_trace_pc() {
+  if (!s_cov_on) return;
+  uintptr_t pc = (uintptr_t)__builtin_return_address(0);
+  uint32_t  i  = (uint32_t)((pc ^ s_cov_prev) & (COV_S - 1));
+  s_cov_prev   = pc >> 1;
+  if (!s_cov_run[i]) { s_cov_run[i] = 1; s_cov_hit[s_cov_hit_n++] = i; }
+}
+
+// ─── Running one input ────────────────────────────────────────────────────────
+static const std::string *s_current = nullptr;
+static uint64_t           s_exec    = 0;
+
+static void _on_death() {
+  if (!s_current) return;
+  char name[40];
+  snprintf(name, sizeof(name), "crash-%llu", (unsigned long long)s_exec);
+  FILE *f = fopen(name, "wb");
+  if (f) { fwrite(s_current->data(), 1, s_current->size(), f); fclose(f); }
+  fprintf(stderr, "[Fuzz] input that failed written to %s\n", name);
+}
+
+// Runs the target; true when it reached an edge nothing else has.
+static bool _run(const std::string &in) {
+  s_current  = &in;
+  ++s_exec;
+  s_cov_prev = 0;
+  s_cov_on   = true;
+  LLVMFuzzerTestOneInput((const uint8_t *)in.data(), in.size());
+  s_cov_on   = false;
+  s_current  = nullptr;
+  bool fresh = false;
+  for (uint32_t k = 0; k < s_cov_hit_n; ++k) {
+    uint32_t i = s_cov_hit[k];
+    s_cov_run[i] = 0;
+    if (!s_cov_all[i]) { s_cov_all[i] = 1; ++s_edges; fresh = true; }
+  }
+  s_cov_hit_n = 0;
+  return fresh;
+}
+
+// ─── Mutation ─────────────────────────────────────────────────────────────────
+static const char *const k_tokens[] = {
+  "\"", "\\", "\\\"", "\\u00", "{", "}", "[", "]", ",", ":", "null", "true",
+  "\"id\"", "\"text\"", "\"content\"", "\"update_id\"", "\"message\"", "\"from\"",
+  "\"chat\"", "\"author\"", "\"bot\"", "\"channel_id\"", "\"op\"", "\"s\"", "\"t\"",
+  "\"d\"", "MESSAGE_CREATE", "READY", "RESUMED", "\"session_id\"",
+  "\"heartbeat_interval\"", "\r\n", "\n", "\r\n\r\n", "0\r\n\r\n", "HTTP/1.1 200 OK\r\n",
+  "Content-Length: ", "Transfer-Encoding: chunked\r\n", "Connection: close\r\n",
+  "Retry-After: ", "X-RateLimit-Remaining: ", "X-RateLimit-Reset-After: ", ";ext=1",
+  "ffffffff", "-1", "0", "1e300", "9223372036854775807", "-9223372036854775808",
+  "99999999999999999999", "## ", "| ", " |", "|---|---|", "GPIO", "Serial", "I2C",
+  "SPI", "Servo", "PWM", "ADC", "OUTPUT", "INPUT_PULLUP", "=", "==", "+/", "A",
+};
+
+static std::mt19937_64 s_rng;
+
+static size_t _pick(size_t n) { return n ? (size_t)(s_rng() % n) : 0; }
+
+static std::string _mutate(const std::vector<std::string> &corpus, size_t max_len) {
+  std::string s = corpus[_pick(corpus.size())];
+  for (int k = 1 + (int)_pick(6); k; --k) {
+    size_t at = _pick(s.size() + 1);
+    switch (_pick(9)) {
+    case 0: if (!s.empty()) s[_pick(s.size())] ^= (char)(1u << _pick(8)); break;
+    case 1: if (!s.empty()) s[_pick(s.size())] = (char)s_rng(); break;
+    case 2: s.insert(at, 1, (char)s_rng()); break;
+    case 3: if (at < s.size()) s.erase(at, 1 + _pick(s.size() - at < 16 ? s.size() - at : 16)); break;
+    case 4: s.insert(at, k_tokens[_pick(sizeof(k_tokens) / sizeof(k_tokens[0]))]); break;
+    case 5: {                                  // splice in a piece of another input
+      const std::string &o = corpus[_pick(corpus.size())];
+      size_t from = _pick(o.size());
+      s.insert(at, o, from, 1 + _pick(128));
+      break;
+    }
+    case 6: s.resize(at); break;
+    case 7: if (at < s.size()) s.insert(_pick(s.size() + 1), s.substr(at, 1 + _pick(32))); break;
+    case 8: if (!s.empty()) s[_pick(s.size())] = "0123456789"[_pick(10)]; break;
+    }
+  }
+  if (s.size() > max_len) s.resize(max_len);
+  return s;
+}
+
+// ─── Corpus ───────────────────────────────────────────────────────────────────
+static bool _slurp(const std::string &path, std::string &out) {
+  FILE *f = fopen(path.c_str(), "rb");
+  if (!f) return false;
+  char buf[4096];
+  size_t n;
+  out.clear();
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0) out.append(buf, n);
+  fclose(f);
+  return true;
+}
+
+static void _load(const char *path, std::vector<std::string> &corpus) {
+  struct stat st;
+  if (stat(path, &st) != 0) { fprintf(stderr, "[Fuzz] %s: not found\n", path); return; }
+  std::string data;
+  if (!S_ISDIR(st.st_mode)) {
+    if (_slurp(path, data)) corpus.push_back(data);
+    return;
+  }
+  DIR *d = opendir(path);
+  if (!d) return;
+  while (struct dirent *e = readdir(d)) {
+    if (e->d_name[0] == '.') continue;
+    std::string p = std::string(path) + "/" + e->d_name;
+    if (stat(p.c_str(), &st) == 0 && S_ISREG(st.st_mode) && _slurp(p, data))
+      corpus.push_back(data);
+  }
+  closedir(d);
+}
+
+int main(int argc, char **argv) {
+  uint64_t runs = 200000, seed = 1;
+  size_t   max_len = 4096;
+  bool     verbose = false;
+  std::vector<std::string> corpus;
+  for (int i = 1; i < argc; ++i) {
+    const char *a = argv[i];
+    if      (!strncmp(a, "-runs=", 6))    runs    = strtoull(a + 6, nullptr, 10);
+    else if (!strncmp(a, "-seed=", 6))    seed    = strtoull(a + 6, nullptr, 10);
+    else if (!strncmp(a, "-max_len=", 9)) max_len = strtoul(a + 9, nullptr, 10);
+    else if (!strcmp(a, "-v"))            verbose = true;
+    else                                  _load(a, corpus);
+  }
+  if (corpus.empty()) corpus.push_back(std::string());
+  s_rng.seed(seed);
+  if (__sanitizer_set_death_callback) __sanitizer_set_death_callback(_on_death);
+  if (!getenv("FC_NATIVE_DIR")) {              // board pushes save the config
+    static char dir[] = "/tmp/fc_fuzz_XXXXXX";
+    if (mkdtemp(dir)) setenv("FC_NATIVE_DIR", dir, 0);
+  }
+  if (!verbose) {
+    int null = open("/dev/null", O_WRONLY);
+    if (null >= 0) { dup2(null, 1); close(null); }
+  }
+
+  size_t seeds = corpus.size();
+  for (size_t i = 0; i < seeds; ++i) _run(corpus[i]);
+  fprintf(stderr, "[Fuzz] %zu inputs replayed, %u edges\n", seeds, (unsigned)s_edges);
+
+  auto t0 = std::chrono::steady_clock::now();
+  for (uint64_t r = 0; r < runs; ++r) {
+    std::string in = _mutate(corpus, max_len);
+    if (_run(in)) corpus.push_back(in);
+  }
+  double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+  if (runs)
+    fprintf(stderr, "[Fuzz] %llu execs in %.1f s = %.0f execs/s, %u edges, corpus %zu -> %zu\n",
+            (unsigned long long)runs, sec, sec > 0 ? runs / sec : 0.0,
+            (unsigned)s_edges, seeds, corpus.size());
+  return 0;
+}
+
+#endif  // !FC_LIBFUZZER
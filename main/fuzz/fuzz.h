@@ -0,0 +1,86 @@
+/*
+ * ─────────────────────────────────────────────────────────────
+ * FemtoClaw : shared pieces of the parser fuzz targets.
+ *
+ * Every fuzz_<parser>.cpp is one LLVMFuzzerTestOneInput() over the
+ * firmware headers on the native shim, built by its own
+ * [env:native_fuzz_<parser>] (see README "Fuzzing"). Under clang with
+ * -fsanitize=fuzzer libFuzzer drives it; otherwise driver.cpp supplies
+ * main(): replay of the corpus, then coverage-guided mutation.
+ * ─────────────────────────────────────────────────────────────
+ */
+
+#pragma once
+
+#include "platform.h"
+#include "constants.h"
+#include "config.h"
+#include "board_parser.h"
+#include "json.h"
+#include "arena.h"
+#include "mcu_wifi.h"
+#include "persist.h"
+#include "spsc.h"
+#include "hist.h"
+#include "mem.h"
+#include "http.h"
+#include "scheduler.h"
+#include "llm.h"
+#include "actions.h"
+#include "agent.h"
+#include "msgq.h"
+#include "telegram.h"
+#include "webhook.h"
+#include "discord.h"
+#include "discord_gw.h"
+#include "live.h"
+#include "heartbeat.h"
+#include "push.h"
+#include "shell.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+// The input as a C string in a heap block of exactly size + 1 bytes, so
+// ASan flags the first byte read past the terminator. free() it.
+static char *fuzz_cstr(const uint8_t *data, size_t size) {
+  char *s = (char *)malloc(size + 1);
+  memcpy(s, data, size);
+  s[size] = '\0';
+  return s;
+}
+
+// Whatever the parsers queued: the next input starts on an empty inbox.
+static void fuzz_drain_inbox() {
+  InMsg m;
+  while (g_inbox.pop(m)) {}
+}
+
+// A socket that serves the input, at most `piece` bytes per available(),
+// so reads split the way a slow network would. Writes are dropped; once
+// the input is used up the peer has closed.
+class FuzzClient : public WiFiClient {
+  const uint8_t *_p = nullptr;
+  size_t         _n = 0, _at = 0, _piece = 1;
+public:
+  void load(const uint8_t *p, size_t n, size_t piece) {
+    _p = p; _n = n; _at = 0; _piece = piece ? piece : 1;
+  }
+  int     connect(const char *, uint16_t) override { return 0; }
+  uint8_t connected() override { return _at < _n; }
+  void    stop() override { _at = _n; }
+  int available() override {
+    size_t k = _n - _at;
+    return (int)(k < _piece ? k : _piece);
+  }
+  int read() override { return _at < _n ? _p[_at++] : -1; }
+  int read(uint8_t *buf, size_t n) override {
+    size_t k = (size_t)available();
+    if (n > k) n = k;
+    memcpy(buf, _p + _at, n);
+    _at += n;
+    return (int)n;
+  }
+  size_t write(const uint8_t *, size_t n) override { return n; }
+  using Print::write;
+};
@@ -0,0 +1,67 @@
+/*
+ * ─────────────────────────────────────────────────────────────
+ * FemtoClaw : fuzz target for the action executor (actions.h).
+ *
+ * The input is an LLM reply for execute_actions_in_response(): prose
+ * with [ACTION:...] tags, their key=value / quoted arguments, pin lists
+ * and I2C step lists, against bench/payloads/control_home.md minus its
+ * UARTs (a serial_read on a declared port waits up to 150 ms for data).
+ * Then strip_action_tags() on the same text, as the agent does.
+ * delay_ms tags are renamed first, so a mutation cannot park the run
+ * for five seconds; the executor still parses them as unknown actions.
+ * ─────────────────────────────────────────────────────────────
+ */
+
+#include "fuzz.h"
+
+static const char k_board[] =
+  "## GPIO Pins\n"
+  "| Pin | Mode | Name | Logic |\n"
+  "|-----|------|------|-------|\n"
+  "| 2 | OUTPUT | led_builtin | |\n"
+  "| 5 | OUTPUT | relay_lamp | inverted |\n"
+  "| 6 | OUTPUT | relay_fan | inverted |\n"
+  "| 4 | INPUT | pir_motion | |\n"
+  "## ADC Pins\n"
+  "| Pin | Name |\n"
+  "|-----|------|\n"
+  "| 0 | ldr |\n"
+  "## I2C Buses\n"
+  "| Bus | SDA | SCL | Address | Name |\n"
+  "|-----|-----|-----|---------|------|\n"
+  "| 0 | 21 | 22 | 0x3C | oled |\n"
+  "| 0 | 21 | 22 | 0x68 | mpu |\n"
+  "## Servos\n"
+  "| Pin | Name | Min | Max | Step | Delay |\n"
+  "|-----|------|-----|-----|------|-------|\n"
+  "| 13 | pan | 0 | 180 | 1 | 15 |\n"
+  "## PWM Outputs\n"
+  "| Pin | Name | Freq | Resolution |\n"
+  "|-----|------|------|------------|\n"
+  "| 25 | fan | 25000 | 8 |\n";
+
+static SimI2cDevice s_mpu;
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+  static bool s_up = false;
+  if (!s_up) {
+    static char md[sizeof(k_board)];
+    memcpy(md, k_board, sizeof(k_board));
+    s_mpu.addr = 0x68;
+    Wire.sim_attach(&s_mpu);
+    if (!board_parse_md(md)) abort();
+    board_init_hardware();
+    board_init_peripherals();
+    s_up = true;
+  }
+  Wire.sim_log().clear();
+  char *buf = fuzz_cstr(data, size);
+  for (char *d = buf; (d = strstr(d, "delay_ms")) != nullptr; d += 8) d[7] = 'X';
+
+  char results[512];                        // the agent's g_action_results
+  execute_actions_in_response(buf, results, sizeof(results));
+  if (strlen(results) >= sizeof(results)) abort();
+  strip_action_tags(buf);
+  free(buf);
+  return 0;
+}
@@ -0,0 +1,23 @@
+/*
+ * ─────────────────────────────────────────────────────────────
+ * FemtoClaw : fuzz target for the board markdown parser (board_parser.h).
+ *
+ * The input is a [CONTROL].md for board_parse_md(): section headings,
+ * pin tables, names and pin numbers as a user or a corrupted push would
+ * write them. For an accepted config every GPIO name is looked up again
+ * through the name index, as actions resolve them.
+ * ─────────────────────────────────────────────────────────────
+ */
+
+#include "fuzz.h"
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+  if (size >= BOARD_MD_S) return 0;          // a push never gets further
+  char *buf = fuzz_cstr(data, size);
+  if (board_parse_md(buf)) {
+    for (uint8_t i = 0; i < g_board_pin_count; ++i)
+      if (board_resolve_pin(g_board_pins[i].name) != g_board_pins[i].pin) abort();
+  }
+  free(buf);
+  return 0;
+}
@@ -0,0 +1,28 @@
+/*
+ * ─────────────────────────────────────────────────────────────
+ * FemtoClaw : fuzz target for the Discord REST message list (discord.h).
+ *
+ * The input is a GET channels/{id}/messages response for _dc_parse(),
+ * which walks it with _dc_entry() and pulls each message's id, author
+ * id and content. Every input runs twice on one channel row: with no
+ * cursor (first poll, only the newest id is taken) and with a cursor
+ * below the ids in bench/payloads/dc_messages.json (messages queued).
+ * ─────────────────────────────────────────────────────────────
+ */
+
+#include "fuzz.h"
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+  char *buf = fuzz_cstr(data, size);
+  if (!g_cfg.dc_ch_count) dc_chan_add("1288012345678901234");
+  g_cfg.discord.allow_count = size & 1;
+  strlcpy(g_cfg.discord.allow_from[0], "402981234567891234", ALLOW_ID_LEN);
+
+  g_dc_cursor[0][0] = '\0';
+  _dc_parse(0, buf);
+  strlcpy(g_dc_cursor[0], "1428000000000000000", ALLOW_ID_LEN);
+  _dc_parse(0, buf);
+  fuzz_drain_inbox();
+  free(buf);
+  return 0;
+}
@@ -0,0 +1,41 @@
+/*
+ * ─────────────────────────────────────────────────────────────
+ * FemtoClaw : fuzz target for the Discord Gateway receiver (discord_gw.h).
+ *
+ * The input is first one Gateway event for _dcg_dispatch() (Hello,
+ * READY, MESSAGE_CREATE, ...), then the same bytes as the raw socket
+ * stream of an open connection for _dcg_read(): WebSocket frame
+ * headers, fragments, control frames, oversized messages, each
+ * finished text message dispatched again. Replies (identify, beats,
+ * pongs) go to a FuzzClient and are dropped.
+ * ─────────────────────────────────────────────────────────────
+ */
+
+#include "fuzz.h"
+
+static FuzzClient s_cli;
+
+static void _open(DcGateway &g) {
+  memset(static_cast<void *>(&g), 0, sizeof(g));
+  _dcg_forget(g);
+  g.cli    = &s_cli;
+  g.state  = DCG_OPEN;
+  g.in_hdr = true;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+  DcGateway &g = g_dcg;
+  g_cfg.dc_ch_count = 0;                     // listening everywhere
+
+  char *buf = fuzz_cstr(data, size);
+  _open(g);
+  s_cli.load(data, 0, 1);
+  _dcg_dispatch(g, buf, 0);
+  free(buf);
+
+  _open(g);
+  s_cli.load(data, size, 1 + size % 509);
+  for (uint32_t now = 0; g.state == DCG_OPEN && s_cli.available(); ++now) _dcg_read(g, now);
+  fuzz_drain_inbox();
+  return 0;
+}
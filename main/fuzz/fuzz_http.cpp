@@ -0,0 +1,42 @@
+/*
+ * ─────────────────────────────────────────────────────────────
+ * FemtoClaw : fuzz target for the HTTP response reader (http.h).
+ *
+ * The input is what the server sends back: status line, headers, body.
+ * It goes through the real http_job_step() twice on a FuzzClient, read
+ * in pieces of varying size: once into an out buffer (Content-Length /
+ * chunk terminator detection, unchunk at the end), once through a sink
+ * (the streaming chunked decoder the LLM calls use). Header lines hit
+ * _http_header() and _http_secs_ms() on the way.
+ * ─────────────────────────────────────────────────────────────
+ */
+
+#include "fuzz.h"
+
+static FuzzClient s_cli;
+static HttpJob    s_job;
+static uint32_t   s_sunk;
+
+static void _sink(HttpJob &, const char *p, uint16_t n) {
+  for (uint16_t i = 0; i < n; ++i) s_sunk += (uint8_t)p[i];
+}
+
+static void _fetch(const uint8_t *data, size_t size, size_t piece,
+                   char *out, uint16_t cap, HttpSink sink) {
+  s_cli.load(data, size, piece);
+  // keep + a connected client: reused, so no settle delay and no connect
+  http_job_begin(s_job, s_cli, false, "fuzz", 80, "/", nullptr,
+                 nullptr, 0, out, cap, true);
+  s_job.sink = sink;
+  for (uint32_t i = 0; i < 1000000 && !http_job_step(s_job); ++i) {}
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+  if (!size || size > 0xFFFF) return 0;     // empty: the job would reconnect
+  uint16_t cap = (uint16_t)(1 + size % 2048);
+  char *out = (char *)malloc(cap);          // exact size: ASan sees any overrun
+  _fetch(data, size, 1 + size % 97, out, cap, nullptr);
+  free(out);
+  _fetch(data, size, 1 + data[size - 1] % 300, nullptr, 0, _sink);
+  return 0;
+}
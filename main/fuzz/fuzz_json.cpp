@@ -0,0 +1,66 @@
+/*
+ * ─────────────────────────────────────────────────────────────
+ * FemtoClaw : fuzz target for the JSON helpers (json.h).
+ *
+ * jfind / jmember / jstr / jint / id_from_str over the input as a
+ * document, for the keys the channels look up; jstr with and without
+ * buf_end. Then a round trip: json_escape_into() of the input read
+ * back by jstr() must give the input again, and json_escape_in_place()
+ * must give the same bytes as json_escape_into(), cut to a budget too.
+ * ─────────────────────────────────────────────────────────────
+ */
+
+#include "fuzz.h"
+
+static const char *const k_keys[] = {
+  "id", "text", "content", "update_id", "channel_id", "op", "s", "t", "d",
+};
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+  if (size > 0x7FF0) return 0;            // escaped length must fit a uint16_t
+  char *buf = fuzz_cstr(data, size);
+  const char *end = buf + size;
+  char out[64], id[ALLOW_ID_LEN];
+
+  for (const char *k : k_keys) {
+    const char *v = jfind(buf, k);
+    if (v) {
+      jstr(v, out, sizeof(out));
+      jstr(v, out, sizeof(out), end);
+      jint(v);
+      id_from_str(v, id, sizeof(id));
+    }
+    const char *m = jmember(buf, k);
+    if (m) {
+      jstr(m, out, sizeof(out), end);
+      id_from_int64(jint(m), id, sizeof(id));
+      if ((m = jmember(m, k))) id_from_str(m, id, sizeof(id));
+    }
+  }
+
+  // escape → unescape gives back the text up to its first NUL
+  size_t n = strlen(buf);
+  uint16_t cap = (uint16_t)(2 * n + 8);
+  char *esc  = (char *)malloc(cap + 2u);
+  char *back = (char *)malloc(n + 1);
+  esc[0] = '"';
+  uint16_t w = json_escape_into(esc + 1, cap, buf);
+  esc[w + 1] = '"';
+  esc[w + 2] = '\0';
+  if (!jstr(esc, back, (uint16_t)(n + 1)) || strcmp(back, buf)) abort();
+
+  // in place: whole, then with a cap that cuts it short
+  char *inp = (char *)malloc(cap);
+  for (uint16_t c : {cap, (uint16_t)(w / 2 + 1)}) {
+    memcpy(inp, buf, n + 1);
+    uint16_t k   = json_escape_in_place(inp, (uint16_t)n, c);
+    uint16_t fit = json_escape_fit(buf, (uint16_t)n, c - 1);
+    if (k >= c || inp[k] || k > w || memcmp(inp, esc + 1, k)) abort();
+    if (json_escape_fit(buf, fit, k) != fit) abort();
+  }
+  free(inp);
+  free(back);
+  free(esc);
+  free(buf);
+  return 0;
+}
@@ -0,0 +1,41 @@
+/*
+ * ─────────────────────────────────────────────────────────────
+ * FemtoClaw : fuzz target for the LLM stream decoder (llm.h).
+ *
+ * The input is the (de-chunked) body of a "stream":true reply for
+ * _llm_sink(): server-sent event lines ("data: {...delta...}",
+ * keep-alives, [DONE]), or a plain JSON / error body kept raw. It is
+ * fed in pieces of varying size, as the HttpJob hands them over,
+ * into an out buffer of varying, exact size (ASan sees any overrun).
+ * One input in five runs as a non-200 reply, which is always raw.
+ * ─────────────────────────────────────────────────────────────
+ */
+
+#include "fuzz.h"
+
+static FuzzClient s_cli;
+static HttpJob    s_job;
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+  if (!size || size > 0xFFFF) return 0;
+  uint16_t cap = (uint16_t)(2 + size % HTTP_RESP_S);
+  char *out = (char *)malloc(cap);
+
+  s_cli.load(data, 0, 1);
+  http_job_begin(s_job, s_cli, false, "fuzz", 80, "/", nullptr,
+                 nullptr, 0, out, cap, true);
+  s_job.code = size % 5 ? 200 : 500;
+  memset(&s_llm_stream, 0, sizeof(s_llm_stream));
+  s_llm_stream.job = &s_job;
+
+  size_t piece = 1 + data[size - 1] % 300;
+  for (size_t at = 0; at < size; at += piece) {
+    size_t n = size - at < piece ? size - at : piece;
+    _llm_sink(s_job, (const char *)data + at, (uint16_t)n);
+    if (s_job.out_len >= cap) abort();
+    if (!s_llm_stream.raw && s_job.pub.load() != s_job.out_len) abort();
+  }
+  out[s_job.out_len] = '\0';                 // as _http_job_end() does
+  free(out);
+  return 0;
+}
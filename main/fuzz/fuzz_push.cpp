@@ -0,0 +1,118 @@
+/*
+ * ─────────────────────────────────────────────────────────────
+ * FemtoClaw : fuzz target for the board push receivers (push.h, http.h).
+ *
+ * One input, four ways in:
+ *   - base64_decode_feed() whole and split in two: same bytes out,
+ *     never more than out_cap
+ *   - each input line as 'board push chunk <line>' between 'board push
+ *     begin' and 'end' through shell_run(), the text push as typed
+ *   - the raw bytes to push_bin_byte() after 'board push bin': COBS
+ *     decoding, runts, overruns, bad CRCs, sequence gaps
+ *   - the input as the file of a well-formed binary push (frames COBS
+ *     encoded with their CRCs here, one of them sent twice), down to
+ *     board_push_apply() and the config save
+ * ─────────────────────────────────────────────────────────────
+ */
+
+#include "fuzz.h"
+
+#include <string>
+
+static void _b64(const uint8_t *data, size_t size) {
+  uint16_t cap = (uint16_t)(size * 3 / 4 + 1);
+  char *one = (char *)malloc(cap), *two = (char *)malloc(cap);
+  B64Dec d;
+  base64_dec_init(d);
+  uint16_t n1 = base64_decode_feed(d, (const char *)data, (uint16_t)size, one, cap);
+  bool full = d.full;
+  size_t cut = size ? data[0] % (size + 1) : 0;
+  base64_dec_init(d);
+  uint16_t n2 = base64_decode_feed(d, (const char *)data, (uint16_t)cut, two, cap);
+  n2 += base64_decode_feed(d, (const char *)data + cut, (uint16_t)(size - cut), two + n2, cap - n2);
+  if (n1 > cap || (!full && !d.full && (n1 != n2 || memcmp(one, two, n1)))) abort();
+  free(one);
+  free(two);
+}
+
+static void _text_push(const uint8_t *data, size_t size) {
+  char line[CMD_S];
+  shell_run("board push begin");
+  size_t at = 0;
+  while (at < size) {
+    size_t n = 0;
+    while (at + n < size && data[at + n] != '\n' && n + 18 < sizeof(line)) ++n;
+    memcpy(line, "board push chunk ", 17);
+    memcpy(line + 17, data + at, n);
+    line[17 + n] = '\0';
+    if (!g_push_active) shell_run("board push begin");
+    shell_run(line);
+    at += n + 1;
+  }
+  if (g_push_active) shell_run("board push end");
+}
+
+static void _bin_begin(size_t len, uint32_t crc) {
+  char args[32];
+  snprintf(args, sizeof(args), "%lu %lx", (unsigned long)len, (unsigned long)crc);
+  push_bin_begin(args);
+}
+
+static void _bin_finish() {
+  if (g_pushb.on) _push_bin_end("fuzz");
+}
+
+// COBS: every zero becomes the distance to the next one.
+static void _cobs_frame(const uint8_t *p, size_t n) {
+  uint8_t out[PUSH_FRAME_S + PUSH_FRAME_S / 254 + 2];
+  size_t  w = 1, code_at = 0;
+  uint8_t code = 1;
+  for (size_t i = 0; i < n; ++i) {
+    if (p[i]) { out[w++] = p[i]; ++code; }
+    if (!p[i] || code == 0xFF) {
+      out[code_at] = code;
+      code_at = w++;
+      code = 1;
+    }
+  }
+  out[code_at] = code;
+  push_bin_byte(0);
+  for (size_t i = 0; i < w; ++i) push_bin_byte(out[i]);
+  push_bin_byte(0);
+}
+
+static void _bin_send(const uint8_t *file, size_t len, uint16_t seq) {
+  uint8_t f[PUSH_FRAME_S];
+  size_t  at = (size_t)seq * PUSH_FRAME_DATA;
+  size_t  n  = len - at < PUSH_FRAME_DATA ? len - at : PUSH_FRAME_DATA;
+  f[0] = 'D';
+  f[1] = (uint8_t)seq;
+  f[2] = (uint8_t)(seq >> 8);
+  memcpy(f + PUSH_HDR_S, file + at, n);
+  uint32_t crc = crc32_update(0, f, (uint16_t)(PUSH_HDR_S + n));
+  memcpy(f + PUSH_HDR_S + n, &crc, 4);
+  _cobs_frame(f, PUSH_HDR_S + n + 4);
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+  if (size > 0xFFFF) return 0;
+  _b64(data, size);
+  _text_push(data, size);
+
+  _bin_begin(BOARD_MD_S - 1, 0);
+  for (size_t i = 0; i < size; ++i) push_bin_byte(data[i]);
+  push_bin_idle();
+  _bin_finish();
+
+  if (!size || size >= BOARD_MD_S) return 0;
+  _bin_begin(size, crc32_update(0, data, (uint16_t)size));
+  uint16_t frames = (uint16_t)((size + PUSH_FRAME_DATA - 1) / PUSH_FRAME_DATA);
+  uint16_t dup    = (uint16_t)(size % frames);
+  for (uint16_t s = 0; s < frames && g_pushb.on; ++s) {
+    _bin_send(data, size, s);
+    if (s == dup && g_pushb.on) _bin_send(data, size, s);
+  }
+  push_bin_idle();
+  _bin_finish();
+  return 0;
+}
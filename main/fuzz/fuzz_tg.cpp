@@ -0,0 +1,24 @@
+/*
+ * ─────────────────────────────────────────────────────────────
+ * FemtoClaw : fuzz target for the Telegram update parser (telegram.h).
+ *
+ * The input is a getUpdates response (or one webhook update) for
+ * _tg_parse(), from offset 0. Odd-sized inputs run against an allow
+ * list holding the sender of bench/payloads/tg_getupdates.json, so
+ * the BLOCKED path is covered too. No flash writes (save_offset off).
+ * ─────────────────────────────────────────────────────────────
+ */
+
+#include "fuzz.h"
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+  char *buf = fuzz_cstr(data, size);
+  ChannelCfg &tg = g_cfg.telegram;
+  tg.allow_count = size & 1;
+  strlcpy(tg.allow_from[0], "5123456789", ALLOW_ID_LEN);
+  g_tg_offset = 0;
+  _tg_parse(buf, false);
+  fuzz_drain_inbox();
+  free(buf);
+  return 0;
+}
@@ -57,6 +57,14 @@
 // ── Static peripheral pools ───────────────────────────────────────────────────
 #if defined(BOARD_HAS_SERVO)
 static Servo s_servos[MAX_BOARD_SERVOS];
+
+// Sweep state for servos with Step > 1, advanced by servo_motion_task().
+struct ServoSweep {
+    int16_t  pos;
+    int16_t  target;
+    uint32_t next_ms;
+};
+static ServoSweep s_sweep[MAX_BOARD_SERVOS];
 #endif
 
 #if defined(BOARD_HAS_OLED_SSD1306)
@@ -81,6 +89,250 @@ static Adafruit_ILI9341 *s_tft_ili[MAX_BOARD_SPI] = {nullptr};
 static Adafruit_ST7789 *s_tft_st7[MAX_BOARD_SPI] = {nullptr};
 #endif
 
+// ── I2C transactions + bus-scan cache ─────────────────────────────────────────
+/*
+ * Every I2C action is compiled into a short list of steps (write N bytes /
+ * read N bytes) and run back-to-back on the bus. This lets the LLM read a
+ * whole sensor block (e.g. 14 bytes of accel+gyro) in one action instead of
+ * one tool round-trip per register.
+ *
+ * The only repeated START is write → read (set the register pointer, then
+ * read from it); every other step ends in STOP. That is all arduino-esp32
+ * 2.x can put on the wire: endTransmission(false) just parks the bytes for
+ * the next requestFrom(), a beginTransmission() in between discards them,
+ * and a read always ends in STOP. Writes are not merged either: a second
+ * write restarts the device's register pointer, so "w:0x6B,0x00;w:0x3B"
+ * is two register writes, not one 3-byte burst into 0x6B..0x6D.
+ *
+ * The scan cache holds one bit per 7-bit address per bus, filled right after
+ * Wire.begin(). Actions to an address that did not ACK at boot fail at once
+ * with error=no_device instead of waiting for a NACK timeout. 'i2c scan' in
+ * the shell refreshes it after hot-plugging a device.
+ */
+static constexpr uint8_t I2C_BURST_MAX = 32;   // max bytes per read / per write
+static constexpr uint8_t I2C_MAX_STEPS = 8;
+
+struct I2cStep {
+    bool    rd;      // true = read len bytes, false = write len bytes from off
+    uint8_t len;
+    uint8_t off;     // offset into the caller's write buffer
+};
+
+static uint32_t s_i2c_seen[2][4]  = {};
+static bool     s_i2c_scanned[2]  = {false, false};
+
+static inline TwoWire &i2c_wire(uint8_t bus) { return (bus == 0) ? Wire : Wire1; }
+
+// Unscanned buses never block : the cache is only a fast-fail hint.
+static inline bool i2c_present(uint8_t bus, uint8_t addr) {
+    if (bus > 1) bus = 1;
+    if (!s_i2c_scanned[bus] || addr > 0x7F) return true;
+    return (s_i2c_seen[bus][addr >> 5] >> (addr & 31)) & 1u;
+}
+
+static uint8_t i2c_scan_bus(uint8_t bus) {
+    if (bus > 1) bus = 1;
+    TwoWire &w = i2c_wire(bus);
+    memset(s_i2c_seen[bus], 0, sizeof(s_i2c_seen[bus]));
+    uint8_t found = 0;
+    for (uint8_t a = 0x08; a < 0x78; ++a) {        // skip reserved ranges
+        w.beginTransmission(a);
+        if (w.endTransmission() == 0) {
+            s_i2c_seen[bus][a >> 5] |= 1UL << (a & 31);
+            ++found;
+        }
+    }
+    s_i2c_scanned[bus] = true;
+
+    Serial.printf("[Board] I2C%u  scan: %u device(s)", bus, found);
+    for (uint8_t a = 0x08; a < 0x78; ++a)
+        if (i2c_present(bus, a)) Serial.printf(" 0x%02X", a);
+    Serial.print("\r\n");
+    return found;
+}
+
+/*
+ * Parse "0x3B,0x00,12" into out[]. Values use strtol base 0 like the
+ * single-byte reg/data parameters always have. Returns the byte count,
+ * or -1 on a bad token / more than cap bytes.
+ */
+static int i2c_parse_bytes(const char *s, uint8_t *out, uint8_t cap) {
+    int n = 0;
+    while (*s) {
+        char *end;
+        long v = strtol(s, &end, 0);
+        if (end == s || v < 0 || v > 0xFF || n >= cap) return -1;
+        out[n++] = (uint8_t)v;
+        s = end;
+        if (*s == ',') ++s;
+        else if (*s) return -1;
+    }
+    return n;
+}
+
+/*
+ * Run steps in order: a write followed by a read keeps the bus (repeated
+ * START), everything else ends in STOP. Read data is appended to hex as
+ * uppercase pairs. Returns the Wire error code of the failing step (0 = ok);
+ * a read that returns no bytes counts as an address NACK (2).
+ */
+static uint8_t i2c_run(uint8_t bus, uint8_t addr,
+                       const I2cStep *steps, uint8_t nsteps,
+                       const uint8_t *wbuf, char *hex, size_t hex_cap) {
+    TwoWire &w = i2c_wire(bus);
+    size_t hw = 0;
+    hex[0] = '\0';
+    for (uint8_t i = 0; i < nsteps; ++i) {
+        const I2cStep &st = steps[i];
+        if (!st.rd) {
+            bool stop = (i + 1 == nsteps) || !steps[i + 1].rd;
+            w.beginTransmission(addr);
+            w.write(wbuf + st.off, st.len);
+            uint8_t err = w.endTransmission(stop);
+            if (err) return err;
+        } else {
+            uint8_t got = w.requestFrom(addr, st.len, (uint8_t)true);
+            if (!got) return 2;
+            for (uint8_t k = 0; k < got; ++k) {
+                uint8_t b = (uint8_t)w.read();
+                if (hw + 3 <= hex_cap) hw += snprintf(hex + hw, hex_cap - hw, "%02X", b);
+            }
+        }
+    }
+    return 0;
+}
+
+/*
+ * Compile a sequence string into steps:  "w:0x6B,0x00;w:0x3B;r:14"
+ * Steps are separated by ';'. Reads are capped at I2C_BURST_MAX bytes in
+ * total so the hex result always fits in one [RESULT:...] line.
+ */
+static int i2c_parse_seq(char *seq, I2cStep *steps, uint8_t *wbuf) {
+    uint8_t n = 0, wpos = 0, rtotal = 0;
+    char *save = nullptr;
+    for (char *tok = strtok_r(seq, ";", &save); tok; tok = strtok_r(nullptr, ";", &save)) {
+        if (n >= I2C_MAX_STEPS || (tok[0] != 'w' && tok[0] != 'r') || tok[1] != ':')
+            return -1;
+        I2cStep &st = steps[n];
+        st.rd  = (tok[0] == 'r');
+        st.off = wpos;
+        if (st.rd) {
+            char *end;
+            long len = strtol(tok + 2, &end, 0);
+            if (*end || len <= 0 || rtotal + len > I2C_BURST_MAX) return -1;
+            st.len  = (uint8_t)len;
+            rtotal += (uint8_t)len;
+        } else {
+            int len = i2c_parse_bytes(tok + 2, wbuf + wpos, I2C_BURST_MAX - wpos);
+            if (len <= 0) return -1;
+            st.len = (uint8_t)len;
+            wpos  += (uint8_t)len;
+        }
+        ++n;
+    }
+    return n;
+}
+
+// ── Display manager ───────────────────────────────────────────────────────────
+/*
+ * Display actions draw into the panel and only mark what they touched; the
+ * actual transfer happens once in disp_flush_all() at the end of
+ * execute_actions_in_response(), so five oled_print tags in one LLM reply
+ * cost one flush instead of five full-frame pushes.
+ *
+ * SSD1306: dirty state is a column range per 8-pixel page. The flush sets
+ * the controller's column/page window and sends only those bytes, a single
+ * line of text is ~128 bytes instead of the whole 1 KB framebuffer.
+ *
+ * TFTs have no framebuffer on the MCU side (150 KB would not fit), so they
+ * keep drawing directly; display_text clears only its own line bands
+ * instead of the whole screen.
+ */
+static constexpr uint16_t DISP_BG_BLACK = 0x0000;
+static constexpr uint16_t DISP_FG_WHITE = 0xFFFF;
+
+#if defined(BOARD_HAS_OLED_SSD1306)
+static constexpr uint8_t OLED_PAGES = OLED_H / 8;
+
+struct OledDirty {
+    uint8_t col0[OLED_PAGES];    // first dirty column per page
+    uint8_t col1[OLED_PAGES];    // last dirty column per page (< col0 = clean)
+};
+static OledDirty s_oled_dirty[MAX_BOARD_I2C];
+
+static void disp_oled_clean(uint8_t i) {
+    memset(s_oled_dirty[i].col0, 0xFF, OLED_PAGES);
+    memset(s_oled_dirty[i].col1, 0x00, OLED_PAGES);
+}
+
+// Mark an on-screen rectangle dirty (clipped to the panel).
+static void disp_oled_mark(uint8_t i, int16_t x, int16_t y, int16_t w, int16_t h) {
+    if (w <= 0 || h <= 0) return;
+    int16_t x1 = x + w - 1, y1 = y + h - 1;
+    if (x < 0) x = 0;
+    if (y < 0) y = 0;
+    if (x1 >= OLED_W) x1 = OLED_W - 1;
+    if (y1 >= OLED_H) y1 = OLED_H - 1;
+    if (x > x1 || y > y1) return;
+    OledDirty &d = s_oled_dirty[i];
+    for (uint8_t pg = (uint8_t)(y / 8); pg <= (uint8_t)(y1 / 8); ++pg) {
+        if (d.col0[pg] > d.col1[pg]) { d.col0[pg] = (uint8_t)x; d.col1[pg] = (uint8_t)x1; continue; }
+        if (x  < d.col0[pg]) d.col0[pg] = (uint8_t)x;
+        if (x1 > d.col1[pg]) d.col1[pg] = (uint8_t)x1;
+    }
+}
+
+static void disp_oled_flush(uint8_t i) {
+    const BoardI2C &bi = g_board_i2c[i];
+    TwoWire &w   = i2c_wire(bi.bus);
+    uint8_t addr = bi.addr ? bi.addr : 0x3C;
+    const uint8_t *fb = s_oled[i].getBuffer();
+    OledDirty &d = s_oled_dirty[i];
+
+    for (uint8_t pg = 0; pg < OLED_PAGES; ++pg) {
+        if (d.col0[pg] > d.col1[pg]) continue;
+        // Column window + page window (horizontal addressing, set by begin()).
+        w.beginTransmission(addr);
+        w.write((uint8_t)0x00);                       // command stream
+        w.write((uint8_t)0x21); w.write(d.col0[pg]); w.write(d.col1[pg]);
+        w.write((uint8_t)0x22); w.write(pg);         w.write(pg);
+        w.endTransmission();
+
+        // Data in 31-byte chunks: fits every core's Wire TX buffer.
+        const uint8_t *src = fb + (uint16_t)pg * OLED_W + d.col0[pg];
+        uint8_t left = (uint8_t)(d.col1[pg] - d.col0[pg] + 1);
+        while (left) {
+            uint8_t n = left > 31 ? 31 : left;
+            w.beginTransmission(addr);
+            w.write((uint8_t)0x40);                   // data stream
+            w.write(src, n);
+            w.endTransmission();
+            src += n; left -= n;
+        }
+    }
+    disp_oled_clean(i);
+}
+#endif
+
+#if defined(BOARD_HAS_TFT_ILI9341) || defined(BOARD_HAS_TFT_ST7789)
+static Adafruit_GFX *disp_tft(int bi) {
+    if (bi < 0 || bi >= MAX_BOARD_SPI) return nullptr;
+#if defined(BOARD_HAS_TFT_ILI9341)
+    return s_tft_ili[bi];
+#else
+    return s_tft_st7[bi];
+#endif
+}
+#endif
+
+// Push every pending OLED region. Cheap no-op when nothing is dirty.
+static void disp_flush_all() {
+#if defined(BOARD_HAS_OLED_SSD1306)
+    for (uint8_t i = 0; i < MAX_BOARD_I2C; ++i)
+        if (s_oled_ok[i]) disp_oled_flush(i);
+#endif
+}
+
 // ─── board_init_peripherals ───────────────────────────────────────────────────
 /*
  * Initialise Wire, Servo, LEDC, and display libraries using the parsed
@@ -99,6 +351,7 @@ static void board_init_peripherals() {
     // Multiple I2C entries may share the same bus, only call begin() once
     // per bus and use the FIRST entry's SDA/SCL for that bus.
     bool wire_begun[2]  = {false, false};
+    s_i2c_scanned[0] = s_i2c_scanned[1] = false;
     for (uint8_t i = 0; i < g_board_i2c_count; ++i) {
         const BoardI2C &bi = g_board_i2c[i];
         uint8_t b = (bi.bus > 1) ? 1 : bi.bus;
@@ -112,15 +365,20 @@ static void board_init_peripherals() {
             wire_begun[b] = true;
             Serial.printf("[Board] I2C%u  bus begun  SDA=GP%-2u  SCL=GP%-2u\r\n",
                           b, bi.sda, bi.scl);
+            i2c_scan_bus(b);
         }
+        if (bi.addr && !i2c_present(b, bi.addr))
+            Serial.printf("[Board] WARNING: I2C '%s'  addr=0x%02X  did not respond\r\n",
+                          bi.name, bi.addr);
 
         // ── SSD1306 OLED init ─────────────────────────────────────────
 #if defined(BOARD_HAS_OLED_SSD1306)
         if (i < MAX_BOARD_I2C) {
             uint8_t addr = bi.addr ? bi.addr : 0x3C;
-            if (s_oled[i].begin(SSD1306_SWITCHCAPVCC, addr)) {
+            if (i2c_present(b, addr) && s_oled[i].begin(SSD1306_SWITCHCAPVCC, addr)) {
                 s_oled[i].clearDisplay();
                 s_oled[i].display();
+                disp_oled_clean(i);
                 s_oled_ok[i] = true;
                 Serial.printf("[Board] OLED '%s'  addr=0x%02X  ok\r\n", bi.name, addr);
             } else {
@@ -160,6 +418,7 @@ static void board_init_peripherals() {
     for (uint8_t i = 0; i < g_board_servo_count; ++i) {
         s_servos[i].attach(g_board_servos[i].pin, 544, 2400);
         s_servos[i].write(g_board_servos[i].min_angle);
+        s_sweep[i].pos = s_sweep[i].target = g_board_servos[i].min_angle;
         Serial.printf("[Board] Servo '%s'  pin=%-2u  range=%u-%u\r\n",
                       g_board_servos[i].name, g_board_servos[i].pin,
                       g_board_servos[i].min_angle, g_board_servos[i].max_angle);
@@ -198,27 +457,55 @@ static void board_init_peripherals() {
 #endif
 }
 
+// ─── servo_motion_task ────────────────────────────────────────────────────────
+// Scheduler task (io): move each sweeping servo one Step every Step Delay,
+// so servo_set returns at once and the sweep runs alongside everything else.
+static void servo_motion_task() {
+#if defined(BOARD_HAS_SERVO)
+    uint32_t now = millis();
+    for (uint8_t i = 0; i < g_board_servo_count; ++i) {
+        ServoSweep &sw = s_sweep[i];
+        if (sw.pos == sw.target || (int32_t)(now - sw.next_ms) < 0) continue;
+        int16_t step = g_board_servos[i].servo_step;
+        if (sw.target > sw.pos) sw.pos = (sw.pos + step > sw.target) ? sw.target : sw.pos + step;
+        else                    sw.pos = (sw.pos - step < sw.target) ? sw.target : sw.pos - step;
+        s_servos[i].write(sw.pos);
+        sw.next_ms = now + g_board_servos[i].step_delay_ms;
+    }
+#endif
+}
+
 // ─── board_reset_peripherals ──────────────────────────────────────────────────
-// Detach servos and release PWM channels. Called from shell 'board reset'.
-static void board_reset_peripherals() {
+// Detach servos, release PWM channels and drop the I2C scan cache.
+// Called from shell 'board reset'; a board push releases the snapshot it
+// took of the old config (board_release_peripherals).
+static void board_release_peripherals(const BoardHwSnap &s) {
+    s_i2c_scanned[0] = s_i2c_scanned[1] = false;
+
 #if defined(BOARD_HAS_SERVO)
-    for (uint8_t i = 0; i < g_board_servo_count; ++i)
+    for (uint8_t i = 0; i < s.servo_count; ++i)
         if (s_servos[i].attached()) s_servos[i].detach();
 #endif
 
 #ifdef BOARD_ESP32
-    for (uint8_t i = 0; i < g_board_pwm_count; ++i) {
-        if (g_board_pwm[i].active) {
-            ledcWrite(g_board_pwm[i].channel, 0);
-            ledcDetachPin(g_board_pwm[i].pin);
+    for (uint8_t i = 0; i < s.pwm_count; ++i) {
+        if (s.pwm_active[i]) {
+            ledcWrite(s.pwm_channel[i], 0);
+            ledcDetachPin(s.pwm_pin[i]);
         }
     }
 #else
-    for (uint8_t i = 0; i < g_board_pwm_count; ++i)
-        if (g_board_pwm[i].active) analogWrite(g_board_pwm[i].pin, 0);
+    for (uint8_t i = 0; i < s.pwm_count; ++i)
+        if (s.pwm_active[i]) analogWrite(s.pwm_pin[i], 0);
 #endif
 }
 
+static void board_reset_peripherals() {
+    BoardHwSnap s;
+    board_hw_snapshot(s);
+    board_release_peripherals(s);
+}
+
 // ─── strip_action_tags ────────────────────────────────────────────────────────
 // Remove all [ACTION:...] substrings from buf in-place.
 static void strip_action_tags(char *buf) {
@@ -243,12 +530,55 @@ static void strip_action_tags(char *buf) {
  *   gpio_set   — silently refused for INPUT-mode pins
  *   adc_read   — only pins declared in ## ADC Pins
  *   delay_ms   — hard-capped at 5000 ms, with USB-CDC keepalive loop
- *   serial_*   — only declared ## Serial Ports
+ *   serial_*   — only declared ## Serial Ports; reads come from the RX ring
  *   servo_set  — angle clamped to declared min–max range
  *   pwm_set    — duty clamped to 0–255
+ *   i2c_*      — only declared ## I2C Buses; addresses absent from the
+ *                boot scan fail fast; at most I2C_BURST_MAX bytes per burst
+ *
+ * Display output is coalesced: one disp_flush_all() after the last tag
+ * (and before any delay_ms, so timed sequences still show each frame).
  *
  * Returns number of actions executed.
  */
+/*
+ * _gpio_pin_list : the pins= value of a gpio_set tag into out, its names
+ * trimmed and joined by single commas ("a , b,,c" -> "a,b,c"). The value
+ * is quoted (blanks separate names too), or bare up to the first blank
+ * that is not next to a comma, so "pins=a, b value=1" is the list a,b. Returns false without pins=;
+ * *cut is set when the list does not fit out.
+ */
+static bool _gpio_pin_list(const char *buf, char *out, uint8_t cap, bool *cut) {
+    const char *p = strstr(buf, "pins=");
+    *cut = false;
+    out[0] = '\0';
+    if (!p) return false;
+    p += 5;
+    const bool quoted = *p == '"';
+    if (quoted) ++p;
+    uint8_t n = 0, tok = 0;                             // tok: where the current name began
+    for (; *p && !(quoted && *p == '"'); ++p) {
+        char c = *p;
+        if (c == '=' && !quoted) { n = tok; break; }    // "pins=a, value=1": a key, not a name
+        if (c == ' ' || c == '\t') {
+            if (!n || out[n - 1] == ',') continue;
+            const char *q = p;
+            while (*q == ' ' || *q == '\t') ++q;
+            if (*q == ',') { p = q - 1; continue; }
+            if (!quoted) break;                         // next key=value
+            c = ',';                                    // "a b" inside quotes
+            p = q - 1;
+        }
+        if (c == ',' && (!n || out[n - 1] == ',')) continue;
+        if (n + 1 >= cap) { *cut = true; break; }
+        out[n++] = c;
+        if (c == ',') tok = n;
+    }
+    if (n && out[n - 1] == ',') --n;
+    out[n] = '\0';
+    return true;
+}
+
 static int execute_actions_in_response(const char *llm_response,
                                        char *result_buf, uint16_t result_cap) {
     const char *p = llm_response;
@@ -265,19 +595,60 @@ static int execute_actions_in_response(const char *llm_response,
         if (alen >= sizeof(action_buf)) { p = end + 1; continue; }
         memcpy(action_buf, p + 8, alen);
 
-        char result[160] = "[RESULT:unknown]\n";
+        // Longest line: serial_read with a 31-char port argument, 80 data
+        // bytes and three 10-digit counters, 199 chars.
+        char result[224] = "[RESULT:unknown]\n";
 
         // ── gpio_set ──────────────────────────────────────────────────
+        // pins=a,b,c switches every listed output in one register write.
+        // The whole list is validated first : nothing moves on error, and
+        // the result names every pin that is unknown or not an output.
         if (strncmp(action_buf, "gpio_set", 8) == 0) {
-            int pin = board_resolve_action_pin(action_buf, "pin");
             int val = board_parse_action_int(action_buf, "value");
-            if (pin < 0)
-                snprintf(result, sizeof(result), "[RESULT:gpio_set error=pin_not_found]\n");
-            else if (!board_is_output_pin(pin))
-                snprintf(result, sizeof(result), "[RESULT:gpio_set pin=%d error=not_output_pin]\n", pin);
-            else {
-                digitalWrite(pin, val ? HIGH : LOW);
-                snprintf(result, sizeof(result), "[RESULT:gpio_set pin=%d value=%d ok=1]\n", pin, val ? 1 : 0);
+            char list[sizeof(action_buf)];
+            bool cut = false;
+            if (_gpio_pin_list(action_buf, list, sizeof(list), &cut)) {
+                BoardPinMask mask = 0;
+                char unknown[sizeof(list)] = "", not_out[sizeof(list)] = "";
+                char *tok = list;
+                while (tok && *tok) {
+                    char *next = strchr(tok, ',');
+                    if (next) *next = '\0';
+                    int pin = board_resolve_pin(tok);
+                    char *bad = pin < 0 ? unknown : !board_is_output_pin(pin) ? not_out : nullptr;
+                    if (bad) {
+                        if (bad[0]) strlcat(bad, ",", sizeof(unknown));
+                        strlcat(bad, tok, sizeof(unknown));
+                    } else {
+                        mask |= (BoardPinMask)1 << pin;
+                    }
+                    if (next) *next = ',';
+                    tok = next ? next + 1 : nullptr;
+                }
+                if (cut)
+                    snprintf(result, sizeof(result), "[RESULT:gpio_set error=pin_list_too_long]\n");
+                else if (unknown[0] || not_out[0])
+                    snprintf(result, sizeof(result),
+                             "[RESULT:gpio_set error=bad_pins%s%.80s%s%.80s]\n",
+                             unknown[0] ? " not_found=" : "", unknown,
+                             not_out[0] ? " not_output=" : "", not_out);
+                else if (!mask)
+                    snprintf(result, sizeof(result), "[RESULT:gpio_set error=pin_not_found]\n");
+                else {
+                    gpio_write_mask(mask, val > 0);
+                    snprintf(result, sizeof(result), "[RESULT:gpio_set pins=%s value=%d ok=1]\n",
+                             list, val > 0 ? 1 : 0);
+                }
+            } else {
+                int pin = board_resolve_action_pin(action_buf, "pin");
+                if (pin < 0)
+                    snprintf(result, sizeof(result), "[RESULT:gpio_set error=pin_not_found]\n");
+                else if (!board_is_output_pin(pin))
+                    snprintf(result, sizeof(result), "[RESULT:gpio_set pin=%d error=not_output_pin]\n", pin);
+                else {
+                    gpio_write((uint8_t)pin, val > 0);
+                    snprintf(result, sizeof(result), "[RESULT:gpio_set pin=%d value=%d ok=1]\n", pin, val > 0 ? 1 : 0);
+                }
             }
 
         // ── gpio_get ──────────────────────────────────────────────────
@@ -285,21 +656,9 @@ static int execute_actions_in_response(const char *llm_response,
             int pin = board_resolve_action_pin(action_buf, "pin");
             if (pin < 0)
                 snprintf(result, sizeof(result), "[RESULT:gpio_get error=pin_not_found]\n");
-            else{
-                bool inv = false;
-                for(uint8_t i = 0; i < g_board_pin_count; ++i)
-                {
-                    if(g_board_pins[i].pin == (uint8_t)pin)
-                    {
-                        inv = g_board_pins[i].inverted;
-                        break;
-                    }
-                }
-                int phy = digitalRead(pin);
-                int logic = inv ? !phy : phy;
+            else
                 snprintf(result, sizeof(result), "[RESULT:gpio_get pin=%d value=%d]\n",
-                         pin, logic);
-            }
+                         pin, gpio_read((uint8_t)pin));
         // ── adc_read ──────────────────────────────────────────────────
         } else if (strncmp(action_buf, "adc_read", 8) == 0) {
             int pin = board_resolve_action_pin(action_buf, "pin");
@@ -337,10 +696,13 @@ static int execute_actions_in_response(const char *llm_response,
                 snprintf(result, sizeof(result), "[RESULT:serial_read port=%s error=not_declared]\n", port_name);
             else {
                 char rbuf[96] = {};
-                // No explicit timeout — default 150 ms in board_serial_read (Bug #2 / #6 fix)
-                board_serial_read(si, rbuf, sizeof(rbuf));
-                snprintf(result, sizeof(result), "[RESULT:serial_read port=%s data=\"%.80s\"]\n",
-                         port_name, rbuf);
+                uint32_t age = 0;
+                // Returns buffered data at once; only an empty ring waits (≤150 ms)
+                board_serial_read(si, rbuf, sizeof(rbuf), 150, &age);
+                snprintf(result, sizeof(result),
+                         "[RESULT:serial_read port=%s data=\"%.80s\" age_ms=%lu more=%u dropped=%lu]\n",
+                         port_name, rbuf, (unsigned long)age, board_serial_lines(si),
+                         (unsigned long)board_serial_overflow(si));
             }
 
         // ── delay_ms ──────────────────────────────────────────────────
@@ -348,28 +710,16 @@ static int execute_actions_in_response(const char *llm_response,
             int ms = board_parse_action_int(action_buf, "ms");
             if (ms < 0) ms = 0;
             if (ms > 5000) ms = 5000;  // hard cap
+            disp_flush_all();           // show everything drawn so far first
             /*
-             * usb_keepalive() is not called while the normal
-             * network stack runs here (g_http_busy=false). Drip a null byte
-             * every 200 ms so the ESP32-C3 USB-CDC driver doesn't drop the
-             * COM port during a long delay action.
+             * Run io tasks while waiting: the USB keepalive task drips a
+             * null byte every 200 ms so the ESP32-C3 USB-CDC driver doesn't
+             * drop the COM port, and servo sweeps keep moving.
              */
-            uint32_t remaining = (uint32_t)ms;
-            unsigned long last_ka = millis();
-            while (remaining > 0) {
-                uint32_t step = (remaining > 1) ? 1 : remaining;
-                delay(step);
-                remaining -= step;
-#if defined(ARDUINO_USB_CDC_ON_BOOT) && ARDUINO_USB_CDC_ON_BOOT
-                unsigned long now = millis();
-                if (now - last_ka >= 200) {
-                    last_ka = now;
-                    Serial.write((uint8_t)0x00);
-                    Serial.flush();
-                }
-#else
-                (void)last_ka;
-#endif
+            unsigned long t0 = millis();
+            while ((millis() - t0) < (unsigned long)ms) {
+                delay(1);
+                sched_yield_io();
             }
             snprintf(result, sizeof(result), "[RESULT:delay_ms ms=%d ok=1]\n", ms);
 
@@ -386,27 +736,18 @@ static int execute_actions_in_response(const char *llm_response,
                 angle = max((int)g_board_servos[si].min_angle,
                             min((int)g_board_servos[si].max_angle,
                                 angle < 0 ? 0 : angle));
-                uint8_t step = g_board_servos[si].servo_step;
-                if(step <= 1){
-                    s_servos[si].write(angle);
-                } else{
-                    int current = s_servos[si].read();
-                    int dir = (angle > current) ? 1 : -1;
-                    uint16_t time = g_board_servos[si].step_delay_ms;
-                    for(int pos = current; pos != angle; pos += dir * step)
-                    {
-                        if((dir > 0 && pos > angle) || (dir < 0 && pos < angle))
-                        {
-                            pos = angle;
-                        }
-                        s_servos[si].write(pos);
-                        if(time > 0) delay(time);
-                    }
+                // Step > 1 sweeps in the background (servo_motion_task).
+                ServoSweep &sw = s_sweep[si];
+                sw.target = (int16_t)angle;
+                if (g_board_servos[si].servo_step <= 1) {
+                    sw.pos = sw.target;
                     s_servos[si].write(angle);
+                } else {
+                    sw.next_ms = millis();
                 }
 
-                snprintf(result, sizeof(result), "[RESULT:servo_set name=%s angle=%d ok=1]\n",
-                         name, angle);
+                snprintf(result, sizeof(result), "[RESULT:servo_set name=%s angle=%d moving=%u ok=1]\n",
+                         name, angle, sw.pos != sw.target ? 1 : 0);
             }
 #else
             snprintf(result, sizeof(result), "[RESULT:servo_set error=servo_not_built]\n");
@@ -445,11 +786,13 @@ static int execute_actions_in_response(const char *llm_response,
             if (bi < 0 || !s_oled_ok[bi]) {
                 snprintf(result, sizeof(result), "[RESULT:oled_print bus=%s error=not_found]\n", bus_name);
             } else {
+                int16_t bx, by; uint16_t bw, bh;
+                s_oled[bi].setTextSize(1);
+                s_oled[bi].getTextBounds(text, x, y, &bx, &by, &bw, &bh);
                 s_oled[bi].setCursor(x, y);
                 s_oled[bi].setTextColor(SSD1306_WHITE);
-                s_oled[bi].setTextSize(1);
                 s_oled[bi].print(text);
-                s_oled[bi].display();
+                disp_oled_mark(bi, bx, by, bw, bh);
                 snprintf(result, sizeof(result), "[RESULT:oled_print bus=%s ok=1]\n", bus_name);
             }
 #else
@@ -466,7 +809,7 @@ static int execute_actions_in_response(const char *llm_response,
                 snprintf(result, sizeof(result), "[RESULT:oled_clear bus=%s error=not_found]\n", bus_name);
             } else {
                 s_oled[bi].clearDisplay();
-                s_oled[bi].display();
+                disp_oled_mark(bi, 0, 0, OLED_W, OLED_H);
                 snprintf(result, sizeof(result), "[RESULT:oled_clear bus=%s ok=1]\n", bus_name);
             }
 #else
@@ -491,50 +834,97 @@ static int execute_actions_in_response(const char *llm_response,
             else if (!strcmp(color_s,"black")) color = 0x0000;
             else if (color_s[0])               color = (uint16_t)strtol(color_s, nullptr, 0);
             int bi = board_find_spi_by_name(bus_name);
-            if (bi < 0) {
+            Adafruit_GFX *tft = disp_tft(bi);
+            if (!tft) {
                 snprintf(result, sizeof(result), "[RESULT:tft_print bus=%s error=not_found]\n", bus_name);
             } else {
-#if defined(BOARD_HAS_TFT_ILI9341)
-                if (s_tft_ili[bi]) {
-                    s_tft_ili[bi]->setCursor(x, y);
-                    s_tft_ili[bi]->setTextColor(color);
-                    s_tft_ili[bi]->setTextSize(1);
-                    s_tft_ili[bi]->print(text);
-                    snprintf(result, sizeof(result), "[RESULT:tft_print bus=%s ok=1]\n", bus_name);
-                }
-#elif defined(BOARD_HAS_TFT_ST7789)
-                if (s_tft_st7[bi]) {
-                    s_tft_st7[bi]->setCursor(x, y);
-                    s_tft_st7[bi]->setTextColor(color);
-                    s_tft_st7[bi]->setTextSize(1);
-                    s_tft_st7[bi]->print(text);
-                    snprintf(result, sizeof(result), "[RESULT:tft_print bus=%s ok=1]\n", bus_name);
-                }
-#endif
+                tft->setCursor(x, y);
+                tft->setTextColor(color);
+                tft->setTextSize(1);
+                tft->print(text);
+                snprintf(result, sizeof(result), "[RESULT:tft_print bus=%s ok=1]\n", bus_name);
             }
 #else
             snprintf(result, sizeof(result), "[RESULT:tft_print error=tft_not_built]\n");
 #endif
 
+        // ── display_text ──────────────────────────────────────────────
+        // lines="a|b|c" : one line per '|', starting at y, each line band
+        // is cleared before drawing. bus may name an OLED (I2C) or TFT (SPI).
+        } else if (strncmp(action_buf, "display_text", 12) == 0) {
+#if defined(BOARD_HAS_OLED_SSD1306) || defined(BOARD_HAS_TFT_ILI9341) || defined(BOARD_HAS_TFT_ST7789)
+            char bus_name[32]; char lines[128];
+            board_parse_action_str(action_buf, "bus",   bus_name, sizeof(bus_name));
+            board_parse_action_str(action_buf, "lines", lines,    sizeof(lines));
+            int x = board_parse_action_int(action_buf, "x");
+            int y = board_parse_action_int(action_buf, "y");
+            int size = board_parse_action_int(action_buf, "size");
+            if (x < 0) x = 0;
+            if (y < 0) y = 0;
+            if (size < 1) size = 1;
+            if (size > 4) size = 4;
+
+            Adafruit_GFX *gfx = nullptr;
+            uint16_t fg = DISP_FG_WHITE;
+            int oi = -1;
+#if defined(BOARD_HAS_OLED_SSD1306)
+            oi = board_find_i2c_by_name(bus_name);
+            if (oi >= 0 && s_oled_ok[oi]) { gfx = &s_oled[oi]; fg = SSD1306_WHITE; }
+            else oi = -1;
+#endif
+#if defined(BOARD_HAS_TFT_ILI9341) || defined(BOARD_HAS_TFT_ST7789)
+            if (!gfx) gfx = disp_tft(board_find_spi_by_name(bus_name));
+#endif
+            if (!gfx) {
+                snprintf(result, sizeof(result), "[RESULT:display_text bus=%s error=not_found]\n", bus_name);
+            } else {
+                const int16_t lh = (int16_t)(8 * size);
+                uint8_t n = 0;
+                char *save = nullptr;
+                gfx->setTextSize((uint8_t)size);
+                gfx->setTextColor(fg);
+                for (char *ln = strtok_r(lines, "|", &save); ln;
+                     ln = strtok_r(nullptr, "|", &save), ++n) {
+                    int16_t ly = (int16_t)(y + n * lh);
+                    if (ly >= gfx->height()) break;
+                    gfx->fillRect((int16_t)x, ly, (int16_t)(gfx->width() - x), lh, DISP_BG_BLACK);
+                    gfx->setCursor((int16_t)x, ly);
+                    gfx->print(ln);
+#if defined(BOARD_HAS_OLED_SSD1306)
+                    if (oi >= 0) disp_oled_mark((uint8_t)oi, (int16_t)x, ly, (int16_t)(OLED_W - x), lh);
+#endif
+                }
+                snprintf(result, sizeof(result), "[RESULT:display_text bus=%s lines=%u ok=1]\n", bus_name, n);
+            }
+#else
+            snprintf(result, sizeof(result), "[RESULT:display_text error=display_not_built]\n");
+#endif
+
         // ── i2c_write (raw) ───────────────────────────────────────────
+        // data may be a comma list : one transaction writes reg + all bytes.
         } else if (strncmp(action_buf, "i2c_write", 9) == 0) {
-            char bus_name[32]; char reg_s[8]; char data_s[32];
+            char bus_name[32]; char reg_s[8]; char data_s[128];
             board_parse_action_str(action_buf, "bus",  bus_name, sizeof(bus_name));
             board_parse_action_str(action_buf, "reg",  reg_s,    sizeof(reg_s));
             board_parse_action_str(action_buf, "data", data_s,   sizeof(data_s));
             int bi = board_find_i2c_by_name(bus_name);
+            uint8_t wbuf[I2C_BURST_MAX + 1];
+            wbuf[0] = (uint8_t)strtol(reg_s, nullptr, 0);
+            int n = i2c_parse_bytes(data_s, wbuf + 1, I2C_BURST_MAX);
             if (bi < 0) {
                 snprintf(result, sizeof(result), "[RESULT:i2c_write bus=%s error=not_found]\n", bus_name);
+            } else if (n <= 0) {
+                snprintf(result, sizeof(result), "[RESULT:i2c_write bus=%s error=bad_data]\n", bus_name);
+            } else if (!i2c_present(g_board_i2c[bi].bus, g_board_i2c[bi].addr)) {
+                snprintf(result, sizeof(result), "[RESULT:i2c_write bus=%s addr=0x%02X error=no_device]\n",
+                         bus_name, g_board_i2c[bi].addr);
             } else {
-                uint8_t addr = g_board_i2c[bi].addr;
-                uint8_t reg  = (uint8_t)strtol(reg_s,  nullptr, 0);
-                uint8_t dat  = (uint8_t)strtol(data_s, nullptr, 0);
-                TwoWire &w = (g_board_i2c[bi].bus == 0) ? Wire : Wire1;
-                w.beginTransmission(addr);
-                w.write(reg); w.write(dat);
-                uint8_t err = w.endTransmission();
-                snprintf(result, sizeof(result), "[RESULT:i2c_write bus=%s err=%u ok=%u]\n",
-                         bus_name, err, err == 0 ? 1 : 0);
+                I2cStep st = {false, (uint8_t)(n + 1), 0};
+                char none[1];
+                uint8_t err = i2c_run(g_board_i2c[bi].bus, g_board_i2c[bi].addr,
+                                      &st, 1, wbuf, none, sizeof(none));
+                snprintf(result, sizeof(result), "[RESULT:i2c_write bus=%s bytes=%d err=%u ok=%u]\n",
+                         bus_name, n, err, err == 0 ? 1 : 0);
             }
 
         // ── i2c_read (raw) ────────────────────────────────────────────
@@ -543,24 +933,55 @@ static int execute_actions_in_response(const char *llm_response,
             board_parse_action_str(action_buf, "bus", bus_name, sizeof(bus_name));
             board_parse_action_str(action_buf, "reg", reg_s,    sizeof(reg_s));
             int len = board_parse_action_int(action_buf, "len");
-            if (len <= 0 || len > 16) len = 1;
+            if (len <= 0 || len > I2C_BURST_MAX) len = 1;
             int bi = board_find_i2c_by_name(bus_name);
             if (bi < 0) {
                 snprintf(result, sizeof(result), "[RESULT:i2c_read bus=%s error=not_found]\n", bus_name);
+            } else if (!i2c_present(g_board_i2c[bi].bus, g_board_i2c[bi].addr)) {
+                snprintf(result, sizeof(result), "[RESULT:i2c_read bus=%s addr=0x%02X error=no_device]\n",
+                         bus_name, g_board_i2c[bi].addr);
             } else {
-                uint8_t addr = g_board_i2c[bi].addr;
-                uint8_t reg  = (uint8_t)strtol(reg_s, nullptr, 0);
-                TwoWire &w = (g_board_i2c[bi].bus == 0) ? Wire : Wire1;
-                w.beginTransmission(addr);
-                w.write(reg);
-                w.endTransmission(false);
-                uint8_t n = w.requestFrom(addr, (uint8_t)len);
-                char hex[48] = {};
-                uint8_t hw = 0;
-                for (uint8_t i = 0; i < n && hw + 3 < sizeof(hex); ++i)
-                    hw += snprintf(hex + hw, sizeof(hex) - hw, "%02X", (uint8_t)w.read());
-                snprintf(result, sizeof(result), "[RESULT:i2c_read bus=%s data=0x%s]\n",
-                         bus_name, hex);
+                uint8_t reg = (uint8_t)strtol(reg_s, nullptr, 0);
+                I2cStep steps[2] = {{false, 1, 0}, {true, (uint8_t)len, 0}};
+                char hex[I2C_BURST_MAX * 2 + 1];
+                uint8_t err = i2c_run(g_board_i2c[bi].bus, g_board_i2c[bi].addr,
+                                      steps, 2, &reg, hex, sizeof(hex));
+                if (err)
+                    snprintf(result, sizeof(result), "[RESULT:i2c_read bus=%s err=%u ok=0]\n", bus_name, err);
+                else
+                    snprintf(result, sizeof(result), "[RESULT:i2c_read bus=%s data=0x%s]\n",
+                             bus_name, hex);
+            }
+
+        // ── i2c_xfer (batched) ────────────────────────────────────────
+        // seq="w:0x6B,0x00;w:0x3B;r:14" : repeated START from a write into
+        // the read after it, STOP after every other step. Read bytes come
+        // back concatenated.
+        } else if (strncmp(action_buf, "i2c_xfer", 8) == 0) {
+            char bus_name[32]; char seq[128];
+            board_parse_action_str(action_buf, "bus", bus_name, sizeof(bus_name));
+            board_parse_action_str(action_buf, "seq", seq,      sizeof(seq));
+            int bi = board_find_i2c_by_name(bus_name);
+            I2cStep steps[I2C_MAX_STEPS];
+            uint8_t wbuf[I2C_BURST_MAX];
+            int nsteps = i2c_parse_seq(seq, steps, wbuf);
+            if (bi < 0) {
+                snprintf(result, sizeof(result), "[RESULT:i2c_xfer bus=%s error=not_found]\n", bus_name);
+            } else if (nsteps <= 0) {
+                snprintf(result, sizeof(result), "[RESULT:i2c_xfer bus=%s error=bad_seq]\n", bus_name);
+            } else if (!i2c_present(g_board_i2c[bi].bus, g_board_i2c[bi].addr)) {
+                snprintf(result, sizeof(result), "[RESULT:i2c_xfer bus=%s addr=0x%02X error=no_device]\n",
+                         bus_name, g_board_i2c[bi].addr);
+            } else {
+                char hex[I2C_BURST_MAX * 2 + 1];
+                uint8_t err = i2c_run(g_board_i2c[bi].bus, g_board_i2c[bi].addr,
+                                      steps, (uint8_t)nsteps, wbuf, hex, sizeof(hex));
+                if (err)
+                    snprintf(result, sizeof(result), "[RESULT:i2c_xfer bus=%s err=%u ok=0]\n", bus_name, err);
+                else if (hex[0])
+                    snprintf(result, sizeof(result), "[RESULT:i2c_xfer bus=%s data=0x%s ok=1]\n", bus_name, hex);
+                else
+                    snprintf(result, sizeof(result), "[RESULT:i2c_xfer bus=%s ok=1]\n", bus_name);
             }
 
         } else {
@@ -579,5 +1000,6 @@ static int execute_actions_in_response(const char *llm_response,
         p = end + 1;
         ++count;
     }
+    disp_flush_all();
     return count;
 }
\ No newline at end of file
@@ -8,6 +8,17 @@
 
 #pragma once
 
+static int8_t dc_chan_add(const char *id);   // discord.h
+
+/*
+ * True from agent_run() until the reply is handed on (agent_task, live.h).
+ * A turn yields to io tasks (HTTP waits, delay_ms, live edits), so the
+ * shell parks command lines meanwhile: a nested 'chat' would overwrite
+ * g_llm_out, the arena and the session, and 'board push' / 'board reset'
+ * would rewrite the board tables the actions are still using.
+ */
+static bool g_agent_turn = false;
+
 static char g_llm_out[RESP_S];
 static char g_action_results[512];
 static char g_tool_result[512];
@@ -46,7 +57,9 @@ static void tool_dispatch(const char *name, const char *args) {
             strlcpy(g_cfg.discord.token, val, CFG_S);
             g_cfg.discord.enabled = true;
         }
-        else if (!strcmp(key,"dc_channel_id")) strlcpy(g_cfg.discord_channel_id, val, ALLOW_ID_LEN);
+        else if (!strcmp(key,"dc_channel_id")) dc_chan_add(val);
+        else if (!strcmp(key,"stream_replies"))
+            g_cfg.stream_replies = !strcmp(val,"on") || !strcmp(val,"1") || !strcmp(val,"true");
         cfg_save();
         snprintf(g_tool_result, 512, "set %s ok", key);
 
@@ -73,16 +86,25 @@ static void tool_dispatch(const char *name, const char *args) {
  * Multi-turn loop: call LLM, execute any [ACTION:...] or <tool:...> blocks,
  * feed results back, and repeat up to max_tool_iters times.
  */
-static const char *agent_run(const char *user_input) {
-    static char combined[PROMPT_S + 512];
-    strlcpy(combined, user_input, sizeof(combined));
+static const char *_agent_run(const char *user_input) {
+    static constexpr uint16_t COMBINED_S = PROMPT_S + 512;
+    ArenaScope scope;
+    char *combined = arena_alloc(COMBINED_S);
+    if (!combined) {
+        strlcpy(g_llm_out, "[agent] out of scratch memory", RESP_S);
+        return g_llm_out;
+    }
+    strlcpy(combined, user_input, COMBINED_S);
 
     for (uint8_t iter = 0; iter < g_cfg.max_tool_iters; ++iter) {
         if (!llm_chat(combined, g_llm_out, RESP_S)) return g_llm_out;
+        mem_buf_note(MB_LLM_OUT, strlen(g_llm_out) + 1, RESP_S);
         session_append("user", iter == 0 ? user_input : "[action_results]");
 
+        uint32_t t0 = micros();
         int n_actions = execute_actions_in_response(
             g_llm_out, g_action_results, sizeof(g_action_results));
+        if (n_actions) hist_add(H_ACTIONS, micros() - t0);
 
         strip_action_tags(g_llm_out);
         session_append("assistant", g_llm_out);
@@ -97,16 +119,28 @@ static const char *agent_run(const char *user_input) {
             memcpy(tname, ns, min((ptrdiff_t)47, ne - ns));
             const char *as = ne + 1, *ae = strstr(as, "</tool>");
             uint16_t al = ae ? (uint16_t)(ae - as) : 0;
-            static char targs[512];
+            ArenaScope tool_scope;
+            char *targs = arena_alloc(512);
+            if (!targs) break;
             memcpy(targs, as, min(al, (uint16_t)511)); targs[min(al, (uint16_t)511)] = '\0';
             tool_dispatch(tname, targs);
             Serial.printf("[tool:%s] %s\r\n", tname, g_tool_result);
-            snprintf(combined, sizeof(combined), "[Tool %s]: %s", tname, g_tool_result);
+            snprintf(combined, COMBINED_S, "[Tool %s]: %s", tname, g_tool_result);
         } else if (n_actions > 0) {
-            strlcpy(combined, g_action_results, sizeof(combined));
+            strlcpy(combined, g_action_results, COMBINED_S);
         } else {
             return g_llm_out;
         }
     }
     return g_llm_out;
+}
+
+static const char *agent_run(const char *user_input) {
+    const bool outer = g_agent_turn;
+    g_agent_turn = true;
+    uint32_t t0 = micros();
+    const char *reply = _agent_run(user_input);
+    hist_add(H_AGENT, micros() - t0);
+    g_agent_turn = outer;
+    return reply;
 }
\ No newline at end of file
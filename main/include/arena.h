@@ -0,0 +1,111 @@
+/*
+ * ─────────────────────────────────────────────────────────────
+ * FemtoClaw : scratch arena.
+ *
+ * One static region (ARENA_S, constants.h) replaces the per-function
+ * static scratch buffers: request paths and auth headers, the agent's
+ * prompt, shell argument copies, the LittleFS config JSON. A function
+ * opens an ArenaScope, takes what it needs with arena_alloc() and gets
+ * it all back when the scope closes:
+ *
+ *     ArenaScope scope;
+ *     char *path = arena_alloc(CFG_S);
+ *     if (!path) return -1;
+ *
+ * Allocation bumps a top index; a scope puts it back where it found it,
+ * so nested users (agent_run → tool → cfg_save, or an io task run while
+ * a request waits) stack up and unwind in order. Memory stays valid
+ * until its scope closes, including across a blocking net_call(), but
+ * never beyond: nothing here may be kept by an async job.
+ *
+ * loop() core only. The net core and ISRs must not touch the arena.
+ *
+ * When it is full arena_alloc() logs and returns nullptr; the caller
+ * gives up on that one operation. The peak is shown by 'mem' : size
+ * ARENA_S from it (or -DFC_ARENA_S=...).
+ *
+ * -DFC_ARENA_DEBUG puts a length header and a canary word around every
+ * block and checks them when the scope closes and on 'mem', naming the
+ * block that was overrun.
+ *
+ * Depends on: constants.h
+ * ─────────────────────────────────────────────────────────────
+ */
+
+#pragma once
+
+static constexpr uint32_t ARENA_CANARY = 0xA5E1DEADu;
+
+alignas(4) static FC_EXT_BSS uint8_t g_arena[ARENA_S];
+static uint16_t g_arena_top   = 0;
+static uint16_t g_arena_peak  = 0;
+static uint16_t g_arena_fails = 0;
+
+#ifdef FC_ARENA_DEBUG
+struct ArenaHdr {
+    uint16_t len;             // bytes handed out, rounded to 4
+    uint16_t line;            // caller's __LINE__, for the report
+};
+static uint16_t g_arena_smashed = 0;
+
+// Walk the blocks from `from` to the top; true when every canary holds.
+static bool arena_check(uint16_t from = 0) {
+    bool ok = true;
+    for (uint16_t at = from; at < g_arena_top; ) {
+        const ArenaHdr *h = (const ArenaHdr *)(g_arena + at);
+        uint32_t c;
+        memcpy(&c, g_arena + at + sizeof(ArenaHdr) + h->len, 4);
+        if (c != ARENA_CANARY) {
+            Serial.printf("[arena] ERROR: block of %u B from line %u overran its end\r\n",
+                          (unsigned)h->len, (unsigned)h->line);
+            ++g_arena_smashed;
+            ok = false;
+        }
+        at += sizeof(ArenaHdr) + h->len + 4;
+    }
+    return ok;
+}
+#endif
+
+// n bytes, 4-byte aligned, starting as an empty string. nullptr when full.
+static char *arena_alloc(uint16_t n, uint16_t line = __builtin_LINE()) {
+    uint16_t len  = (uint16_t)((n + 3u) & ~3u);
+#ifdef FC_ARENA_DEBUG
+    uint32_t need = sizeof(ArenaHdr) + len + 4;
+#else
+    uint32_t need = len;
+    (void)line;
+#endif
+    if (g_arena_top + need > ARENA_S) {
+        ++g_arena_fails;
+        Serial.printf("[arena] ERROR: out of space : %u B wanted, %u / %u used\r\n",
+                      (unsigned)n, (unsigned)g_arena_top, (unsigned)ARENA_S);
+        return nullptr;
+    }
+    uint8_t *p = g_arena + g_arena_top;
+#ifdef FC_ARENA_DEBUG
+    ArenaHdr h = { len, line };
+    memcpy(p, &h, sizeof(h));
+    p += sizeof(h);
+    memcpy(p + len, &ARENA_CANARY, 4);
+#endif
+    g_arena_top = (uint16_t)(g_arena_top + need);
+    if (g_arena_top > g_arena_peak) g_arena_peak = g_arena_top;
+    p[0] = '\0';
+    return (char *)p;
+}
+
+// Releases everything allocated since it was opened.
+struct ArenaScope {
+    uint16_t mark;
+
+    ArenaScope() : mark(g_arena_top) {}
+    ~ArenaScope() {
+#ifdef FC_ARENA_DEBUG
+        arena_check(mark);
+#endif
+        g_arena_top = mark;
+    }
+    ArenaScope(const ArenaScope &) = delete;
+    ArenaScope &operator=(const ArenaScope &) = delete;
+};
@@ -34,6 +34,7 @@
 
 #pragma once
 #include <Arduino.h>
+#include <atomic>
 
 /*
 * ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
@@ -45,6 +46,12 @@
 */
 #ifdef BOARD_PICO_W
   #include <SerialUART.h>
+  #include <hardware/gpio.h>     // gpio_put_masked() : single SIO write
+#endif
+
+#ifdef BOARD_ESP32
+  #include <soc/gpio_reg.h>      // GPIO_OUT_W1TS_REG / GPIO_OUT_W1TC_REG
+  #include <soc/soc.h>           // REG_WRITE
 #endif
 
 /*
@@ -77,6 +84,20 @@
   #endif
 #endif
 
+/*
+* Background RX ring per declared UART (bytes, power of two). Also used as
+* the driver-side RX buffer size so a burst during a TLS request can wait.
+*/
+#ifndef SERIAL_RX_RING
+  #if defined(BOARD_PICO_W)
+    #define SERIAL_RX_RING   256
+  #else
+    #define SERIAL_RX_RING   512
+  #endif
+#endif
+static_assert((SERIAL_RX_RING & (SERIAL_RX_RING - 1)) == 0,
+              "SERIAL_RX_RING must be a power of two");
+
 #ifndef MAX_BOARD_ADC
   #if defined(BOARD_PICO_W)
     #define MAX_BOARD_ADC    4    // RP2040: GP26-GP29
@@ -101,6 +122,27 @@
   #define MAX_BOARD_PWM    8
 #endif
 
+/*
+* Physical pin space covered by the capability masks below.
+* ESP32-S3 exposes GPIO0-48, RP2040 GP0-GP29. One bit per pin.
+*/
+#ifndef BOARD_PIN_SPACE
+  #if defined(BOARD_PICO_W)
+    #define BOARD_PIN_SPACE  30
+  #else
+    #define BOARD_PIN_SPACE  49
+  #endif
+#endif
+
+#if BOARD_PIN_SPACE <= 32
+  typedef uint32_t BoardPinMask;
+#else
+  typedef uint64_t BoardPinMask;
+#endif
+
+// Marks an optional pin cell that was left blank (e.g. SPI MISO).
+static constexpr uint8_t BOARD_PIN_NONE = 0xFF;
+
 /*
 * ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
 *                            Structs
@@ -195,6 +237,24 @@ static uint8_t g_board_spi_count    = 0;
 static uint8_t g_board_servo_count  = 0;
 static uint8_t g_board_pwm_count    = 0;
 
+/*
+* Per-pin capability masks, rebuilt by board_parse_md(). Bit N of
+* g_pin_caps[PC_x] is set when physical pin N has capability x, so every
+* runtime check (gpio_set, adc_read, shell) is a shift and an AND.
+*/
+enum PinCap : uint8_t {
+    PC_OUTPUT,      // ## GPIO Pins, mode OUTPUT
+    PC_INPUT,       // ## GPIO Pins, any INPUT mode
+    PC_ADC,         // ## ADC Pins
+    PC_INVERTED,    // ## GPIO Pins, Logic = inverted
+    PC_PWM,         // ## PWM Outputs
+    PC_SERVO,       // ## Servos
+    PC_BUS,         // reserved by a UART / I2C / SPI line
+    PC_COUNT
+};
+
+static BoardPinMask g_pin_caps[PC_COUNT];
+
 /*
 * ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
 *                       Internal parser helpers
@@ -337,18 +397,155 @@ static HardwareSerial *board_get_uart(uint8_t port_num) {
 #endif
 }
 
+/*
+* ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+*                           Name index
+* ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+* One table maps every declared name (all sections) to (kind, index).
+* Built once at the end of board_parse_md(), sorted by a precomputed
+* case-insensitive FNV-1a hash so each lookup is a binary search plus a
+* single strcasecmp() to confirm, instead of one strcmp scan per section.
+*
+* Names must be unique across ALL sections : "relay1" cannot be both a GPIO
+* pin and a PWM output. Duplicates are reported and reject the config.
+*/
+enum BoardKind : uint8_t {
+    BK_GPIO, BK_SERIAL, BK_ADC, BK_I2C, BK_SPI, BK_SERVO, BK_PWM
+};
+
+struct BoardNameEntry {
+    uint32_t hash;
+    uint8_t  kind;       // BoardKind
+    uint8_t  index;      // index into the matching g_board_* array
+};
+
+static constexpr uint8_t MAX_BOARD_NAMES =
+    MAX_BOARD_PINS + MAX_BOARD_SERIALS + MAX_BOARD_ADC + MAX_BOARD_I2C +
+    MAX_BOARD_SPI  + MAX_BOARD_SERVOS  + MAX_BOARD_PWM;
+
+static BoardNameEntry g_board_names[MAX_BOARD_NAMES];
+static uint8_t        g_board_name_count = 0;
+
+static const char *_bp_kind_name(uint8_t kind) {
+    switch (kind) {
+        case BK_GPIO:   return "GPIO";
+        case BK_SERIAL: return "Serial";
+        case BK_ADC:    return "ADC";
+        case BK_I2C:    return "I2C";
+        case BK_SPI:    return "SPI";
+        case BK_SERVO:  return "Servo";
+        case BK_PWM:    return "PWM";
+    }
+    return "?";
+}
+
+// _bp_name_hash : FNV-1a over the lower-cased name.
+static uint32_t _bp_name_hash(const char *s) {
+    uint32_t h = 2166136261u;
+    while (*s) {
+        h ^= (uint8_t)tolower((unsigned char)*s++);
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// _bp_entry_name : the stored name behind an index entry.
+static const char *_bp_entry_name(const BoardNameEntry &e) {
+    switch (e.kind) {
+        case BK_GPIO:   return g_board_pins[e.index].name;
+        case BK_SERIAL: return g_board_serials[e.index].name;
+        case BK_ADC:    return g_board_adc[e.index].name;
+        case BK_I2C:    return g_board_i2c[e.index].name;
+        case BK_SPI:    return g_board_spi[e.index].name;
+        case BK_SERVO:  return g_board_servos[e.index].name;
+        case BK_PWM:    return g_board_pwm[e.index].name;
+    }
+    return "";
+}
+
+/*
+* _bp_index_add : insert one name keeping g_board_names[] sorted by hash.
+* Returns false if the same name (case-insensitive) is already present.
+*/
+static bool _bp_index_add(uint8_t kind, uint8_t index, const char *name) {
+    BoardNameEntry e = { _bp_name_hash(name), kind, index };
+
+    uint8_t pos = g_board_name_count;
+    while (pos > 0 && g_board_names[pos - 1].hash > e.hash) --pos;
+
+    // Equal hashes sit directly before pos : check each for a real clash
+    for (uint8_t j = pos; j > 0 && g_board_names[j - 1].hash == e.hash; --j) {
+        const BoardNameEntry &o = g_board_names[j - 1];
+        if (strcasecmp(_bp_entry_name(o), name) == 0) {
+            Serial.printf("[Board] ERROR: duplicate name '%s' (%s and %s)\r\n",
+                          name, _bp_kind_name(o.kind), _bp_kind_name(kind));
+            return false;
+        }
+    }
+
+    memmove(&g_board_names[pos + 1], &g_board_names[pos],
+            (g_board_name_count - pos) * sizeof(BoardNameEntry));
+    g_board_names[pos] = e;
+    ++g_board_name_count;
+    return true;
+}
+
+/*
+* _bp_build_name_index : rebuild the table from the parsed arrays.
+* Reports every duplicate before failing so the user can fix them in one go.
+*/
+static bool _bp_build_name_index() {
+    g_board_name_count = 0;
+    bool ok = true;
+    for (uint8_t i = 0; i < g_board_pin_count;    ++i) ok &= _bp_index_add(BK_GPIO,   i, g_board_pins[i].name);
+    for (uint8_t i = 0; i < g_board_serial_count; ++i) ok &= _bp_index_add(BK_SERIAL, i, g_board_serials[i].name);
+    for (uint8_t i = 0; i < g_board_adc_count;    ++i) ok &= _bp_index_add(BK_ADC,    i, g_board_adc[i].name);
+    for (uint8_t i = 0; i < g_board_i2c_count;    ++i) ok &= _bp_index_add(BK_I2C,    i, g_board_i2c[i].name);
+    for (uint8_t i = 0; i < g_board_spi_count;    ++i) ok &= _bp_index_add(BK_SPI,    i, g_board_spi[i].name);
+    for (uint8_t i = 0; i < g_board_servo_count;  ++i) ok &= _bp_index_add(BK_SERVO,  i, g_board_servos[i].name);
+    for (uint8_t i = 0; i < g_board_pwm_count;    ++i) ok &= _bp_index_add(BK_PWM,    i, g_board_pwm[i].name);
+    return ok;
+}
+
+/*
+* board_find_name : look up a declared name (case-insensitive).
+* Returns the matching entry, or nullptr if the name is not declared.
+*/
+static const BoardNameEntry *board_find_name(const char *name) {
+    if (!name || !name[0]) return nullptr;
+    uint32_t h = _bp_name_hash(name);
+
+    // lower_bound on hash
+    uint8_t lo = 0, hi = g_board_name_count;
+    while (lo < hi) {
+        uint8_t mid = (uint8_t)((lo + hi) / 2);
+        if (g_board_names[mid].hash < h) lo = mid + 1;
+        else                             hi = mid;
+    }
+    for (; lo < g_board_name_count && g_board_names[lo].hash == h; ++lo)
+        if (strcasecmp(_bp_entry_name(g_board_names[lo]), name) == 0)
+            return &g_board_names[lo];
+    return nullptr;
+}
+
+// _bp_find_kind : index into the g_board_* array for `kind`, or -1.
+static int _bp_find_kind(const char *name, uint8_t kind) {
+    const BoardNameEntry *e = board_find_name(name);
+    return (e && e->kind == kind) ? e->index : -1;
+}
+
 /*
 * ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
 *                        Public lookup API
 * ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+* All lookups go through the name index above and are case-insensitive.
+*
 * board_find_pin_by_name : GPIO pin lookup.
 * Returns the physical pin number, or -1 if the name is not declared.
 */
 static int board_find_pin_by_name(const char *name) {
-    for (uint8_t i = 0; i < g_board_pin_count; ++i)
-        if (strcmp(g_board_pins[i].name, name) == 0)
-            return g_board_pins[i].pin;
-    return -1;
+    int i = _bp_find_kind(name, BK_GPIO);
+    return (i >= 0) ? g_board_pins[i].pin : -1;
 }
 
 /*
@@ -356,10 +553,8 @@ static int board_find_pin_by_name(const char *name) {
 * Returns the physical pin number, or -1 if not declared.
 */
 static int board_find_adc_by_name(const char *name) {
-    for (uint8_t i = 0; i < g_board_adc_count; ++i)
-        if (strcmp(g_board_adc[i].name, name) == 0)
-            return g_board_adc[i].pin;
-    return -1;
+    int i = _bp_find_kind(name, BK_ADC);
+    return (i >= 0) ? g_board_adc[i].pin : -1;
 }
 
 /*
@@ -367,81 +562,71 @@ static int board_find_adc_by_name(const char *name) {
 * Returns index into g_board_serials[], or -1 if not declared.
 */
 static int board_find_serial_by_name(const char *name) {
-    for (uint8_t i = 0; i < g_board_serial_count; ++i)
-        if (strcmp(g_board_serials[i].name, name) == 0)
-            return i;
-    return -1;
+    return _bp_find_kind(name, BK_SERIAL);
 }
 
 /*
 * board_find_i2c_by_name : I2C port lookup.
-* Returns index into g_board_serials[], or -1 if not declared.
+* Returns index into g_board_i2c[], or -1 if not declared.
 */
 static int board_find_i2c_by_name(const char *name) {
-    for (uint8_t i = 0; i < g_board_i2c_count; ++i)
-        if (strcmp(g_board_i2c[i].name, name) == 0)
-            return i;
-    return -1;
+    return _bp_find_kind(name, BK_I2C);
 }
 
 /*
 * board_find_spi_by_name : SPI port lookup.
-* Returns index into g_board_serials[], or -1 if not declared.
+* Returns index into g_board_spi[], or -1 if not declared.
 */
 static int board_find_spi_by_name(const char *name) {
-    for (uint8_t i = 0; i < g_board_spi_count; ++i)
-        if (strcmp(g_board_spi[i].name, name) == 0)
-            return i;
-    return -1;
+    return _bp_find_kind(name, BK_SPI);
 }
 
 /*
 * board_find_servo_by_name : Servo port lookup.
-* Returns index into g_board_serials[], or -1 if not declared.
+* Returns index into g_board_servos[], or -1 if not declared.
 */
 static int board_find_servo_by_name(const char *name) {
-    for (uint8_t i = 0; i < g_board_servo_count; ++i)
-        if (strcmp(g_board_servos[i].name, name) == 0)
-            return i;
-    return -1;
+    return _bp_find_kind(name, BK_SERVO);
 }
 
 /*
 * board_find_pwm_by_name : PWM port lookup.
-* Returns index into g_board_serials[], or -1 if not declared.
+* Returns index into g_board_pwm[], or -1 if not declared.
 */
 static int board_find_pwm_by_name(const char *name) {
-    for (uint8_t i = 0; i < g_board_pwm_count; ++i)
-        if (strcmp(g_board_pwm[i].name, name) == 0)
-            return i;
-    return -1;
+    return _bp_find_kind(name, BK_PWM);
 }
 
 
 /*
 * board_resolve_pin : resolve a value that may be a pin name OR a decimal
-* number string. Searches GPIO names first, then ADC names and then parses as
-* an integer. Returns -1 if none match.
+* number string. A single index lookup covers GPIO and ADC names, then the
+* value is parsed as an integer. Returns -1 if none match.
 */
 static int board_resolve_pin(const char *name_or_num) {
-    int p = board_find_pin_by_name(name_or_num);
-    if (p >= 0) return p;
-    p = board_find_adc_by_name(name_or_num);
-    if (p >= 0) return p;
+    const BoardNameEntry *e = board_find_name(name_or_num);
+    if (e && e->kind == BK_GPIO) return g_board_pins[e->index].pin;
+    if (e && e->kind == BK_ADC)  return g_board_adc[e->index].pin;
     char *end;
     long n = strtol(name_or_num, &end, 10);
     return (end != name_or_num) ? (int)n : -1;
 }
 
+/*
+* board_pin_has : O(1) capability test against the masks built at parse time.
+* Out-of-range and negative pin numbers never have any capability.
+*/
+static inline bool board_pin_has(int pin_num, uint8_t cap) {
+    if (pin_num < 0 || pin_num >= BOARD_PIN_SPACE) return false;
+    return (g_pin_caps[cap] >> pin_num) & 1;
+}
+
 /*
 * board_is_output_pin : is true if the named/numbered pin declared as OUTPUT.
 * Prevents the action executor from writing to INPUT-mode pins.
 */
 static bool board_is_output_pin(int pin_num) {
-    for (uint8_t i = 0; i < g_board_pin_count; ++i)
-        if (g_board_pins[i].pin == (uint8_t)pin_num)
-            return g_board_pins[i].mode == OUTPUT;
-    return false;
+    return board_pin_has(pin_num, PC_OUTPUT);
 }
 
 /*
@@ -449,9 +634,14 @@ static bool board_is_output_pin(int pin_num) {
 * Prevents arbitrary analogRead() on undeclared pins.
 */
 static bool board_is_adc_pin(int pin_num) {
-    for (uint8_t i = 0; i < g_board_adc_count; ++i)
-        if (g_board_adc[i].pin == (uint8_t)pin_num) return true;
-    return false;
+    return board_pin_has(pin_num, PC_ADC);
+}
+
+/*
+* board_is_inverted_pin : is true if the GPIO pin is declared active-LOW.
+*/
+static bool board_is_inverted_pin(int pin_num) {
+    return board_pin_has(pin_num, PC_INVERTED);
 }
 
 /*
@@ -504,20 +694,121 @@ static int board_resolve_action_pin(const char *buf, const char *key) {
     return board_resolve_pin(tmp);
 }
 
+/*
+* ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+*                     Pin capability tables
+* ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+* _bp_build_pin_caps : fill g_pin_caps[] from the parsed arrays and reject
+* pins claimed by two different roles (e.g. GPIO 21 also used as I2C SDA).
+*
+* The only legal sharing is a bus line reused by several devices on the
+* same bus: I2C entries on one bus share SDA/SCL, SPI entries on one bus
+* share MOSI/MISO/SCK. Chip-select lines are never shared.
+*
+* Owner encoding (parse-time only): 0 = free, otherwise
+*   (kind + 1) << 8 | bus << 4 | role
+*/
+enum : uint8_t {
+    PR_PIN, PR_RX, PR_TX, PR_SDA, PR_SCL, PR_MOSI, PR_MISO, PR_SCK, PR_CS
+};
+
+static const char *_bp_role_name(uint8_t role) {
+    switch (role) {
+        case PR_RX:   return "RX";
+        case PR_TX:   return "TX";
+        case PR_SDA:  return "SDA";
+        case PR_SCL:  return "SCL";
+        case PR_MOSI: return "MOSI";
+        case PR_MISO: return "MISO";
+        case PR_SCK:  return "SCK";
+        case PR_CS:   return "CS";
+    }
+    return "pin";
+}
+
+static bool _bp_claim(uint16_t *owner, uint8_t pin, uint8_t kind, uint8_t bus,
+                      uint8_t role, const char *name, uint8_t cap) {
+    if (pin == BOARD_PIN_NONE) return true;
+    if (pin >= BOARD_PIN_SPACE) {
+        Serial.printf("[Board] WARNING: %s '%s' pin %u is outside GPIO0-%u — ignored\r\n",
+                      _bp_kind_name(kind), name, pin, BOARD_PIN_SPACE - 1);
+        return true;
+    }
+
+    uint16_t me = (uint16_t)(((kind + 1) << 8) | ((bus & 0x0F) << 4) | role);
+    uint16_t cur = owner[pin];
+    bool shared_bus_line = (cur == me) &&
+                           (kind == BK_I2C || kind == BK_SPI) && role != PR_CS;
+
+    if (cur && !shared_bus_line) {
+        Serial.printf("[Board] ERROR: pin %u used by %s %s and %s '%s' %s\r\n",
+                      pin,
+                      _bp_kind_name((uint8_t)((cur >> 8) - 1)), _bp_role_name(cur & 0x0F),
+                      _bp_kind_name(kind), name, _bp_role_name(role));
+        return false;
+    }
+    owner[pin] = me;
+    g_pin_caps[cap] |= (BoardPinMask)1 << pin;
+    return true;
+}
+
+static bool _bp_build_pin_caps() {
+    uint16_t owner[BOARD_PIN_SPACE] = {0};
+    memset(g_pin_caps, 0, sizeof(g_pin_caps));
+    bool ok = true;
+
+    for (uint8_t i = 0; i < g_board_pin_count; ++i) {
+        const BoardPin &bp = g_board_pins[i];
+        ok &= _bp_claim(owner, bp.pin, BK_GPIO, 0, PR_PIN, bp.name,
+                        bp.mode == OUTPUT ? PC_OUTPUT : PC_INPUT);
+        if (bp.inverted && bp.pin < BOARD_PIN_SPACE)
+            g_pin_caps[PC_INVERTED] |= (BoardPinMask)1 << bp.pin;
+    }
+    for (uint8_t i = 0; i < g_board_serial_count; ++i) {
+        const BoardSerial &bs = g_board_serials[i];
+        ok &= _bp_claim(owner, bs.rx_pin, BK_SERIAL, bs.port_num, PR_RX, bs.name, PC_BUS);
+        ok &= _bp_claim(owner, bs.tx_pin, BK_SERIAL, bs.port_num, PR_TX, bs.name, PC_BUS);
+    }
+    for (uint8_t i = 0; i < g_board_adc_count; ++i)
+        ok &= _bp_claim(owner, g_board_adc[i].pin, BK_ADC, 0, PR_PIN, g_board_adc[i].name, PC_ADC);
+    for (uint8_t i = 0; i < g_board_i2c_count; ++i) {
+        const BoardI2C &bi = g_board_i2c[i];
+        ok &= _bp_claim(owner, bi.sda, BK_I2C, bi.bus, PR_SDA, bi.name, PC_BUS);
+        ok &= _bp_claim(owner, bi.scl, BK_I2C, bi.bus, PR_SCL, bi.name, PC_BUS);
+    }
+    for (uint8_t i = 0; i < g_board_spi_count; ++i) {
+        const BoardSPI &bs = g_board_spi[i];
+        ok &= _bp_claim(owner, bs.mosi, BK_SPI, bs.bus, PR_MOSI, bs.name, PC_BUS);
+        ok &= _bp_claim(owner, bs.miso, BK_SPI, bs.bus, PR_MISO, bs.name, PC_BUS);
+        ok &= _bp_claim(owner, bs.sck,  BK_SPI, bs.bus, PR_SCK,  bs.name, PC_BUS);
+        ok &= _bp_claim(owner, bs.cs,   BK_SPI, bs.bus, PR_CS,   bs.name, PC_BUS);
+    }
+    for (uint8_t i = 0; i < g_board_servo_count; ++i)
+        ok &= _bp_claim(owner, g_board_servos[i].pin, BK_SERVO, 0, PR_PIN, g_board_servos[i].name, PC_SERVO);
+    for (uint8_t i = 0; i < g_board_pwm_count; ++i)
+        ok &= _bp_claim(owner, g_board_pwm[i].pin, BK_PWM, 0, PR_PIN, g_board_pwm[i].name, PC_PWM);
+
+    return ok;
+}
+
 /*
 * ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
 *                      Markdown parser
 * ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
 * Parse a CONTROL.md string into g_board_pins[], g_board_serials[] and
 * g_board_adc[]. Resets all counters before parsing.
-* Returns true if at least one pin/port was successfully parsed.
+* Returns true if at least one pin/port was successfully parsed; on false
+* the tables, name index and g_pin_caps are left empty, never half-built.
 *
 * Parser is deliberately forgiving:
 *   • Unknown ## sections are silently skipped.
 *   • Rows with missing mandatory cells (Pin, Name) are skipped.
 *   • Rows beyond MAX_BOARD_* limits are skipped with warning.
+* Hard errors return false after listing every clash:
+*   • a name declared twice (in any sections), and
+*   • a physical pin claimed by two roles (e.g. GPIO and I2C SDA).
 */
-static bool board_parse_md(const char *md) {
+static void _bp_clear() {
     g_board_pin_count    = 0;
     g_board_serial_count = 0;
     g_board_adc_count    = 0;
@@ -525,6 +816,12 @@ static bool board_parse_md(const char *md) {
     g_board_spi_count    = 0;
     g_board_servo_count  = 0;
     g_board_pwm_count    = 0;
+    g_board_name_count   = 0;
+    memset(g_pin_caps, 0, sizeof(g_pin_caps));
+}
+
+static bool board_parse_md(const char *md) {
+    _bp_clear();
 
     enum Section {
         SEC_NONE, SEC_GPIO, SEC_SERIAL, SEC_ADC,
@@ -702,7 +999,7 @@ static bool board_parse_md(const char *md) {
                             BoardSPI &bs = g_board_spi[g_board_spi_count++];
                             bs.bus  = _bp_parse_bus(c0);
                             bs.mosi = (uint8_t)atoi(c1);
-                            bs.miso = (uint8_t)atoi(c2);
+                            bs.miso = c2[0] ? (uint8_t)atoi(c2) : BOARD_PIN_NONE;
                             bs.sck  = (uint8_t)atoi(c3);
                             bs.cs   = (uint8_t)atoi(c4);
                             strlcpy(bs.name, c5, sizeof(bs.name));
@@ -773,18 +1070,187 @@ static bool board_parse_md(const char *md) {
                   g_board_i2c_count,  g_board_spi_count,
                   g_board_servo_count, g_board_pwm_count);
 
+    // Duplicate names would make name → pin resolution ambiguous : reject.
+    if (!_bp_build_name_index()) {
+        Serial.println("[Board] ERROR: names must be unique across all sections.");
+        _bp_clear();
+        return false;
+    }
+    // A physical pin may only serve one role (shared bus lines excepted).
+    if (!_bp_build_pin_caps()) {
+        Serial.println("[Board] ERROR: pin conflicts between sections.");
+        _bp_clear();
+        return false;
+    }
+
     return (g_board_pin_count + g_board_serial_count + g_board_adc_count +
             g_board_i2c_count  + g_board_spi_count   +
             g_board_servo_count + g_board_pwm_count) > 0;
 }
 
 
+/*
+* ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+*                        Fast GPIO driver
+* ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+* All writes take LOGICAL values (1 = ON). Inversion is applied from the
+* PC_INVERTED mask built at parse time, so active-LOW relays behave like
+* every other output and no per-call table scan is needed.
+*
+* gpio_write_mask() drives every pin in `mask` in one go:
+*   ESP32   — one write to GPIO_OUT_W1TS (pins going HIGH) and one to
+*             GPIO_OUT_W1TC (pins going LOW), plus the OUT1 bank for
+*             GPIO32+ on ESP32/S3. Pins switching the same direction
+*             change on the same bus cycle.
+*   Pico W  — a single gpio_put_masked() SIO write covers all pins.
+*   other   — digitalWrite() fallback.
+*
+* Pins must already be configured OUTPUT (board_init_hardware()).
+*/
+static void _gpio_write_mask(BoardPinMask mask, BoardPinMask inv, bool logical) {
+    inv &= mask;
+    BoardPinMask high = logical ? (mask & ~inv) : inv;
+    BoardPinMask low  = mask & ~high;
+
+#if defined(BOARD_ESP32)
+    if ((uint32_t)high) REG_WRITE(GPIO_OUT_W1TS_REG, (uint32_t)high);
+    if ((uint32_t)low)  REG_WRITE(GPIO_OUT_W1TC_REG, (uint32_t)low);
+  #if defined(GPIO_OUT1_W1TS_REG) && BOARD_PIN_SPACE > 32
+    if ((uint32_t)(high >> 32)) REG_WRITE(GPIO_OUT1_W1TS_REG, (uint32_t)(high >> 32));
+    if ((uint32_t)(low  >> 32)) REG_WRITE(GPIO_OUT1_W1TC_REG, (uint32_t)(low  >> 32));
+  #endif
+#elif defined(BOARD_PICO_W)
+    gpio_put_masked((uint32_t)mask, (uint32_t)high);
+#else
+    for (uint8_t p = 0; p < BOARD_PIN_SPACE; ++p)
+        if ((mask >> p) & 1) digitalWrite(p, ((high >> p) & 1) ? HIGH : LOW);
+#endif
+}
+
+static void gpio_write_mask(BoardPinMask mask, bool logical) {
+    _gpio_write_mask(mask, g_pin_caps[PC_INVERTED], logical);
+}
+
+// gpio_write : single-pin logical write.
+static inline void gpio_write(uint8_t pin, bool logical) {
+    if (pin >= BOARD_PIN_SPACE) return;
+    gpio_write_mask((BoardPinMask)1 << pin, logical);
+}
+
+// gpio_read : logical level of a pin (inverted pins report 1 when LOW).
+static inline int gpio_read(uint8_t pin) {
+    int phy = digitalRead(pin);
+    return board_is_inverted_pin(pin) ? !phy : phy;
+}
+
+/*
+* ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+*                        Serial RX rings
+* ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+* Every declared UART gets a ring that is filled in the background, so
+* bytes arriving between LLM actions are kept instead of being lost when
+* the hardware FIFO overflows.
+*
+* Single-producer / single-consumer:
+*   ESP32  — producer is the core's UART event task: the onReceive and
+*            onReceiveError callbacks run there, concurrently with the
+*            reader on the loop() core (serialised against each other)
+*   Pico W — the core's UART IRQ fills its FIFO; board_serial_poll() in
+*            loop() moves it into the ring so lines get framed and stamped
+* Consumer is always the main loop. Every field has one writer: head,
+* nl_in, stamp and first_ms belong to the producer, tail, nl_out and
+* read_ms to the consumer; overflow is only ever fetch_add'ed. A full ring
+* drops new bytes and counts them in overflow rather than overwriting data
+* the reader may be copying.
+*/
+static constexpr uint8_t SERIAL_RX_STAMPS = 8;   // line-end timestamps kept
+
+struct BoardSerialRx {
+    char     buf[SERIAL_RX_RING];
+    std::atomic<uint16_t> head;          // free-running write index (producer)
+    std::atomic<uint16_t> tail;          // free-running read index  (consumer)
+    std::atomic<uint32_t> nl_in;         // '\n' bytes stored        (producer)
+    uint32_t nl_out;                     // '\n' bytes consumed      (consumer)
+    uint32_t stamp[SERIAL_RX_STAMPS];    // millis() of recent line ends
+    volatile uint32_t first_ms;          // arrival of oldest byte in an empty ring
+    uint32_t read_ms;                    // millis() of the last read  (consumer)
+    std::atomic<uint32_t> overflow;      // bytes / FIFO overruns dropped
+};
+static BoardSerialRx g_board_rx[MAX_BOARD_SERIALS];
+
+static void _bp_rx_clear(uint8_t i) {
+    BoardSerialRx &rx = g_board_rx[i];
+    rx.head.store(0);  rx.tail.store(0);
+    rx.nl_in.store(0); rx.nl_out = 0;
+    rx.overflow.store(0);
+    rx.first_ms = 0;   rx.read_ms = 0;
+}
+
+/*
+* Drain the driver buffer into the ring (producer side). Line ends publish
+* head before bumping nl_in so the reader never sees a line it can't copy.
+*/
+static void board_serial_pump(uint8_t i) {
+    if (i >= g_board_serial_count) return;
+    HardwareSerial *hs = board_get_uart(g_board_serials[i].port_num);
+    if (!hs) return;
+    BoardSerialRx &rx = g_board_rx[i];
+
+#if defined(BOARD_PICO_W)
+    if (static_cast<SerialUART *>(hs)->overflow())
+        rx.overflow.fetch_add(1, std::memory_order_relaxed);
+#endif
+
+    uint16_t h   = rx.head.load(std::memory_order_relaxed);
+    uint16_t t   = rx.tail.load(std::memory_order_acquire);
+    uint32_t now = millis();
+    while (hs->available()) {
+        char c = (char)hs->read();
+        if ((uint16_t)(h - t) >= SERIAL_RX_RING) {
+            t = rx.tail.load(std::memory_order_acquire);
+            if ((uint16_t)(h - t) >= SERIAL_RX_RING) {
+                rx.overflow.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+        }
+        if (h == t) rx.first_ms = now;
+        rx.buf[h & (SERIAL_RX_RING - 1)] = c;
+        ++h;
+        if (c == '\n') {
+            rx.head.store(h, std::memory_order_release);
+            uint32_t nl = rx.nl_in.load(std::memory_order_relaxed);
+            rx.stamp[nl % SERIAL_RX_STAMPS] = now;
+            rx.nl_in.store(nl + 1, std::memory_order_release);
+        }
+    }
+    rx.head.store(h, std::memory_order_release);
+}
+
+// Pico W: called every loop() pass. ESP32 fills rings from the UART task.
+static void board_serial_poll() {
+#if defined(BOARD_PICO_W)
+    for (uint8_t i = 0; i < g_board_serial_count; ++i) board_serial_pump(i);
+#endif
+}
+
+// Complete lines still waiting, and bytes dropped since boot / board push.
+static uint16_t board_serial_lines(int i) {
+    if (i < 0 || i >= g_board_serial_count) return 0;
+    return (uint16_t)(g_board_rx[i].nl_in.load(std::memory_order_acquire) - g_board_rx[i].nl_out);
+}
+
+static uint32_t board_serial_overflow(int i) {
+    if (i < 0 || i >= g_board_serial_count) return 0;
+    return g_board_rx[i].overflow.load(std::memory_order_relaxed);
+}
+
 /*
 * ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
 *                        Hardware controls
 * ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
 * Configure all declared GPIO pins and UART ports.
-* All OUTPUT pins are driven LOW at startup (safe default).
+* All OUTPUT pins are driven logically OFF at startup (safe default):
+* LOW for normal pins, HIGH for `inverted` (active-LOW) pins.
 *
 * ESP32 (all variants):
 *   Serial1.begin(baud, SERIAL_8N1, rx, tx) — pins passed directly.
@@ -801,7 +1267,7 @@ static void board_init_hardware() {
     for (uint8_t i = 0; i < g_board_pin_count; ++i) {
         const BoardPin &bp = g_board_pins[i];
         pinMode(bp.pin, bp.mode);
-        if (bp.mode == OUTPUT) digitalWrite(bp.pin, LOW);
+        if (bp.mode == OUTPUT) gpio_write(bp.pin, false);
         Serial.printf("[Board] GPIO %-2u  [%-14s]  '%s'\r\n",
                       bp.pin, _bp_mode_name(bp.mode), bp.name);
     }
@@ -812,16 +1278,30 @@ static void board_init_hardware() {
         HardwareSerial *hs = board_get_uart(bs.port_num);
         if (!hs) continue;
 
+        _bp_rx_clear(i);
+
 #if defined(BOARD_ESP32)
         // ESP32 Arduino core: pin numbers are passed directly into begin().
+        // RX buffer size must be set before begin() (the core refuses to
+        // resize a running port, hence end() in board_reset_hardware). The
+        // callbacks run in the core's UART event task on every FIFO-full /
+        // RX-timeout IRQ, concurrently with board_serial_read() on loop().
+        hs->setRxBufferSize(SERIAL_RX_RING);
         hs->begin(bs.baud, SERIAL_8N1, bs.rx_pin, bs.tx_pin);
+        hs->onReceive([i]() { board_serial_pump(i); });
+        hs->onReceiveError([i](hardwareSerial_error_t e) {
+            if (e == UART_BUFFER_FULL_ERROR || e == UART_FIFO_OVF_ERROR)
+                g_board_rx[i].overflow.fetch_add(1, std::memory_order_relaxed);
+        });
 
 #elif defined(BOARD_PICO_W)
         // Pico W : MUST assign pins before begin().
-        // setRX/setTX accept the GP number (0-29).
+        // setRX/setTX accept the GP number (0-29). The core's UART IRQ fills
+        // a software FIFO of this size; board_serial_poll() frames it.
         SerialUART *su = static_cast<SerialUART *>(hs);
         su->setRX(bs.rx_pin);
         su->setTX(bs.tx_pin);
+        su->setFIFOSize(SERIAL_RX_RING);      // also only before begin()
         su->begin(bs.baud);
 #endif
 
@@ -852,9 +1332,11 @@ static int board_serial_write(int serial_index, const char *data) {
 * ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
 *                        Serial Read
 * ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
-* Read up to (cap-1) bytes from a named UART port into buf, waiting at most
-* timeout_ms for data to arrive. Null-terminates the result.
-* Returns number of bytes read.
+* Return the oldest complete line (CR/LF stripped) from the port's RX ring,
+* or the buffered partial line if no '\n' has arrived yet. Only waits (up
+* to timeout_ms) when the ring is completely empty, e.g. serial_write
+* immediately followed by serial_read in the same reply. *age_ms gets how
+* long ago the returned data arrived. Returns number of bytes copied.
 *
 ***** USB-CDC keepalive *****
 * On native USB boards (C3) the host drops the COM port after ~500 ms of
@@ -866,25 +1348,49 @@ static int board_serial_write(int serial_index, const char *data) {
 * Called by execute_actions_in_response() for [ACTION:serial_read ...].
 */
 static uint8_t board_serial_read(int serial_index, char *buf, uint8_t cap,
-                                  uint32_t timeout_ms = 150) {
+                                  uint32_t timeout_ms = 150,
+                                  uint32_t *age_ms = nullptr) {
     // Hard cap: never block > 150 ms (USB-CDC keepalive safety)
     if (timeout_ms > 150) timeout_ms = 150;
+    if (age_ms) *age_ms = 0;
     if (serial_index < 0 || serial_index >= g_board_serial_count ||
         cap == 0) { if (cap) buf[0] = '\0'; return 0; }
 
-    HardwareSerial *hs = board_get_uart(g_board_serials[serial_index].port_num);
-    if (!hs) { buf[0] = '\0'; return 0; }
+    BoardSerialRx &rx = g_board_rx[serial_index];
+    uint16_t t = rx.tail.load(std::memory_order_relaxed);
+    uint16_t h = rx.head.load(std::memory_order_acquire);
 
-    uint8_t n = 0;
+    // Only an empty ring waits : buffered data is returned at once.
     unsigned long t0 = millis();
-    while ((millis() - t0) < timeout_ms && n + 1 < cap) {
-        if (hs->available()) {
-            buf[n++] = (char)hs->read();
-        } else {
-            delay(1);
-        }
+    while (h == t && (millis() - t0) < timeout_ms) {
+        delay(1);
+#if defined(BOARD_PICO_W)
+        board_serial_pump((uint8_t)serial_index);
+#endif
+        h = rx.head.load(std::memory_order_acquire);
+    }
+
+    uint8_t n = 0;
+    bool    eol = false;
+    uint32_t first = rx.first_ms;
+    while (t != h && n + 1 < cap) {
+        char c = rx.buf[t & (SERIAL_RX_RING - 1)];
+        ++t;
+        if (c == '\n') { eol = true; break; }
+        if (c != '\r') buf[n++] = c;
     }
+    if (eol) ++rx.nl_out;
+    rx.tail.store(t, std::memory_order_release);
     buf[n] = '\0';
+
+    if (age_ms && (n || eol)) {
+        // first_ms only moves when a byte lands in an empty ring; a byte
+        // left over by the previous read is at least as fresh as that read.
+        if ((int32_t)(rx.read_ms - first) > 0) first = rx.read_ms;
+        uint32_t at = eol ? rx.stamp[(rx.nl_out - 1) % SERIAL_RX_STAMPS] : first;
+        *age_ms = millis() - at;
+    }
+    rx.read_ms = millis();
     return n;
 }
 
@@ -892,24 +1398,63 @@ static uint8_t board_serial_read(int serial_index, char *buf, uint8_t cap,
 * ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
 *                        Hardware reset
 * ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
-* Drive all OUTPUT pins LOW and clear all parsed state.
+* Drive all OUTPUT pins logically OFF and clear all parsed state.
 * Servo detach and PWM channel release are handled in fc_actions.h
 * (board_reset_peripherals) which is called from the shell reset handler.
+*
+* A board push parses the new config over the tables the running hardware
+* was set up from, so it takes a BoardHwSnap of what the resets need first
+* and releases that (board_release_hardware / _peripherals) once the new
+* config is accepted.
 */
-static void board_reset_hardware() {
-    for (uint8_t i = 0; i < g_board_pin_count; ++i)
-        if (g_board_pins[i].mode == OUTPUT)
-            digitalWrite(g_board_pins[i].pin, LOW);
+struct BoardHwSnap {
+    BoardPinMask out, inv;
+    uint8_t      serial_count;
+    uint8_t      serial_port[MAX_BOARD_SERIALS];
+    uint8_t      servo_count;
+    uint8_t      pwm_count;
+    uint8_t      pwm_pin[MAX_BOARD_PWM];
+    uint8_t      pwm_channel[MAX_BOARD_PWM];
+    bool         pwm_active[MAX_BOARD_PWM];
+};
 
-    g_board_pin_count    = 0;
-    g_board_serial_count = 0;
-    g_board_adc_count    = 0;
-    g_board_i2c_count    = 0;
-    g_board_spi_count    = 0;
-    g_board_servo_count  = 0;
-    g_board_pwm_count    = 0;
+static void board_hw_snapshot(BoardHwSnap &s) {
+    s.out          = g_pin_caps[PC_OUTPUT];
+    s.inv          = g_pin_caps[PC_INVERTED];
+    s.serial_count = g_board_serial_count;
+    for (uint8_t i = 0; i < g_board_serial_count; ++i) s.serial_port[i] = g_board_serials[i].port_num;
+    s.servo_count  = g_board_servo_count;
+    s.pwm_count    = g_board_pwm_count;
+    for (uint8_t i = 0; i < g_board_pwm_count; ++i) {
+        s.pwm_pin[i]     = g_board_pwm[i].pin;
+        s.pwm_channel[i] = g_board_pwm[i].channel;
+        s.pwm_active[i]  = g_board_pwm[i].active;
+    }
+}
+
+static void board_release_hardware(const BoardHwSnap &s) {
+    _gpio_write_mask(s.out, s.inv, false);
+
+    // Stop the UARTs so the next board_init_hardware() sizes their buffers
+    // before begin() again. ESP32: detach the RX callbacks first, before
+    // the ring indices they capture go stale.
+    for (uint8_t i = 0; i < s.serial_count; ++i) {
+        HardwareSerial *hs = board_get_uart(s.serial_port[i]);
+        if (!hs) continue;
+#if defined(BOARD_ESP32)
+        hs->onReceive(nullptr); hs->onReceiveError(nullptr);
+#endif
+        hs->end();
+    }
+}
+
+static void board_reset_hardware() {
+    BoardHwSnap s;
+    board_hw_snapshot(s);
+    board_release_hardware(s);
+    _bp_clear();
 
-    Serial.println("[Board] Hardware reset — all outputs LOW, config cleared.");
+    Serial.println("[Board] Hardware reset — all outputs OFF, config cleared.");
 }
 
 
@@ -12,6 +12,14 @@ struct ChannelCfg {
   uint8_t allow_count;
 };
 
+// One row of the Discord channel table. Its polling cursor lives next to
+// the other cursors (persist.h, g_dc_cursor[]) because it changes often.
+struct DcChannel {
+  char    id[ALLOW_ID_LEN];
+  uint8_t allow;      // bit i → discord.allow_from[i] may talk here; 0 = the whole list
+  uint8_t session;    // conversation slot; channels on the same slot share history
+};
+
 struct Config {
   char wifi_ssid[CFG_S];
   char wifi_pass[CFG_S];
@@ -23,10 +31,15 @@ struct Config {
   float    temperature;
   uint8_t  max_tool_iters;
   uint32_t heartbeat_ms;
+  bool     stream_replies;             // progressive replies: placeholder, then edits (live.h)
+  char     api_host[CFG_S];            // "host:port" : Telegram / Discord REST over plain HTTP there (http.h)
   ChannelCfg telegram;
+  uint16_t   tg_webhook_port;          // 0 = long polling, else webhook listener port
+  char       tg_webhook_secret[64];    // X-Telegram-Bot-Api-Secret-Token, "" = not checked
   ChannelCfg discord;
-  char discord_channel_id[ALLOW_ID_LEN];
-  char       board_md[4096];
+  DcChannel  dc_ch[DC_CHANNELS_MAX];   // empty table = every channel the bot can read
+  uint8_t    dc_ch_count;
+  char       board_md[BOARD_MD_S];
   bool       board_md_loaded;
 };
 
@@ -1,21 +1,102 @@
 #pragma once
 
+// ─── Memory profile ──────────────────────────────────────────────────────────
+/*
+*   The big static buffers, sized per board by one build flag
+*   (platformio.ini envs):
+*
+*                      TINY    DEFAULT   PSRAM
+*     HTTP_RESP_S      4096     8192    16384   response buffer (shared, see http.h)
+*     JSON_OUT_S       6144     8192    16384   request body: system prompt + board + history
+*     SESSION_S        2048     4096     8192   conversation history
+*     BOARD_MD_S       3072     4096     8192   [CONTROL].md, stored in g_cfg
+*     RESP_S           1536     2048     4096   one reply, inbox / outbox entries
+*     TG_POLL_RESP_S   3072     4096     8192   Telegram long poll (its own buffer)
+*     DC_GW_FRAME_S    3072     4096     8192   Discord Gateway event
+*     TLS_IDLE_MAX        1        2        3   idle keep-alive TLS sessions left open
+*
+*   FC_PROFILE_TINY    ESP32-C3 and other parts where TLS needs every KB of heap
+*   FC_PROFILE_DEFAULT everything else (also when no profile is given)
+*   FC_PROFILE_PSRAM   ESP32-S3 / WROVER with PSRAM; the buffers go to PSRAM
+*                      where the SDK allows .bss there (FC_EXT_BSS, platform.h)
+*
+*   bench/bss_report.py compares the link maps of two builds.
+*/
+#if defined(FC_PROFILE_TINY)
+  #define FC_PROFILE_NAME "tiny"
+static constexpr uint16_t HTTP_RESP_S       = 4096;
+static constexpr uint16_t JSON_OUT_S        = 6144;
+static constexpr uint16_t SESSION_S         = 2048;
+static constexpr uint16_t BOARD_MD_S        = 3072;
+static constexpr uint16_t RESP_S            = 1536;
+static constexpr uint16_t TG_POLL_RESP_S    = 3072;
+static constexpr uint16_t DC_GW_FRAME_S     = 3072;
+static constexpr uint8_t  TLS_IDLE_MAX      = 1;
+#elif defined(FC_PROFILE_PSRAM)
+  #define FC_PROFILE_NAME "psram"
+static constexpr uint16_t HTTP_RESP_S       = 16384;
+static constexpr uint16_t JSON_OUT_S        = 16384;
+static constexpr uint16_t SESSION_S         = 8192;
+static constexpr uint16_t BOARD_MD_S        = 8192;
+static constexpr uint16_t RESP_S            = 4096;
+static constexpr uint16_t TG_POLL_RESP_S    = 8192;
+static constexpr uint16_t DC_GW_FRAME_S     = 8192;
+static constexpr uint8_t  TLS_IDLE_MAX      = 3;
+#else
+  #define FC_PROFILE_NAME "default"
+static constexpr uint16_t HTTP_RESP_S       = 8192;  // raised if needed but not recommended for long responses + headers
+static constexpr uint16_t JSON_OUT_S        = 8192;
+static constexpr uint16_t SESSION_S         = 4096;
+static constexpr uint16_t BOARD_MD_S        = 4096;
+static constexpr uint16_t RESP_S            = 2048;
+static constexpr uint16_t TG_POLL_RESP_S    = 4096;  // long-poll response buffer
+static constexpr uint16_t DC_GW_FRAME_S     = 4096;  // Gateway message buffer; longer events are truncated
+static constexpr uint8_t  TLS_IDLE_MAX      = 2;     // see "TLS session budget" in http.h
+#endif
+// Board push (push.h): decoded / received straight into g_cfg.board_md.
+static constexpr uint32_t PUSH_IDLE_MS      = 10000; // a push with no chunk for this long is dropped
+// Binary board push (push.h): frames of PUSH_FRAME_DATA file bytes, at most
+// PUSH_WINDOW of them unacknowledged; SHELL_RX_S holds a full window.
+static constexpr uint16_t PUSH_FRAME_DATA   = 128;
+static constexpr uint8_t  PUSH_WINDOW       = 8;
+static constexpr uint16_t SHELL_RX_S        = PUSH_WINDOW * (PUSH_FRAME_DATA + 16);
+
 static constexpr uint32_t UART_BAUD         = 115200;
 static constexpr uint32_t HTTP_TIMEOUT_MS   = 60000;
-static constexpr uint32_t TG_POLL_MS        = 5000;
-static constexpr uint32_t DC_POLL_MS        = 5000;
+static constexpr uint32_t TG_POLL_MS        = 5000;   // short-poll interval after idle / error back-off base
+static constexpr uint32_t TG_POLL_MIN_MS    = 1000;   // short-poll interval right after activity
+static constexpr uint32_t TG_POLL_MAX_MS    = 60000;  // short-poll / back-off ceiling
+static constexpr uint8_t  TG_LONG_POLL_S    = 25;     // getUpdates timeout; 0 = short polling only
+static constexpr uint32_t DC_POLL_MS        = 5000;   // REST polling, only while the Gateway is unavailable
+static constexpr uint32_t DC_POLL_IDLE_MS   = 60000;  // REST polling: ceiling for a channel with no traffic
+static constexpr uint32_t DC_CURSOR_FLUSH_MS = 60000; // Gateway cursor moves: at most one flash write per this
+static constexpr uint8_t  DC_CHANNELS_MAX   = 4;      // Discord channel table
 static constexpr uint16_t TG_MSG_CHUNK      = 3800;
 static constexpr uint16_t DC_MSG_CHUNK      = 1800;
 static constexpr uint16_t TLS_SETTLE_MS     = 100;
 static constexpr uint16_t CHUNK             = 512;
 static constexpr uint16_t CFG_S             = 128;
 static constexpr uint16_t LLM_KEY           = 256;
-static constexpr uint16_t RESP_S            = 2048;
 static constexpr uint16_t PROMPT_S          = 1024;
-static constexpr uint16_t JSON_OUT_S        = 8192;
-static constexpr uint16_t HTTP_RESP_S       = 8192;  // raised if needed but not recommended for long responses + headers
+static constexpr uint16_t LLM_SSE_LINE      = 1024;  // one streamed event ("data: {...}"); longer ones are cut
+static constexpr uint32_t LIVE_TG_EDIT_MS   = 1500;  // progressive replies: min gap between edits
+static constexpr uint32_t LIVE_DC_EDIT_MS   = 1200;
 static constexpr uint16_t CMD_S             = 256;
-static constexpr uint16_t SESSION_S         = 4096;
+static constexpr uint32_t HEAP_REBOOT_MIN   = 120000; // llm_chat reboots below this free heap; see 'mem'
+static constexpr uint32_t TLS_HS_HEAP       = 40000;  // handshake headroom wanted above it until 'mem' has measured one
+static constexpr uint16_t CFG_JSON_S        = 2048;  // LittleFS config file (Pico W)
+// Scratch arena (arena.h). Deepest nesting: agent_run prompt + tool args →
+// set_config → cfg_save's JSON (LittleFS only), plus headers and slack; or
+// an outbox chunk with its send path and auth (msgq.h), whichever is more.
+#ifdef FC_ARENA_S
+static constexpr uint16_t ARENA_S           = FC_ARENA_S;
+#else
+static constexpr uint16_t ARENA_AGENT_S     = PROMPT_S + 512 + 512 + 256 + (PERSIST_IMPL == 2 ? CFG_JSON_S : 0);
+static constexpr uint16_t ARENA_OUT_S       = TG_MSG_CHUNK + 512;
+static constexpr uint16_t ARENA_S           = ARENA_AGENT_S > ARENA_OUT_S ? ARENA_AGENT_S : ARENA_OUT_S;
+#endif
+static constexpr uint8_t  INBOX_Q           = 4;     // channel → agent messages (power of two)
+static constexpr uint8_t  OUTBOX_Q          = 2;     // agent → channel replies, per channel (power of two)
 static constexpr uint8_t  ALLOW_LIST_MAX    = 8;
 /*
 *   ID buffer size: must hold the largest possible string representation of any
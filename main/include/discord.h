@@ -1,105 +1,211 @@
 /*
  * ─────────────────────────────────────────────────────────────
- * FemtoClaw : Discord HTTP REST polling channel.
+ * FemtoClaw : Discord REST channel.
  *
- * Depends on: http.h, agent.h, config.h, json.h, persist.h
+ * Messages normally arrive over the Gateway (discord_gw.h); dc_poll()
+ * REST-polls the channel table only while the Gateway is unavailable.
+ * Both only parse messages into the inbox (msgq.h); replies are packed,
+ * paced and retried by outbox_task, which calls dc_send_chunk().
+ *
+ * Depends on: http.h, msgq.h, config.h, json.h, persist.h
  * ─────────────────────────────────────────────────────────────
  */
 
 #pragma once
 
-static uint32_t g_dc_last_ms = 0;
-
-// ─── dc_send ──────────────────────────────────────────────────────────────────
-static int16_t dc_send(const char *text) {
-    if (!g_cfg.discord_channel_id[0]) return 0;
-
-    static char dc_esc[4096];
-    static char dc_auth[CFG_S + 32];
-    static char dc_path[CFG_S];
-    static char dc_body[4096];
-
-    snprintf(dc_auth, sizeof(dc_auth), "Authorization: Bot %s\r\n", g_cfg.discord.token);
-    snprintf(dc_path, CFG_S, "/api/v10/channels/%s/messages", g_cfg.discord_channel_id);
-
-    uint16_t tlen = strlen(text);
-    int16_t last_code = 0;
-    uint16_t sent = 0;
-    while (sent < tlen) {
-        uint16_t chunk = min((uint16_t)(tlen - sent), DC_MSG_CHUNK);
-        json_escape(text + sent, chunk, dc_esc, JSON_OUT_S);
-        sent += chunk;
-        snprintf(dc_body, JSON_OUT_S, "{\"content\":\"%s\"}", dc_esc);
-
-        g_suppress_tls_logs = true;
-        g_http_busy = true;
-        last_code = https_req(g_tls_dc, "discord.com", dc_path, dc_auth,
-                              dc_body, strlen(dc_body), g_http_resp, HTTP_RESP_S);
-        g_http_busy = false;
-        g_suppress_tls_logs = false;
-
-        Serial.printf("[Discord] send code=%d\r\n", last_code);
-    }
-    return last_code;
-}
+// ─── dc_send_chunk ────────────────────────────────────────────────────────────
+// One create-message request; text is already cut to DC_MSG_CHUNK by
+// msgq.h. The JSON body is built in g_tx_body (see tg_send_chunk).
+static int16_t dc_send_chunk(const char *channel, const char *text, HttpMeta *meta) {
+    if (!channel[0]) return 0;
 
-// ─── dc_poll ──────────────────────────────────────────────────────────────────
-static void dc_poll() {
-    if (!g_cfg.discord.enabled || !g_cfg.discord.token[0]) return;
-    if (!g_cfg.discord_channel_id[0]) return;
-    if ((millis() - g_dc_last_ms) < DC_POLL_MS) return;
-    if (g_http_busy) return;
-    g_dc_last_ms = millis();
-
-    static char dc_poll_auth[CFG_S + 32];
-    static char dc_poll_path[CFG_S];
-    snprintf(dc_poll_auth, sizeof(dc_poll_auth), "Authorization: Bot %s\r\n", g_cfg.discord.token);
-
-    if (g_dc_last_msg_id[0])
-        snprintf(dc_poll_path, CFG_S, "/api/v10/channels/%s/messages?after=%s&limit=5",
-                 g_cfg.discord_channel_id, g_dc_last_msg_id);
-    else
-        snprintf(dc_poll_path, CFG_S, "/api/v10/channels/%s/messages?limit=1",
-                 g_cfg.discord_channel_id);
+    ArenaScope scope;
+    char *dc_auth = arena_alloc(CFG_S + 32);
+    char *dc_path = arena_alloc(CFG_S);
+    if (!dc_auth || !dc_path) return -1;
+    snprintf(dc_auth, CFG_S + 32, "Authorization: Bot %s\r\n", g_cfg.discord.token);
+    snprintf(dc_path, CFG_S, "/api/v10/channels/%s/messages", channel);
+
+    uint16_t n = strlcpy(g_tx_body, "{\"content\":\"", JSON_OUT_S);
+    n += json_escape_into(g_tx_body + n, JSON_OUT_S - n - 2, text);
+    g_tx_body[n++] = '"';
+    g_tx_body[n++] = '}';
+    g_tx_body[n]   = '\0';
 
     g_suppress_tls_logs = true;
-    g_http_busy = true;
-    int16_t code = https_req(g_tls_dc, "discord.com", dc_poll_path, dc_poll_auth,
-                              nullptr, 0, g_http_resp, HTTP_RESP_S);
-    g_http_busy = false;
+    int16_t code = https_req(g_tls_dc, "discord.com", dc_path, dc_auth,
+                             g_tx_body, n, g_http_resp, HTTP_RESP_S, meta);
     g_suppress_tls_logs = false;
 
-    if (code != 200) {
-        Serial.printf("[Discord] poll code=%d\r\n", code);
-        return;
+    Serial.printf("[Discord] send code=%d%s\r\n", code,
+                  meta && meta->reused ? " (warm)" : "");
+    return code;
+}
+
+/*
+ * ─── Channel table ───────────────────────────────────────────────────────────
+ *
+ * g_cfg.dc_ch lists the channels to answer in (empty: every channel the bot
+ * can read, and DMs). Each row has its own allow mask over
+ * discord.allow_from, a conversation slot (llm.h session_bind) and a REST
+ * cursor in g_dc_cursor[]. g_dc_stat[] is runtime only.
+ */
+struct DcChanStat {
+    uint32_t msgs;            // messages queued for the agent
+    uint32_t polls;           // REST polls (fallback)
+    uint32_t last_ms;         // millis() of the last message
+    uint32_t due_ms;          // REST: next poll
+    uint32_t interval_ms;     // REST: current interval, DC_POLL_MS … DC_POLL_IDLE_MS
+    uint32_t lat_n, lat_sum, lat_max;   // reply latency, inbox → delivered
+};
+
+static DcChanStat g_dc_stat[DC_CHANNELS_MAX] = {};
+
+static int8_t dc_chan_find(const char *id) {
+    for (uint8_t i = 0; i < g_cfg.dc_ch_count; ++i)
+        if (!strcmp(g_cfg.dc_ch[i].id, id)) return (int8_t)i;
+    return -1;
+}
+
+// Returns the row, or -1 when the table is full.
+static int8_t dc_chan_add(const char *id) {
+    int8_t i = dc_chan_find(id);
+    if (i >= 0) return i;
+    if (g_cfg.dc_ch_count >= DC_CHANNELS_MAX) return -1;
+    i = (int8_t)g_cfg.dc_ch_count++;
+    memset(&g_cfg.dc_ch[i], 0, sizeof(DcChannel));
+    strlcpy(g_cfg.dc_ch[i].id, id, ALLOW_ID_LEN);
+    g_dc_cursor[i][0] = '\0';
+    memset(&g_dc_stat[i], 0, sizeof(DcChanStat));
+    return i;
+}
+
+static bool dc_chan_remove(const char *id) {
+    int8_t i = dc_chan_find(id);
+    if (i < 0) return false;
+    for (uint8_t k = i; k + 1 < g_cfg.dc_ch_count; ++k) {
+        g_cfg.dc_ch[k] = g_cfg.dc_ch[k + 1];
+        memcpy(g_dc_cursor[k], g_dc_cursor[k + 1], ALLOW_ID_LEN);
+        g_dc_stat[k] = g_dc_stat[k + 1];
+    }
+    --g_cfg.dc_ch_count;
+    memset(&g_dc_stat[g_cfg.dc_ch_count], 0, sizeof(DcChanStat));
+    return true;
+}
+
+// Global allow list first, then the row's mask (row < 0: not in the table).
+static bool dc_chan_allowed(int8_t row, const char *author_id) {
+    if (!is_allowed(g_cfg.discord, author_id)) return false;
+    if (row < 0 || !g_cfg.dc_ch[row].allow || !g_cfg.discord.allow_count) return true;
+    for (uint8_t i = 0; i < g_cfg.discord.allow_count; ++i)
+        if (!strcmp(g_cfg.discord.allow_from[i], author_id))
+            return g_cfg.dc_ch[row].allow & (1u << i);
+    return false;
+}
+
+// Queue one message from a table row (or from anywhere, row < 0).
+static bool dc_chan_post(int8_t row, const char *channel, const char *content) {
+    if (!inbox_post(CH_DISCORD, channel, content, row < 0 ? 0 : g_cfg.dc_ch[row].session))
+        return false;
+    if (row >= 0) {
+        ++g_dc_stat[row].msgs;
+        g_dc_stat[row].last_ms = millis();
     }
+    return true;
+}
 
-    bool first_poll = !g_dc_last_msg_id[0];
+// msgq.h: a reply to channel was delivered ms after its message came in.
+static void dc_chan_delivered(const char *channel, uint32_t ms) {
+    int8_t i = dc_chan_find(channel);
+    if (i < 0) return;
+    DcChanStat &s = g_dc_stat[i];
+    ++s.lat_n;
+    s.lat_sum += ms;
+    if (ms > s.lat_max) s.lat_max = ms;
+}
 
-    const char *p = g_http_resp;
-    while ((p = strstr(p, "\"id\"")) != nullptr) {
-        char msg_id[ALLOW_ID_LEN] = {0};
-        const char *id_v = p + strlen("\"id\"");
-        while (*id_v == ' ' || *id_v == ':') ++id_v;
-        id_from_str(id_v, msg_id, sizeof(msg_id));
+// Snowflakes as decimal strings: the longer one is newer, equal lengths
+// compare as strings.
+static bool _dc_newer(const char *a, const char *b) {
+    size_t la = strlen(a), lb = strlen(b);
+    return la != lb ? la > lb : strcmp(a, b) > 0;
+}
 
-        // Discord IDs are Snowflakes : compare as strings (fixed-width numeric)
-        bool is_new = (strlen(msg_id) > strlen(g_dc_last_msg_id) ||
-                       strcmp(msg_id, g_dc_last_msg_id) > 0);
+/*
+* Gateway messages move the cursor in RAM only (dc_cursor_touch). dc_poll
+* writes it out DC_CURSOR_FLUSH_MS after the first unsaved move, or right
+* away once REST polling takes over : not one flash write per message,
+* which on Pico W is a whole LittleFS cfg_save.
+*/
+static bool     g_dc_cursor_dirty = false;
+static uint32_t g_dc_cursor_ms    = 0;     // first unsaved move
 
-        if (is_new && msg_id[0]) {
-            strlcpy(g_dc_last_msg_id, msg_id, sizeof(g_dc_last_msg_id));
+// Persist the REST cursors (g_dc_cursor).
+static void _dc_save_cursor() {
+    g_dc_cursor_dirty = false;
 #if PERSIST_IMPL == 1
-            prefs.begin("femtoclaw", false);
-            prefs.putString("dc_last_id", g_dc_last_msg_id);
-            prefs.end();
+    prefs.begin("femtoclaw", false);
+    prefs.putBytes("dc_cursor", g_dc_cursor, sizeof(g_dc_cursor));
+    prefs.end();
 #else
-            cfg_save();
+    cfg_save();
 #endif
-        }
+}
+
+static void dc_cursor_touch() {
+    if (g_dc_cursor_dirty) return;
+    g_dc_cursor_dirty = true;
+    g_dc_cursor_ms    = millis();
+}
 
-        if (first_poll || !is_new) { ++p; continue; }
+// now: write regardless of DC_CURSOR_FLUSH_MS.
+static void dc_cursor_flush(bool now) {
+    if (!g_dc_cursor_dirty) return;
+    if (now || millis() - g_dc_cursor_ms >= DC_CURSOR_FLUSH_MS) _dc_save_cursor();
+}
+
+static bool dcg_fallback();
+
+// The k-th entry (0 = first in the list, the newest) whose "id" is newer
+// than `since`, its id in `id`; nullptr past the last. An author's "id"
+// is older than anything they posted: never new.
+static const char *_dc_entry(const char *resp, const char *since, uint8_t k, char *id) {
+    for (const char *p = resp; (p = strstr(p, "\"id\"")) != nullptr; ++p) {
+        const char *v = p + strlen("\"id\"");
+        while (*v == ' ' || *v == ':') ++v;
+        id_from_str(v, id, ALLOW_ID_LEN);
+        if (id[0] && _dc_newer(id, since) && !k--) return p;
+    }
+    return nullptr;
+}
+
+/*
+* A message list for table row `row` (newest first). The first poll of a
+* channel only takes the newest id as its starting point. After that, what
+* is newer than the cursor is queued oldest first and the cursor follows
+* each message taken; a full inbox stops the walk, and the rest comes back
+* in the next poll. true when the cursor moved.
+*/
+static bool _dc_parse(int8_t row, const char *resp) {
+    const char *chan   = g_cfg.dc_ch[row].id;
+    char       *cursor = g_dc_cursor[row];
+    char since[ALLOW_ID_LEN], msg_id[ALLOW_ID_LEN];
+    strlcpy(since, cursor, ALLOW_ID_LEN);
+
+    uint8_t n = 0;
+    while (n < 255 && _dc_entry(resp, since, n, msg_id)) ++n;
+    if (!n) return false;
+    if (!since[0]) {
+        for (uint8_t k = 0; k < n; ++k) {
+            _dc_entry(resp, since, k, msg_id);
+            if (_dc_newer(msg_id, cursor)) strlcpy(cursor, msg_id, ALLOW_ID_LEN);
+        }
+        return true;
+    }
 
+    bool moved = false;
+    while (n--) {
+        const char *p = _dc_entry(resp, since, n, msg_id);
         const char *auth_sec = strstr(p, "\"author\"");
         char author_id[ALLOW_ID_LEN] = {0};
         if (auth_sec) {
@@ -114,15 +220,97 @@ static void dc_poll() {
         Serial.printf("[Discord] msg_id=%s author=%s content='%s'\r\n",
                       msg_id, author_id, content);
 
-        if (!content[0]) { ++p; continue; }
-        if (!is_allowed(g_cfg.discord, author_id)) {
+        if (content[0] && !dc_chan_allowed(row, author_id)) {
             Serial.printf("[Discord] BLOCKED — author=%s not in allow list\r\n", author_id);
-            ++p; continue;
+        } else if (content[0] && !dc_chan_post(row, chan, content)) {
+            Serial.printf("[Discord] inbox full : msg_id=%s left for the next poll\r\n", msg_id);
+            break;
+        }
+        if (_dc_newer(msg_id, cursor)) {
+            strlcpy(cursor, msg_id, ALLOW_ID_LEN);
+            moved = true;
         }
+    }
+    return moved;
+}
+
+// Next row to poll: the one whose due time is furthest past, -1 if none
+// is due yet. Active rows come round every DC_POLL_MS, quiet ones back off
+// towards DC_POLL_IDLE_MS, so one request per DC_POLL_MS covers them all.
+static int8_t _dc_poll_pick(uint32_t now) {
+    int8_t   best = -1;
+    uint32_t late = 0;
+    for (uint8_t i = 0; i < g_cfg.dc_ch_count; ++i) {
+        int32_t d = (int32_t)(now - g_dc_stat[i].due_ms);
+        if (d >= 0 && (best < 0 || (uint32_t)d > late)) { best = (int8_t)i; late = (uint32_t)d; }
+    }
+    return best;
+}
+
+// ─── dc_poll ──────────────────────────────────────────────────────────────────
+// Scheduler task (net), every DC_POLL_MS, while the Gateway is down
+// (dcg_fallback): one channel per run (_dc_poll_pick). Requests at most
+// inbox_room() messages, so every new message in the response can be queued.
+// Runs every DC_POLL_MS with the Gateway up too, to flush its cursor moves.
+static void dc_poll() {
+    dc_cursor_flush(dcg_fallback());
+    if (!g_cfg.discord.enabled || !g_cfg.discord.token[0]) return;
+    if (!dcg_fallback()) return;
+    uint8_t room = inbox_room();
+    if (!room) return;
+    uint32_t now = millis();
+    int8_t row = _dc_poll_pick(now);
+    if (row < 0) return;
+    const char *chan   = g_cfg.dc_ch[row].id;
+    const char *cursor = g_dc_cursor[row];
+    DcChanStat &st     = g_dc_stat[row];
+
+    ArenaScope scope;
+    char *dc_poll_auth = arena_alloc(CFG_S + 32);
+    char *dc_poll_path = arena_alloc(CFG_S);
+    if (!dc_poll_auth || !dc_poll_path) return;
+    snprintf(dc_poll_auth, CFG_S + 32, "Authorization: Bot %s\r\n", g_cfg.discord.token);
+
+    if (cursor[0])
+        snprintf(dc_poll_path, CFG_S, "/api/v10/channels/%s/messages?after=%s&limit=%u",
+                 chan, cursor, (unsigned)(room < 5 ? room : 5));
+    else
+        snprintf(dc_poll_path, CFG_S, "/api/v10/channels/%s/messages?limit=1", chan);
+
+    g_suppress_tls_logs = true;
+    uint32_t t0 = micros();
+    int16_t code = https_req(g_tls_dc, "discord.com", dc_poll_path, dc_poll_auth,
+                              nullptr, 0, g_http_resp, HTTP_RESP_S);
+    if (code > 0) hist_add(H_POLL_DC, micros() - t0);
+    g_suppress_tls_logs = false;
+
+    ++st.polls;
+    uint32_t msgs_before = st.msgs;
+    if (!st.interval_ms) st.interval_ms = DC_POLL_MS;
+
+    if (code != 200) {
+        Serial.printf("[Discord] poll %s code=%d\r\n", chan, code);
+        st.interval_ms = st.interval_ms * 2 > DC_POLL_IDLE_MS ? DC_POLL_IDLE_MS : st.interval_ms * 2;
+        st.due_ms = millis() + st.interval_ms;
+        return;
+    }
+
+    if (_dc_parse(row, g_http_resp)) _dc_save_cursor();
+
+    // Traffic → back to DC_POLL_MS, silence → double towards DC_POLL_IDLE_MS.
+    if (st.msgs != msgs_before) st.interval_ms = DC_POLL_MS;
+    else st.interval_ms = st.interval_ms * 2 > DC_POLL_IDLE_MS ? DC_POLL_IDLE_MS : st.interval_ms * 2;
+    st.due_ms = millis() + st.interval_ms;
+}
 
-        const char *reply = agent_run(content);
-        delay(TLS_SETTLE_MS);
-        dc_send(reply);
-        ++p;
+static void dc_print_stats() {
+    for (uint8_t i = 0; i < g_cfg.dc_ch_count; ++i) {
+        const DcChannel  &c = g_cfg.dc_ch[i];
+        const DcChanStat &s = g_dc_stat[i];
+        Serial.printf("  DC #%-19s: msgs %lu  polls %lu  reply avg %lu ms  max %lu ms"
+                      "  session %u  allow %s\r\n",
+                      c.id, (unsigned long)s.msgs, (unsigned long)s.polls,
+                      (unsigned long)(s.lat_n ? s.lat_sum / s.lat_n : 0),
+                      (unsigned long)s.lat_max, (unsigned)c.session, c.allow ? "mask" : "all");
     }
 }
\ No newline at end of file
@@ -0,0 +1,475 @@
+/*
+ * ─────────────────────────────────────────────────────────────
+ * FemtoClaw : Discord Gateway (WebSocket) receiver.
+ *
+ * Messages arrive as MESSAGE_CREATE events pushed over one held-open
+ * WebSocket instead of dc_poll() asking /messages every DC_POLL_MS, so
+ * latency is one network hop and no REST rate-limit budget is spent on
+ * receiving. Replies still go out over REST (dc_send_chunk, outbox).
+ *
+ * Depends on: http.h, msgq.h, discord.h, config.h, json.h, persist.h
+ * ─────────────────────────────────────────────────────────────
+ */
+
+#pragma once
+
+/*
+ * ─── Protocol ────────────────────────────────────────────────────────────────
+ *
+ * Connect : wss://gateway.discord.gg/?v=10&encoding=json (plain JSON, no
+ *           zlib). The TLS handshake and HTTP Upgrade run as an HttpJob on
+ *           the net core (net_submit, like tg_poll); on 101 the socket on
+ *           g_tls_dc_gw is handed back and read here. With api_host set the
+ *           upgrade goes to the mock upstream as ws:// on g_tcp_dc_gw
+ *           (http.h, "Upstream override"); g.cli is whichever was used.
+ * Hello   : op 10 gives heartbeat_interval. Answer with Identify (op 2),
+ *           or Resume (op 6) when a session_id / seq from an earlier READY
+ *           is known, on the resume_gateway_url host it named.
+ * Beat    : op 1 {"d":seq} every interval, the first one after a random
+ *           fraction of it. A beat that finds the previous one un-ACKed
+ *           (op 11) marks a zombie connection: reconnect and resume.
+ * Server  : op 1 → beat now, op 7 → reconnect + resume, op 9 → reconnect,
+ *           resume only if d is true.
+ * Events  : op 0, "s" is the sequence for beats and resume. READY,
+ *           RESUMED, MESSAGE_CREATE are used; everything else is skipped.
+ *
+ * Frames  : server frames are unmasked, client frames masked (RFC 6455).
+ *           A text message (fragments included) is assembled in
+ *           s_dcg_msg[DC_GW_FRAME_S]; the rest of a longer one (large
+ *           GUILD_CREATE) is read and dropped. Discord puts "t", "s" and
+ *           "op" before "d", so a truncated event still moves the sequence.
+ *           Ping is answered with pong, close ends the session.
+ *
+ * The task is io (PRIO_HIGH): it runs between HTTP steps, so heartbeats go
+ * out on time while an LLM call is in flight. It never blocks: each pass
+ * reads at most DC_GW_READ_MAX bytes of what is already in the socket.
+ *
+ * Listening: the channels in the table (g_cfg.dc_ch, discord.h), or every
+ * text channel and DM the bot can see while the table is empty. Replies
+ * go to the channel the message came from. Messages from bots (this one included) are ignored.
+ * Intents: GUILD_MESSAGES | DIRECT_MESSAGES | MESSAGE_CONTENT; the last is
+ * privileged and must be switched on in the Developer Portal.
+ *
+ * Fallback: after DC_GW_FAILS connections in a row that never reached
+ * READY / RESUMED, or a fatal close code (bad token, disallowed intents),
+ * dc_poll() takes over REST polling of the channel table, and the
+ * Gateway is tried again after DC_GW_RETRY_MS.
+ */
+static constexpr uint8_t  DC_GW_FAILS     = 3;
+static constexpr uint32_t DC_GW_RETRY_MS  = 300000;
+static constexpr uint32_t DC_GW_HELLO_MS  = 15000;  // 101 → Hello
+static constexpr uint16_t DC_GW_READ_MAX  = 2048;   // bytes read per pass
+static constexpr uint32_t DC_GW_INTENTS   = (1u << 9) | (1u << 12) | (1u << 15);
+static constexpr const char *DC_GW_HOST   = "gateway.discord.gg";
+
+enum DcgState : uint8_t { DCG_IDLE, DCG_CONNECTING, DCG_OPEN };
+
+struct DcGateway {
+    HttpJob  job;
+    WiFiClient *cli;              // g_tls_dc_gw, or g_tcp_dc_gw under api_host
+    char     hdrs[192];
+    char     host[64];            // resume host from READY, else DC_GW_HOST
+    DcgState state;
+    bool     ready;               // READY / RESUMED seen on this connection
+    bool     fallback;            // REST polling in use
+    uint8_t  fails;               // connections in a row that never got ready
+    uint32_t next_ms;             // earliest reconnect
+    uint32_t t_open;              // millis() at 101
+
+    // session
+    char     session[48];
+    char     self_id[ALLOW_ID_LEN];
+    int64_t  seq;                 // last "s", -1 = none
+
+    // heartbeat
+    uint32_t hb_ms, hb_next, hb_sent_at, rtt_ms;
+    bool     hb_acked;
+
+    // receive: frame header, then payload
+    bool     in_hdr;
+    uint8_t  hdr[14];
+    uint8_t  hdr_len, hdr_need;
+    uint8_t  op;                  // opcode of the frame being read
+    bool     fin;
+    uint32_t left;                // payload bytes still to read
+    uint8_t  msg_op;              // opcode of the message being assembled
+    uint16_t msg_len;
+    bool     msg_trunc;
+    char     ctl[126];            // control frame payload (≤ 125)
+    uint8_t  ctl_len;
+
+    // metrics
+    uint32_t connects, resumes, events, messages, truncated, zombies, dropped;
+};
+
+static DcGateway g_dcg = {};
+static FC_EXT_BSS char s_dcg_msg[DC_GW_FRAME_S];
+
+// ─── Send ─────────────────────────────────────────────────────────────────────
+// One masked frame. Payloads here are small (identify is the largest).
+static bool _dcg_send(uint8_t opcode, const char *p, uint16_t len) {
+    static uint8_t f[8 + 512];
+    if (len > sizeof(f) - 8) return false;
+    uint8_t n = 0;
+    f[n++] = 0x80 | opcode;
+    if (len < 126) f[n++] = 0x80 | (uint8_t)len;
+    else { f[n++] = 0x80 | 126; f[n++] = len >> 8; f[n++] = len & 0xFF; }
+    uint8_t *mask = f + n;
+    for (uint8_t i = 0; i < 4; ++i) f[n++] = (uint8_t)random(256);
+    for (uint16_t i = 0; i < len; ++i) f[n + i] = (uint8_t)p[i] ^ mask[i & 3];
+    WiFiClient *c = g_dcg.cli;
+    return c && c->write(f, n + len) == (size_t)(n + len);
+}
+
+static bool _dcg_send_text(const char *p, int len) {
+    return len > 0 && _dcg_send(0x1, p, (uint16_t)len);
+}
+
+static void _dcg_beat(DcGateway &g, uint32_t now) {
+    char b[48];
+    int n = g.seq >= 0 ? snprintf(b, sizeof(b), "{\"op\":1,\"d\":%lld}", (long long)g.seq)
+                       : snprintf(b, sizeof(b), "{\"op\":1,\"d\":null}");
+    _dcg_send_text(b, n);
+    g.hb_acked   = false;
+    g.hb_sent_at = now;
+    g.hb_next    = now + g.hb_ms;
+}
+
+static void _dcg_identify(DcGateway &g) {
+    char b[CFG_S + 192];
+    int n;
+    if (g.session[0] && g.seq >= 0) {
+        n = snprintf(b, sizeof(b),
+                     "{\"op\":6,\"d\":{\"token\":\"%s\",\"session_id\":\"%s\",\"seq\":%lld}}",
+                     g_cfg.discord.token, g.session, (long long)g.seq);
+        ++g.resumes;
+    } else {
+        n = snprintf(b, sizeof(b),
+                     "{\"op\":2,\"d\":{\"token\":\"%s\",\"intents\":%lu,"
+                     "\"properties\":{\"os\":\"" PLATFORM_NAME "\",\"browser\":\"femtoclaw\","
+                     "\"device\":\"femtoclaw\"}}}",
+                     g_cfg.discord.token, (unsigned long)DC_GW_INTENTS);
+    }
+    _dcg_send_text(b, n);
+}
+
+// ─── Session end ──────────────────────────────────────────────────────────────
+static void _dcg_forget(DcGateway &g) {
+    g.session[0] = '\0';
+    g.seq = -1;
+    strlcpy(g.host, DC_GW_HOST, sizeof(g.host));
+}
+
+// Close the socket and schedule the next connect. A connection that never
+// got ready counts towards the fallback.
+static void _dcg_drop(DcGateway &g, uint32_t now, uint32_t wait, const char *why) {
+    if (g.cli) g.cli->stop();
+    if (g.state == DCG_CONNECTING || !g.ready) {
+        ++g.fails;
+        uint8_t  sh = g.fails > 6 ? 6 : g.fails - 1;
+        uint32_t bo = 1000u << sh;
+        if (bo > wait) wait = bo > 60000 ? 60000 : bo;
+        if (g.fails >= 2) _dcg_forget(g);          // resume host / session may be stale
+    }
+    if (g.fails >= DC_GW_FAILS && !g.fallback) {
+        Serial.println("[Discord] Gateway keeps failing : falling back to REST polling");
+        g.fallback = true;
+    }
+    if (g.fallback && wait < DC_GW_RETRY_MS) wait = DC_GW_RETRY_MS;
+    Serial.printf("[Discord] Gateway closed (%s), reconnect in %lu ms\r\n",
+                  why, (unsigned long)wait);
+    g.state   = DCG_IDLE;
+    g.ready   = false;
+    g.next_ms = now + wait;
+}
+
+// Close frame from the server: 4004 bad token and 4010-4014 (shard /
+// intents) will not get better by retrying soon.
+static void _dcg_on_close(DcGateway &g, uint32_t now) {
+    uint16_t code = g.ctl_len >= 2 ? ((uint8_t)g.ctl[0] << 8) | (uint8_t)g.ctl[1] : 0;
+    Serial.printf("[Discord] Gateway close code=%u %.*s\r\n", (unsigned)code,
+                  g.ctl_len > 2 ? g.ctl_len - 2 : 0, g.ctl + 2);
+    if (code == 4004 || (code >= 4010 && code <= 4014)) {
+        if (code == 4014)
+            Serial.println("[Discord] enable the MESSAGE CONTENT intent for the bot in the Developer Portal");
+        _dcg_forget(g);
+        g.fails = DC_GW_FAILS;
+        g.ready = false;
+        return _dcg_drop(g, now, DC_GW_RETRY_MS, "fatal");
+    }
+    if (code == 4007 || code == 4009) _dcg_forget(g);
+    _dcg_drop(g, now, 1000, "server");
+}
+
+// ─── Events ───────────────────────────────────────────────────────────────────
+static void _dcg_ready(DcGateway &g, const char *d) {
+    const char *v;
+    if ((v = jmember(d, "session_id"))) jstr(v, g.session, sizeof(g.session));
+    char url[96] = {0};
+    if ((v = jmember(d, "resume_gateway_url")) && jstr(v, url, sizeof(url))) {
+        const char *h = strstr(url, "://");
+        h = h ? h + 3 : url;
+        strlcpy(g.host, h, sizeof(g.host));
+        char *slash = strchr(g.host, '/');
+        if (slash) *slash = '\0';
+    }
+    const char *u = jmember(d, "user");
+    if (u && (v = jmember(u, "id"))) id_from_str(v, g.self_id, sizeof(g.self_id));
+    Serial.printf("[Discord] Gateway ready : bot id=%s session=%s\r\n", g.self_id, g.session);
+}
+
+static void _dcg_message(DcGateway &g, const char *d) {
+    const char *v;
+    char channel[ALLOW_ID_LEN] = {0}, author_id[ALLOW_ID_LEN] = {0}, msg_id[ALLOW_ID_LEN] = {0};
+    if ((v = jmember(d, "channel_id"))) id_from_str(v, channel, sizeof(channel));
+    if ((v = jmember(d, "id")))         id_from_str(v, msg_id, sizeof(msg_id));
+    if (!channel[0]) return;
+    int8_t row = dc_chan_find(channel);
+    if (g_cfg.dc_ch_count && row < 0) return;         // not in the channel table
+
+    const char *a = jmember(d, "author");
+    if (!a) return;
+    if ((v = jmember(a, "id"))) id_from_str(v, author_id, sizeof(author_id));
+    if (((v = jmember(a, "bot")) && !strncmp(v, "true", 4)) || !strcmp(author_id, g.self_id))
+        return;                                      // never answer bots, ourselves included
+
+    char content[PROMPT_S] = {0};
+    if ((v = jmember(d, "content"))) jstr(v, content, PROMPT_S);
+    Serial.printf("[Discord] msg_id=%s channel=%s author=%s content='%s'\r\n",
+                  msg_id, channel, author_id, content);
+    if (!content[0]) return;
+    if (!dc_chan_allowed(row, author_id)) {
+        Serial.printf("[Discord] BLOCKED — author=%s not in allow list\r\n", author_id);
+        return;
+    }
+    ++g.messages;
+    // A pushed event cannot be fetched again: when the inbox is full it is lost.
+    if (!dc_chan_post(row, channel, content)) {
+        ++g.dropped;
+        Serial.printf("[Discord] inbox full : msg_id=%s dropped\r\n", msg_id);
+    }
+    // Keep the REST cursor current, so a fallback poll starts after this
+    // one. RAM only here: dc_poll writes it out (dc_cursor_flush).
+    if (msg_id[0] && row >= 0) {
+        strlcpy(g_dc_cursor[row], msg_id, ALLOW_ID_LEN);
+        dc_cursor_touch();
+    }
+}
+
+static void _dcg_dispatch(DcGateway &g, char *js, uint32_t now) {
+    const char *v;
+    int op = (v = jmember(js, "op")) ? (int)jint(v) : -1;
+    if ((v = jmember(js, "s")) && *v != 'n') g.seq = jint(v);
+    const char *d = jmember(js, "d");
+
+    switch (op) {
+    case 10:                                          // Hello
+        g.hb_ms    = (d && (v = jmember(d, "heartbeat_interval"))) ? (uint32_t)jint(v) : 41250;
+        g.hb_next  = now + (uint32_t)random((long)g.hb_ms);
+        g.hb_acked = true;
+        _dcg_identify(g);
+        return;
+    case 11:                                          // Heartbeat ACK
+        g.hb_acked = true;
+        g.rtt_ms   = now - g.hb_sent_at;
+        return;
+    case 1:                                           // beat now
+        _dcg_beat(g, now);
+        return;
+    case 7:                                           // Reconnect
+        return _dcg_drop(g, now, 0, "reconnect requested");
+    case 9:                                           // Invalid Session
+        if (!(d && !strncmp(d, "true", 4))) _dcg_forget(g);
+        return _dcg_drop(g, now, 1000 + (uint32_t)random(4000), "invalid session");
+    case 0:
+        break;
+    default:
+        return;
+    }
+
+    ++g.events;
+    char t[24] = {0};
+    if ((v = jmember(js, "t"))) jstr(v, t, sizeof(t));
+    if (!strcmp(t, "MESSAGE_CREATE")) {
+        if (g.msg_trunc) {
+            Serial.println("[Discord] MESSAGE_CREATE longer than DC_GW_FRAME_S : skipped");
+            return;
+        }
+        if (d) _dcg_message(g, d);
+    } else if (!strcmp(t, "READY") || !strcmp(t, "RESUMED")) {
+        if (!strcmp(t, "RESUMED")) Serial.println("[Discord] Gateway resumed");
+        else if (d)                _dcg_ready(g, d);
+        g.ready = true;
+        g.fails = 0;
+        if (g.fallback) {
+            g.fallback = false;
+            Serial.println("[Discord] Gateway back : REST polling stopped");
+        }
+    }
+}
+
+// ─── Receive ──────────────────────────────────────────────────────────────────
+// A whole frame is in: act on control frames, dispatch finished messages.
+static void _dcg_frame_done(DcGateway &g, uint32_t now) {
+    switch (g.op) {
+    case 0x8: return _dcg_on_close(g, now);
+    case 0x9: _dcg_send(0xA, g.ctl, g.ctl_len); return;   // ping → pong
+    case 0xA: return;
+    default:  break;
+    }
+    if (!g.fin) return;                                      // more fragments follow
+    s_dcg_msg[g.msg_len] = '\0';
+    if (g.msg_trunc) ++g.truncated;
+    if (g.msg_op == 0x1) _dcg_dispatch(g, s_dcg_msg, now);
+    g.msg_len   = 0;
+    g.msg_trunc = false;
+}
+
+// Header complete: work out the payload length and where it goes.
+static void _dcg_header_done(DcGateway &g) {
+    g.op  = g.hdr[0] & 0x0F;
+    g.fin = g.hdr[0] & 0x80;
+    uint8_t  l7  = g.hdr[1] & 0x7F;
+    uint64_t len = l7;
+    if (l7 == 126) len = ((uint16_t)g.hdr[2] << 8) | g.hdr[3];
+    if (l7 == 127) { len = 0; for (uint8_t i = 2; i < 10; ++i) len = (len << 8) | g.hdr[i]; }
+    g.left = len > 0xFFFFFFFFu ? 0xFFFFFFFFu : (uint32_t)len;
+    if (g.op >= 0x8) g.ctl_len = 0;
+    else if (g.op != 0x0) { g.msg_op = g.op; g.msg_len = 0; g.msg_trunc = false; }
+    g.hdr_len = 0;
+    g.in_hdr  = g.left == 0;
+}
+
+static void _dcg_read(DcGateway &g, uint32_t now) {
+    WiFiClient &c = *g.cli;
+    uint16_t budget = DC_GW_READ_MAX;
+    while (budget && g.state == DCG_OPEN) {
+        int avail = c.available();
+        if (avail <= 0) return;
+
+        if (g.in_hdr) {                                     // ── header ──
+            int b = c.read();
+            if (b < 0) return;
+            --budget;
+            g.hdr[g.hdr_len++] = (uint8_t)b;
+            if (g.hdr_len == 2) {                           // + extended length, + mask (never sent by servers)
+                uint8_t l7 = g.hdr[1] & 0x7F;
+                g.hdr_need = 2 + (l7 == 126 ? 2 : l7 == 127 ? 8 : 0) + (g.hdr[1] & 0x80 ? 4 : 0);
+            }
+            if (g.hdr_len < 2 || g.hdr_len < g.hdr_need) continue;
+            _dcg_header_done(g);
+            if (!g.left) _dcg_frame_done(g, now);
+            continue;
+        }
+
+        // ── payload ──
+        uint32_t n = g.left;
+        if (n > (uint32_t)avail) n = avail;
+        if (n > budget)          n = budget;
+        char    *dst = nullptr;
+        uint32_t room;
+        if (g.op >= 0x8) { dst = g.ctl + g.ctl_len; room = sizeof(g.ctl) - g.ctl_len; }
+        else             { dst = s_dcg_msg + g.msg_len; room = sizeof(s_dcg_msg) - 1 - g.msg_len; }
+        int got;
+        if (room) {
+            if (n > room) n = room;
+            got = c.read((uint8_t *)dst, n);
+            if (got > 0) {
+                if (g.op >= 0x8) g.ctl_len += got;
+                else             g.msg_len += got;
+            }
+        } else {                                            // past the buffer: drop
+            uint8_t sink[64];
+            if (n > sizeof(sink)) n = sizeof(sink);
+            got = c.read(sink, n);
+            if (g.op < 0x8) g.msg_trunc = true;
+        }
+        if (got <= 0) return;
+        g.left -= got;
+        budget -= got;
+        if (!g.left) { g.in_hdr = true; _dcg_frame_done(g, now); }
+    }
+}
+
+// ─── Task ─────────────────────────────────────────────────────────────────────
+static void _dcg_connect(DcGateway &g) {
+    char key[25];
+    uint8_t raw[16];
+    for (uint8_t i = 0; i < 16; ++i) raw[i] = (uint8_t)random(256);
+    base64_encode(raw, sizeof(raw), key, sizeof(key));
+    snprintf(g.hdrs, sizeof(g.hdrs),
+             "Upgrade: websocket\r\nConnection: Upgrade\r\n"
+             "Sec-WebSocket-Key: %s\r\nSec-WebSocket-Version: 13\r\n", key);
+
+    if (g.cli) g.cli->stop();
+    g_suppress_tls_logs = true;
+    http_job_begin(g.job, g_tls_dc_gw, true, g.host, 443, "/?v=10&encoding=json",
+                   g.hdrs, nullptr, 0, nullptr, 0, true);
+    g_suppress_tls_logs = false;
+    g.cli = g.job.cli;
+    if (net_submit(g.job)) g.state = DCG_CONNECTING;
+}
+
+// Scheduler task (io), every pass.
+static void dcg_task() {
+    DcGateway &g = g_dcg;
+    uint32_t now = millis();
+    bool on = g_cfg.discord.enabled && g_cfg.discord.token[0];
+
+    if (g.state == DCG_CONNECTING) {
+        if (!net_job_done(g.job)) return;
+        if (g.job.code != 101) {
+            char why[24];
+            snprintf(why, sizeof(why), "upgrade code=%d", g.job.code);
+            return _dcg_drop(g, now, 0, why);
+        }
+        ++g.connects;
+        g.state   = DCG_OPEN;
+        g.t_open  = now;
+        g.hb_ms   = 0;
+        g.in_hdr  = true;
+        g.hdr_len = g.hdr_need = 0;
+        g.msg_len = 0;
+        g.msg_trunc = false;
+    }
+
+    if (g.state == DCG_OPEN) {
+        if (!on || WiFi.status() != WL_CONNECTED) {
+            g.cli->stop();
+            g.state = DCG_IDLE;
+            g.ready = false;
+            return;
+        }
+        _dcg_read(g, now);
+        if (g.state != DCG_OPEN) return;
+        if (!g.hb_ms && now - g.t_open >= DC_GW_HELLO_MS)
+            return _dcg_drop(g, now, 0, "no hello");
+        if (g.hb_ms && (int32_t)(now - g.hb_next) >= 0) {
+            if (!g.hb_acked) { ++g.zombies; return _dcg_drop(g, now, 0, "heartbeat not acked"); }
+            _dcg_beat(g, now);
+        }
+        if (!g.cli->connected() && !g.cli->available())
+            return _dcg_drop(g, now, 1000, "socket closed");
+        return;
+    }
+
+    // DCG_IDLE
+    if (!on || WiFi.status() != WL_CONNECTED) return;
+    if ((int32_t)(now - g.next_ms) < 0) return;
+    if (!g.host[0]) _dcg_forget(g);                                // first start
+    _dcg_connect(g);
+}
+
+static inline bool dcg_fallback() { return g_dcg.fallback; }
+
+static void dcg_print_stats() {
+    const DcGateway &g = g_dcg;
+    Serial.printf("  DC gw     : %s  connects %lu (resumes %lu)  events %lu  msgs %lu "
+                  "(dropped %lu)  truncated %lu  zombies %lu  beat %lu ms  rtt %lu ms\r\n",
+                  g.state == DCG_OPEN ? (g.ready ? "ready" : "open") :
+                  g.fallback ? "REST fallback" : g.state == DCG_CONNECTING ? "connecting" : "idle",
+                  (unsigned long)g.connects, (unsigned long)g.resumes,
+                  (unsigned long)g.events, (unsigned long)g.messages, (unsigned long)g.dropped,
+                  (unsigned long)g.truncated, (unsigned long)g.zombies,
+                  (unsigned long)g.hb_ms, (unsigned long)g.rtt_ms);
+}
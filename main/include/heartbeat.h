@@ -10,6 +10,7 @@
 
 static uint32_t g_hb_last = 0;
 
+// Scheduler task (net), checked every second; heartbeat_ms can change at runtime.
 static void heartbeat_check() {
     if (!g_cfg.heartbeat_ms) return;
     if ((millis() - g_hb_last) < g_cfg.heartbeat_ms) return;
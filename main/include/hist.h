@@ -0,0 +1,148 @@
+/*
+ * ─────────────────────────────────────────────────────────────
+ * FemtoClaw : latency histograms.
+ *
+ * One fixed-bucket histogram per stage of a message's trip, in µs:
+ *
+ *   dns      name lookup before a fresh connection (http.h)
+ *   connect  TCP connect + TLS handshake
+ *   ttfb     request sent → first response byte
+ *   body     first byte → response complete (headers + body)
+ *   llm      llm_chat(), request build → reply text
+ *   parse    completion JSON → reply text (non-streaming)
+ *   actions  execute_actions_in_response()
+ *   agent    agent_run(), all LLM rounds and actions
+ *   send     one outbox request (sendMessage / POST messages)
+ *   e2e_tg   Telegram message received → reply delivered
+ *   e2e_dc   Discord message received → reply delivered
+ *   poll_tg  one getUpdates (long polls include the park time)
+ *   poll_dc  one REST poll of a Discord channel
+ *
+ * Buckets are HDR-style: exact below 4 µs, then four per power of two
+ * (at most 25 % wide) up to 2^27 µs (~134 s); anything longer goes to
+ * the last one. Counts are 16-bit and saturate. Each stage has a single
+ * writer (the net core for dns..body, the loop() core for the rest), so
+ * a print can at worst miss a sample that is being added.
+ *
+ * 'stats' prints percentiles, 'stats json' one STATS {...} line with the
+ * raw buckets for charting, 'stats reset' clears them.
+ * ─────────────────────────────────────────────────────────────
+ */
+
+#pragma once
+
+enum HistStage : uint8_t {
+    H_DNS, H_CONNECT, H_TTFB, H_BODY, H_LLM, H_PARSE, H_ACTIONS, H_AGENT,
+    H_SEND, H_E2E_TG, H_E2E_DC, H_POLL_TG, H_POLL_DC, H_STAGES
+};
+
+static const char *const k_hist_name[H_STAGES] = {
+    "dns", "connect", "ttfb", "body", "llm", "parse", "actions", "agent",
+    "send", "e2e_tg", "e2e_dc", "poll_tg", "poll_dc"
+};
+
+static constexpr uint8_t HIST_BUCKETS = 104;   // 4 exact + 4 × 25 octaves
+
+struct Hist {
+    uint16_t b[HIST_BUCKETS];
+    uint32_t n;
+    uint32_t max_us;
+    uint64_t sum_us;
+};
+
+static Hist g_hist[H_STAGES];
+
+static uint8_t _hist_bucket(uint32_t us) {
+    if (us < 4) return (uint8_t)us;
+    uint8_t  e = (uint8_t)(31 - __builtin_clz(us));      // 2 … 31
+    uint32_t i = 4u + (e - 2u) * 4u + ((us >> (e - 2)) & 3u);
+    return i < HIST_BUCKETS ? (uint8_t)i : HIST_BUCKETS - 1;
+}
+
+// Smallest value of bucket i.
+static uint32_t _hist_lo(uint8_t i) {
+    if (i < 4) return i;
+    uint8_t e = (uint8_t)((i - 4) / 4 + 2);
+    return (uint32_t)(4 + (i - 4) % 4) << (e - 2);
+}
+
+static void hist_add(uint8_t stage, uint32_t us) {
+    Hist &h = g_hist[stage];
+    uint16_t &c = h.b[_hist_bucket(us)];
+    if (c != 0xFFFF) ++c;
+    ++h.n;
+    h.sum_us += us;
+    if (us > h.max_us) h.max_us = us;
+}
+
+static inline void hist_add_ms(uint8_t stage, uint32_t ms) {
+    hist_add(stage, ms > 0xFFFFFFFFu / 1000 ? 0xFFFFFFFFu : ms * 1000);
+}
+
+// Value at percentile p (0-100): the top of the bucket it falls in,
+// never above the largest sample.
+static uint32_t hist_pct(const Hist &h, uint8_t p) {
+    uint32_t total = 0;
+    for (uint8_t i = 0; i < HIST_BUCKETS; ++i) total += h.b[i];
+    if (!total) return 0;
+    uint32_t rank = (total * p + 99) / 100, seen = 0;
+    if (!rank) rank = 1;
+    for (uint8_t i = 0; i < HIST_BUCKETS; ++i) {
+        seen += h.b[i];
+        if (seen < rank) continue;
+        uint32_t top = i + 1 < HIST_BUCKETS ? _hist_lo(i + 1) - 1 : h.max_us;
+        return top < h.max_us ? top : h.max_us;
+    }
+    return h.max_us;
+}
+
+static void hist_reset() { memset(g_hist, 0, sizeof(g_hist)); }
+
+// "850us", "12.3ms", "4.21s"
+static const char *_hist_fmt(char *buf, uint8_t cap, uint32_t us) {
+    if (us < 1000)           snprintf(buf, cap, "%luus", (unsigned long)us);
+    else if (us < 1000000)   snprintf(buf, cap, "%.1fms", us / 1000.0);
+    else                     snprintf(buf, cap, "%.2fs", us / 1000000.0);
+    return buf;
+}
+
+static void hist_print() {
+    Serial.print("\r\n  stage          n       p50       p90       p99       max      mean\r\n");
+    for (uint8_t s = 0; s < H_STAGES; ++s) {
+        const Hist &h = g_hist[s];
+        char a[12], b[12], c[12], d[12], e[12];
+        Serial.printf("  %-8s %8lu  %8s  %8s  %8s  %8s  %8s\r\n",
+                      k_hist_name[s], (unsigned long)h.n,
+                      _hist_fmt(a, sizeof(a), hist_pct(h, 50)),
+                      _hist_fmt(b, sizeof(b), hist_pct(h, 90)),
+                      _hist_fmt(c, sizeof(c), hist_pct(h, 99)),
+                      _hist_fmt(d, sizeof(d), h.max_us),
+                      _hist_fmt(e, sizeof(e), h.n ? (uint32_t)(h.sum_us / h.n) : 0));
+    }
+}
+
+/*
+ * One line for the GUI / scripts:
+ *   STATS {"unit":"us","stages":{"dns":{"n":3,"mean":..,"p50":..,"p90":..,
+ *          "p99":..,"max":..,"b":[[lo,count],...]},...}}
+ * b lists the non-empty buckets by their smallest value.
+ */
+static void hist_print_json() {
+    Serial.print("STATS {\"unit\":\"us\",\"stages\":{");
+    for (uint8_t s = 0; s < H_STAGES; ++s) {
+        const Hist &h = g_hist[s];
+        Serial.printf("%s\"%s\":{\"n\":%lu,\"mean\":%lu,\"p50\":%lu,\"p90\":%lu,\"p99\":%lu,\"max\":%lu,\"b\":[",
+                      s ? "," : "", k_hist_name[s], (unsigned long)h.n,
+                      (unsigned long)(h.n ? h.sum_us / h.n : 0),
+                      (unsigned long)hist_pct(h, 50), (unsigned long)hist_pct(h, 90),
+                      (unsigned long)hist_pct(h, 99), (unsigned long)h.max_us);
+        bool first = true;
+        for (uint8_t i = 0; i < HIST_BUCKETS; ++i) {
+            if (!h.b[i]) continue;
+            Serial.printf("%s[%lu,%u]", first ? "" : ",", (unsigned long)_hist_lo(i), (unsigned)h.b[i]);
+            first = false;
+        }
+        Serial.print("]}");
+    }
+    Serial.print("}}\r\n");
+}
@@ -4,21 +4,47 @@
 *                          HTTP / HTTPS POST / GET
 *   ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
 *
-* Three dedicated TLS clients : one per remote host family.
+* Dedicated TLS clients : one per remote host family / job that can be in
+* flight at the same time.
 *
-*   g_tls_llm  — exclusively for LLM API calls (llm_chat)
-*   g_tls_tg   — exclusively for Telegram API (tg_poll + tg_send)
-*   g_tls_dc   — exclusively for Discord API  (dc_poll + dc_send)
+*   g_tls_llm     — exclusively for LLM API calls (llm_chat)
+*   g_tls_tg      — Telegram sends (tg_send_chunk)
+*   g_tls_tg_poll — Telegram long poll (tg_poll), parked on the server
+*   g_tls_dc      — exclusively for Discord API  (dc_poll + dc_send_chunk)
+*   g_tls_dc_gw   — Discord Gateway WebSocket (discord_gw.h), held open
+*
+* g_tcp_tg / g_tcp_tg_poll / g_tcp_dc / g_tcp_dc_gw stand in for the
+* matching TLS client while g_cfg.api_host redirects the Telegram / Discord
+* APIs to a plain-HTTP server (see "Upstream override").
 *
 */
 static WiFiClientSecure g_tls_llm;
 static WiFiClientSecure g_tls_tg;
+static WiFiClientSecure g_tls_tg_poll;
 static WiFiClientSecure g_tls_dc;
+static WiFiClientSecure g_tls_dc_gw;
 static WiFiClient       g_tcp;
+static WiFiClient       g_tcp_tg;
+static WiFiClient       g_tcp_tg_poll;
+static WiFiClient       g_tcp_dc;
+static WiFiClient       g_tcp_dc_gw;
+
+/*
+* Requests (LLM, sends, REST polls, setWebhook) take turns through
+* net_busy() and share g_http_resp / g_tx_body. A board push (push.h)
+* writes the file straight into g_cfg.board_md, which goes out with every
+* LLM prompt: while g_push_active the scheduler holds net tasks back and
+* the shell refuses commands that would make a request, until the push
+* ends or goes PUSH_IDLE_MS without a chunk / frame. The Telegram long
+* poll and the Discord Gateway run alongside everything else and keep
+* their own buffers.
+*/
+static FC_EXT_BSS char g_http_resp[HTTP_RESP_S];
+static bool g_push_active = false;                  // a board push is rewriting board_md
 
-static char g_http_resp[HTTP_RESP_S];
-static bool g_http_busy = false;            // true while any network I/O is in progress
-static bool g_http_streaming = false;       // true while reading response body
+static FC_EXT_BSS char g_tx_body[JSON_OUT_S];      // shared TX buffers: request body,
+static char g_tx_auth[LLM_KEY + 32];                //   auth header,
+static char g_tx_path[CFG_S];                       //   path
 static bool g_suppress_tls_logs = false;    // suppress TLS messages for background Telegram/Discord polling
 
 // ─── TLS setInsecure helper ──────────────────────────────────────────────────
@@ -36,12 +62,6 @@ static void tls_set_insecure(WiFiClientSecure &tls) {
 #endif
 }
 
-/*
-* _stream_readline : read one CRLF-terminated line from a Stream.
-* Times out after timeout_ms. Works on any Arduino Stream (WiFiClient,
-* WiFiClientSecure) on any board without platform-specific dependencies.
-*/
-
 /*  ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
 *                           USB-CDC keepalive
 *   ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
@@ -59,9 +79,11 @@ static void tls_set_insecure(WiFiClientSecure &tls) {
 * Guard to ARDUINO_USB_CDC_ON_BOOT only on Pico W / hardware-UART ESP32,
 * Serial.write() blocks until the UART TX FIFO drains, which is wasteful.
 */
+static bool net_streaming();
+
 static inline void usb_keepalive(unsigned long &last_ms) {
 #if defined(ARDUINO_USB_CDC_ON_BOOT) && ARDUINO_USB_CDC_ON_BOOT
-  if (g_http_streaming) return; // don't inject null bytes during response streaming
+  if (net_streaming()) return;  // don't inject null bytes during response streaming
   unsigned long now = millis();
   if (now - last_ms >= 200) {
     last_ms = now;
@@ -73,44 +95,11 @@ static inline void usb_keepalive(unsigned long &last_ms) {
 #endif
 }
 
-template<typename T>
-static uint16_t _stream_readline(T &client, char *buf, uint16_t cap, uint32_t timeout_ms) {
-  uint16_t w = 0;
-  unsigned long t0 = millis(), last_ka = t0;
-  while ((millis() - t0) < timeout_ms && w + 1 < cap) {
-    usb_keepalive(last_ka);
-    if (client.available()) {
-      int c = client.read();
-      if (c < 0 || c == '\n') break;
-      if (c != '\r') buf[w++] = (char)c;
-    } else if (!client.connected()) {
-      break;
-    } else {
-      delay(1);
-    }
-  }
-  buf[w] = '\0';
-  return w;
-}
-
-template<typename T>
-static uint16_t _stream_read_body(T &client, char *out, uint16_t out_cap) {
-  uint16_t total = 0;
-  unsigned long t0 = millis(), last_ka = t0;
-  while ((millis() - t0) < HTTP_TIMEOUT_MS && total + 1 < out_cap) {
-    usb_keepalive(last_ka);
-    if (client.available()) {
-      int c = client.read();
-      if (c < 0) break;
-      out[total++] = (char)c;
-    } else if (!client.connected()) {
-      break;
-    } else {
-      delay(1);
-    }
-  }
-  out[total] = '\0';
-  return total;     // (silent truncation - caller handles buffer sizing)
+// Scheduler task : the keepalive runs on its own instead of being sprinkled
+// through every blocking read loop.
+static void usb_keepalive_task() {
+  static unsigned long last_ka = 0;
+  usb_keepalive(last_ka);
 }
 
 /*
@@ -126,10 +115,11 @@ static uint16_t unchunk(char *buf, uint16_t len) {
   char *src = buf, *dst = buf, *end = buf + len;
   while (src < end) {
     char *nl = (char*)memchr(src, '\n', end-src); if (!nl) break;
-    *nl = '\0'; char *cr = nl-1; if (cr >= src && *cr == '\r') *cr = '\0';
+    *nl = '\0'; if (nl > src && nl[-1] == '\r') nl[-1] = '\0';
     unsigned long sz = strtoul(src, nullptr, 16); src = nl+1;
     if (!sz) break;
-    if (src+sz > end) sz = (unsigned long)(end-src);
+    // "-1" or 20 hex digits parse to huge values: compare, never add to src
+    if (sz > (unsigned long)(end-src)) sz = (unsigned long)(end-src);
     memmove(dst, src, sz); dst += sz; src += sz;
     if (src < end && *src == '\r') src++;
     if (src < end && *src == '\n') src++;
@@ -143,112 +133,754 @@ static int16_t _parse_status(const char *line) {
   return (int16_t)atoi(tmp);
 }
 
-static char g_line_buf[128];
-
 /*
-* _stream_drain_headers — consume all HTTP headers until the blank line.
+*   ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+*                      Resumable HTTP transaction
+*   ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+*
+* One request/response is an HttpJob that walks
+*   SETTLE → CONNECT → SEND → WAIT → STATUS → HEADERS → BODY → DONE
+* in small steps. http_job_step() never waits for the peer: it moves the
+* bytes that are ready (at most HTTP_STEP_BYTES) and returns, so the caller
+* can run other work in between. The TLS handshake inside connect() is the
+* one call that still blocks, it lives in the core's WiFiClientSecure.
+*
+* https_req() / http_req() keep their blocking signatures: they hand the
+* job to net_call() (see "Network core"), which runs sched_yield_io() while
+* it waits so the shell, UART framing, servo motion and USB keepalive keep
+* running while a request is in flight.
+*
+* Header end detection handles both CRLF (\r\n\r\n) and bare-LF (\n\n),
+* Ollama's HTTP/1.0 server uses bare \n.
 *
-* HTTP headers end with \r\n\r\n. We track a 4-byte state machine rather than
-* reading line-by-line, so header lines of any length are handled correctly.
-* The line-by-line approach with a fixed g_line_buf silently fails when any
-* header exceeds the buffer size — the non-zero return from _stream_readline
-* means the blank line is never detected and body bytes end up skipped or
-* treated as headers, causing "header bytes leaked into body" warnings.
-* [Fix needed here, i couldn't resolve it]
+* Keep-alive : a caller that passes HttpMeta::keep_alive gets the
+* connection left open when the body end is known (Content-Length or the
+* chunked terminator) and the server did not answer Connection: close.
+* The next keep-alive job on the same client skips SETTLE/connect and the
+* TLS handshake. A kept socket the server has since closed is detected in
+* WAIT and the job reconnects once by itself.
+*
+* The same header pass picks up Retry-After and X-RateLimit-Remaining /
+* X-RateLimit-Reset-After (Discord) into HttpMeta for the sender's pacing.
 */
-// Returns the HTTP status code parsed from the first line (e.g. 200, 404, -1).
-template<typename T>
-static int16_t _stream_drain_headers(T &client, uint32_t timeout_ms) {
-  // Read and parse the status line first (e.g. "HTTP/1.0 200 OK\r\n")
-  uint16_t n = _stream_readline(client, g_line_buf, sizeof(g_line_buf), timeout_ms);
-  int16_t code = (n > 0) ? _parse_status(g_line_buf) : -1;
+static void sched_yield_io();      // scheduler.h
+
+static constexpr uint16_t HTTP_STEP_BYTES = 512;
+
+enum HttpState : uint8_t {
+  HS_SETTLE, HS_SEND, HS_WAIT, HS_STATUS, HS_HEADERS, HS_BODY, HS_DONE
+};
+
+// Chunked-body decoder states (sink jobs only).
+enum : uint8_t { CK_SIZE, CK_DATA, CK_DATA_END, CK_TRAILER, CK_DONE };
+
+struct HttpJob;
+// Called on the net core with each piece of decoded body (see HttpJob::sink).
+typedef void (*HttpSink)(HttpJob &j, const char *p, uint16_t n);
+
+struct HttpJob {
+  WiFiClient *cli;          // g_tls_* or g_tcp
+  bool        tls;
+  const char *host;         // Host: header, port stripped
+  uint16_t    port;
+  const char *path;
+  const char *hdrs;         // extra header lines, each ending in \r\n
+  const char *method;       // nullptr → GET / POST by body; "PATCH" etc.
+  const char *body;         // nullptr / 0 length → GET
+  uint16_t    body_len;
+  uint16_t    sent;
+  char       *out;
+  uint16_t    out_cap;
+  uint16_t    out_len;
+  int16_t     code;         // HTTP status, -1 on connect / protocol failure
+  uint8_t     state;
+  uint8_t     crlf_seq;     // \r\n\r\n detector
+  bool        prev_lf;      // \n\n detector
+  bool        idle;         // last step moved no bytes
+  bool        done;         // reaped by the loop() core (net_job_done)
+  bool        quiet;        // no [TLS] log lines (g_suppress_tls_logs at begin)
+  uint16_t    hs_ms;        // connect + TLS handshake time, 0 when reused
+  char        line[16];     // start of the status line, "HTTP/1.1 200"
+  uint8_t     line_len;
+  char        hline[40];    // start of the current header line
+  uint8_t     hline_len;
+  bool        keep;         // caller wants the connection kept open
+  bool        reused;       // request went out on a kept connection
+  bool        chunked;      // Transfer-Encoding: chunked
+  bool        close_hdr;    // server sent Connection: close
+  int32_t     clen;         // Content-Length, -1 when absent
+  int16_t     rl_remaining; // X-RateLimit-Remaining, -1 when absent
+  uint32_t    rl_reset_ms;  // X-RateLimit-Reset-After
+  uint32_t    retry_ms;     // Retry-After
+  uint32_t    t_state;      // millis() when the current state began
+  uint32_t    us_begin;     // micros() stamps for hist.h : job begun,
+  uint32_t    us_sent;      //   request sent,
+  uint32_t    us_first;     //   first response byte (0 = none yet),
+  uint32_t    us_end;       //   finished
+  bool        park;         // server holds the response (long poll): no ttfb / body sample
+  uint32_t    heap_begin;   // free heap at begin (mem.h)
+  /*
+   Streaming bodies (LLM "stream":true). With a sink the body is not
+   copied into out: transfer chunking is decoded as it arrives and each
+   piece goes to sink(), which fills out as it likes and publishes its
+   length in pub. The loop() core may read out[0, pub) while the job is
+   still running.
+  */
+  HttpSink    sink;
+  uint32_t    body_in;      // raw body bytes consumed
+  uint32_t    ck_left;      // bytes left in the current chunk
+  uint8_t     ck_state;
+  bool        ck_ext;       // inside a chunk extension (";name=value")
+  bool        ck_blank;     // trailer: current line is still empty
+  std::atomic<uint16_t> pub;
+  std::atomic<bool>     streaming;   // reading the body (net core), holds the USB keepalive
+};
 
+// Optional per-request options / results for https_req().
+struct HttpMeta {
+  bool     keep_alive;      // in : leave the connection open afterwards
+  bool     reused;          // out: sent on an already open connection
+  int16_t  rl_remaining;    // out: X-RateLimit-Remaining, -1 when absent
+  uint32_t rl_reset_ms;     // out: X-RateLimit-Reset-After, 0 when absent
+  uint32_t retry_after_ms;  // out: Retry-After header, 0 when absent
+};
+
+// ─── Upstream override ───────────────────────────────────────────────────────
 /*
-*  Drain remaining headers by scanning for the blank line byte-by-byte.
-*  Handles both CRLF (\r\n\r\n) and bare-LF (\n\n) line endings.
-*   Ollama's HTTP/1.0 server uses bare \n — without this the state machine
-*  never finds \r\n\r\n and times out, leaving all headers in the stream.
-*
-*   State machine tracks last two "end-of-line" characters seen:
-*     prev_lf = true  → last meaningful char was \n (end of a line)
-*   If we see \n while prev_lf is true → blank line found (\n\n or \r\n\r\n)
-*/
-  uint8_t seq = 0;
-  bool prev_lf = false;
-  unsigned long t0 = millis(), last_ka = t0;
-  while ((millis() - t0) < timeout_ms) {
-    usb_keepalive(last_ka);
-    if (client.available()) {
-      char c = (char)client.read();
-
-      // ── bare-LF path (Ollama HTTP/1.0) ──
+ * With g_cfg.api_host set ("192.168.1.20:8081"), requests for
+ * api.telegram.org and discord.com go to that host over plain HTTP on the
+ * stand-in client of their TLS client, with the same paths. So does the
+ * Discord Gateway's upgrade (any host on g_tls_dc_gw: gateway.discord.gg
+ * or the resume host), which then runs as ws:// on g_tcp_dc_gw. Meant for
+ * the local mock upstream (bench/mock_upstream.py); the LLM is redirected
+ * the usual way, with an http:// llm_api_base.
+ */
+static char     s_api_cfg[CFG_S];    // api_host the two below were parsed from
+static char     s_api_host[CFG_S];   // jobs in flight point here: rewritten only on change
+static uint16_t s_api_port;
+
+static void _http_override(WiFiClient *&cli, bool &tls, const char *&host, uint16_t &port) {
+  if (!tls || !g_cfg.api_host[0]) return;
+  if (strcmp(host, "api.telegram.org") && strcmp(host, "discord.com") &&
+      cli != &g_tls_dc_gw) return;
+  WiFiClient *plain = cli == &g_tls_tg      ? &g_tcp_tg
+                    : cli == &g_tls_tg_poll ? &g_tcp_tg_poll
+                    : cli == &g_tls_dc      ? &g_tcp_dc
+                    : cli == &g_tls_dc_gw   ? &g_tcp_dc_gw : nullptr;
+  if (!plain) return;
+  if (strcmp(s_api_cfg, g_cfg.api_host)) {
+    strlcpy(s_api_cfg, g_cfg.api_host, CFG_S);
+    strlcpy(s_api_host, g_cfg.api_host, CFG_S);
+    char *colon = strrchr(s_api_host, ':');
+    s_api_port = 80;
+    if (colon) { s_api_port = (uint16_t)atoi(colon + 1); *colon = '\0'; }
+  }
+  cli = plain; tls = false;
+  host = s_api_host; port = s_api_port;
+}
+
+static void http_job_begin(HttpJob &j, WiFiClient &cli_in, bool tls,
+                           const char *host, uint16_t port, const char *path,
+                           const char *extra_headers,
+                           const char *body, uint16_t body_len,
+                           char *out, uint16_t out_cap,
+                           bool keep = false) {
+  WiFiClient *cp = &cli_in;
+  _http_override(cp, tls, host, port);
+  WiFiClient &cli = *cp;
+  memset(static_cast<void *>(&j), 0, sizeof(j));
+  j.pub.store(0, std::memory_order_relaxed);
+  j.streaming.store(false, std::memory_order_relaxed);
+  j.cli = &cli;  j.tls = tls;
+  j.host = host; j.port = port; j.path = path; j.hdrs = extra_headers;
+  j.body = body; j.body_len = body ? body_len : 0;
+  j.out = out;   j.out_cap = out_cap;
+  j.code = -1;
+  j.keep = keep;
+  j.clen = -1;
+  j.rl_remaining = -1;
+  j.quiet = g_suppress_tls_logs;
+  if (out && out_cap > 0) out[0] = '\0';
+  j.state   = HS_SETTLE;
+  j.t_state = millis();
+  j.us_begin = micros();
+  j.heap_begin = mem_sample();
+  if (body == g_tx_body) mem_buf_note(MB_TX_BODY, j.body_len + 1u, JSON_OUT_S);
+  if (keep && cli.connected()) { j.reused = true; return; }
+  /*
+   Always stop before reconnecting to ensure lwIP releases the socket FD.
+   Without this, WiFiClientSecure leaks ~2-4KB TLS heap per call and after
+   3-4 LLM responses the ESP32-C3's heap is exhausted, causing TLS connect
+   failures and USB-CDC crashes. HS_SETTLE gives lwIP time to free FDs.
+  */
+  cli.stop();
+}
+
+// complete: the body end was seen (length / chunk terminator), nothing
+// of this response is left unread, so the socket may be kept.
+static bool _http_job_end(HttpJob &j, int16_t code, bool complete = false) {
+  j.us_end = micros();
+  if (code > 0 && j.us_first && !j.park) hist_add(H_BODY, j.us_end - j.us_first);
+  mem_sample();
+  if (j.out && j.out_cap > 0) {
+    j.out[j.out_len] = '\0';
+    if (j.out == g_http_resp) mem_buf_note(MB_HTTP_RESP, j.out_len + 1u, j.out_cap);
+    if (!j.sink) unchunk(j.out, j.out_len);
+  }
+  if (!(j.keep && complete && code > 0 && !j.close_hdr)) j.cli->stop();
+  j.streaming.store(false, std::memory_order_release);
+  j.code  = code;
+  j.state = HS_DONE;
+  return true;
+}
+
+// Seconds ("3", "0.25") → ms, capped at a day ("1e300" must not overflow).
+static uint32_t _http_secs_ms(const char *v) {
+  double s = strtod(v, nullptr);
+  if (!(s > 0)) return 0;
+  return s < 86400.0 ? (uint32_t)(s * 1000.0 + 0.5) : 86400000u;
+}
+
+static void _http_header(HttpJob &j) {
+  const char *h = j.hline;
+  const char *v = strchr(h, ':');
+  if (!v) return;
+  ++v;
+  while (*v == ' ') ++v;
+  if      (!strncasecmp(h, "content-length:", 15))          j.clen = atol(v);
+  else if (!strncasecmp(h, "transfer-encoding:", 18))       j.chunked = !strncasecmp(v, "chunked", 7);
+  else if (!strncasecmp(h, "connection:", 11))              j.close_hdr = !strncasecmp(v, "close", 5);
+  else if (!strncasecmp(h, "retry-after:", 12))             j.retry_ms = _http_secs_ms(v);
+  else if (!strncasecmp(h, "x-ratelimit-remaining:", 22))   j.rl_remaining = (int16_t)atoi(v);
+  else if (!strncasecmp(h, "x-ratelimit-reset-after:", 24)) j.rl_reset_ms = _http_secs_ms(v);
+}
+
+// Body fully received? Needs Content-Length or the chunked "0\r\n\r\n".
+static bool _http_body_done(const HttpJob &j) {
+  if (j.clen >= 0) return j.out_len >= (uint32_t)j.clen;
+  if (!j.chunked || j.out_len < 5) return false;
+  const char *e = j.out + j.out_len - 5;
+  return !memcmp(e, "0\r\n\r\n", 5) && (e == j.out || e[-1] == '\n');
+}
+
+static inline void _http_job_enter(HttpJob &j, uint8_t st) {
+  j.state = st;
+  j.t_state = millis();
+}
+
+// Dotted IPv4 literal: nothing to look up.
+static bool _http_is_ip(const char *h) {
+  for (; *h; ++h) if (*h != '.' && (*h < '0' || *h > '9')) return false;
+  return true;
+}
+
+static inline uint8_t _http_hex(char c) {
+  return c <= '9' ? c - '0' : (c | 0x20) - 'a' + 10;
+}
+
+// Sink jobs: strip the chunk framing and pass the data on.
+static void _http_sink_feed(HttpJob &j, const char *p, uint16_t n) {
+  j.body_in += n;
+  if (!j.chunked) { j.sink(j, p, n); return; }
+  while (n) {
+    if (j.ck_state == CK_DATA) {
+      uint16_t k = j.ck_left < n ? (uint16_t)j.ck_left : n;
+      j.sink(j, p, k);
+      p += k; n -= k; j.ck_left -= k;
+      if (!j.ck_left) j.ck_state = CK_DATA_END;
+      continue;
+    }
+    char c = *p++; --n;
+    switch (j.ck_state) {
+    case CK_SIZE:                      // "1a3[;ext]\r\n"
       if (c == '\n') {
-        if (prev_lf) return code;  // \n\n = blank line = end of headers
-        prev_lf = true;
-      } else if (c != '\r') {
-        prev_lf = false;           // non-CR/LF char resets bare-LF detector
+        j.ck_ext   = false;
+        j.ck_blank = true;
+        j.ck_state = j.ck_left ? CK_DATA : CK_TRAILER;
+      } else if (c == ';') j.ck_ext = true;
+      else if (!j.ck_ext && isxdigit((unsigned char)c)) j.ck_left = j.ck_left * 16 + _http_hex(c);
+      break;
+    case CK_DATA_END:                  // "\r\n" after the data
+      if (c == '\n') j.ck_state = CK_SIZE;
+      break;
+    case CK_TRAILER:                   // trailer lines, then an empty one
+      if (c == '\n') { if (j.ck_blank) j.ck_state = CK_DONE; j.ck_blank = true; }
+      else if (c != '\r') j.ck_blank = false;
+      break;
+    default:
+      n = 0;
+      break;
+    }
+  }
+}
+
+// Request line + headers in one burst; the body follows in CHUNK pieces.
+static void _http_send_head(HttpJob &j) {
+  WiFiClient &c = *j.cli;
+  // extra headers may bring their own Connection (WebSocket: "Upgrade")
+  const char *conn = (j.hdrs && strstr(j.hdrs, "Connection:")) ? nullptr
+                   : j.keep ? "keep-alive" : "close";
+  if (j.body_len > 0) {
+    c.printf("%s %s HTTP/1.1\r\nHost: %s\r\nContent-Type: application/json\r\n",
+             j.method ? j.method : "POST", j.path, j.host);
+    if (j.hdrs && j.hdrs[0]) c.print(j.hdrs);
+    c.printf("Content-Length: %u\r\n", j.body_len);
+    if (conn) c.printf("Connection: %s\r\n", conn);
+    c.print("\r\n");
+  } else {
+    c.printf("%s %s HTTP/1.1\r\nHost: %s\r\n", j.method ? j.method : "GET", j.path, j.host);
+    if (j.hdrs && j.hdrs[0]) c.print(j.hdrs);
+    if (conn) c.printf("Connection: %s\r\n", conn);
+    c.print("\r\n");
+  }
+}
+
+/*
+* http_job_step : advance the job by at most one bounded piece of work.
+* Returns true once the job is finished; j.code then holds the status.
+*/
+static bool http_job_step(HttpJob &j) {
+  WiFiClient &c = *j.cli;
+  uint32_t now = millis();
+  j.idle = true;
+
+  switch (j.state) {
+  case HS_SETTLE:
+    if (j.reused) {                // warm connection: no settle, no handshake
+      _http_send_head(j);
+      j.idle = false;
+      _http_job_enter(j, HS_SEND);
+      return false;
+    }
+    if (now - j.t_state < (j.tls ? TLS_SETTLE_MS : 20)) return false;
+    if (j.tls) tls_set_insecure(static_cast<WiFiClientSecure &>(c));
+    c.setTimeout(HTTP_TIMEOUT_MS);
+    // Only show TLS logs for direct LLM/chat operations, suppress for background polling
+    if (j.tls && !j.quiet) Serial.printf("[TLS] connecting to %s ...\r\n", j.host);
+    {
+      // Resolve first so dns and connect are timed apart; connect() then
+      // finds the name in the resolver's cache.
+      if (!_http_is_ip(j.host)) {
+        IPAddress ip;
+        uint32_t u0 = micros();
+        WiFi.hostByName(j.host, ip);
+        hist_add(H_DNS, micros() - u0);
+      }
+      uint32_t u0 = micros();
+      bool ok = c.connect(j.host, j.port);
+      uint32_t d = (micros() - u0) / 1000;
+      j.hs_ms = d > 0xFFFF ? 0xFFFF : (uint16_t)d;
+      if (ok) {
+        hist_add(H_CONNECT, micros() - u0);
+        mem_sample_conn(j.heap_begin);
       }
-      // \r doesn't reset prev_lf : allows \r\n\r\n to trigger both paths
+      if (!ok) {
+        if (j.tls && !j.quiet) Serial.printf("[TLS] connect failed: %s\r\n", j.host);
+        return _http_job_end(j, -1);
+      }
+    }
+    if (j.tls && !j.quiet) Serial.printf("[TLS] connected — sending request\r\n");
+    _http_send_head(j);
+    j.idle = false;
+    _http_job_enter(j, HS_SEND);
+    return false;
 
-      // ── CRLF path (standard HTTP/1.1) ──
-      if (c == '\r')      seq = (seq == 2) ? 3 : 1;
-      else if (c == '\n') seq = (seq == 1 || seq == 3) ? seq + 1 : 0;
-      else                seq = 0;
+  case HS_SEND:
+    if (j.sent < j.body_len) {
+      uint16_t n = (j.body_len - j.sent > CHUNK) ? CHUNK : (j.body_len - j.sent);
+      c.write((const uint8_t *)j.body + j.sent, n);
+      j.sent += n;
+      j.idle  = false;
+      return false;
+    }
+    j.us_sent = micros();
+    _http_job_enter(j, HS_WAIT);
+    return false;
 
-      if (seq == 4) return code;  // \r\n\r\n = end of headers
-    } else if (!client.connected()) {
-      break;
-    } else {
-      delay(1);
+  case HS_WAIT:                    // first response byte
+    if (c.available()) {
+      j.us_first = micros();
+      if (!j.park) hist_add(H_TTFB, j.us_first - j.us_sent);
+      _http_job_enter(j, HS_STATUS);
+      return false;
+    }
+    if (!c.connected() && j.reused) {
+      // The server closed the kept socket while it was idle : start over
+      // on a fresh connection, once.
+      c.stop();
+      j.reused = false;
+      j.sent   = 0;
+      _http_job_enter(j, HS_SETTLE);
+      return false;
     }
+    if (!c.connected() || now - j.t_state >= HTTP_TIMEOUT_MS) return _http_job_end(j, -1);
+    return false;
+
+  case HS_STATUS:
+  case HS_HEADERS: {
+    uint16_t budget = HTTP_STEP_BYTES;
+    while (budget-- && c.available()) {
+      char ch = (char)c.read();
+      j.idle = false;
+      if (j.state == HS_STATUS) {
+        if (ch == '\n') {
+          j.line[j.line_len] = '\0';
+          j.code = _parse_status(j.line);
+          _http_job_enter(j, HS_HEADERS);
+        } else if (ch != '\r' && j.line_len + 1u < sizeof(j.line)) {
+          j.line[j.line_len++] = ch;
+        }
+        continue;
+      }
+      // ── header line capture ──
+      if (ch == '\n') {
+        j.hline[j.hline_len] = '\0';
+        _http_header(j);
+        j.hline_len = 0;
+      } else if (ch != '\r' && j.hline_len + 1u < sizeof(j.hline)) {
+        j.hline[j.hline_len++] = ch;
+      }
+      // ── bare-LF path ──
+      if (ch == '\n') {
+        if (j.prev_lf) { _http_job_enter(j, HS_BODY); break; }
+        j.prev_lf = true;
+      } else if (ch != '\r') {
+        j.prev_lf = false;
+      }
+      // ── CRLF path ──
+      if (ch == '\r')      j.crlf_seq = (j.crlf_seq == 2) ? 3 : 1;
+      else if (ch == '\n') j.crlf_seq = (j.crlf_seq == 1 || j.crlf_seq == 3) ? j.crlf_seq + 1 : 0;
+      else                 j.crlf_seq = 0;
+      if (j.crlf_seq == 4) { _http_job_enter(j, HS_BODY); break; }
+    }
+    if (j.state == HS_BODY) {
+      j.streaming.store(true, std::memory_order_release);
+      // 101 Switching Protocols: the socket now speaks the upgraded
+      // protocol, nothing more to read here; the caller takes it over.
+      if (j.clen == 0 || j.code == 101 || j.code == 204 || j.code == 304)
+        return _http_job_end(j, j.code, true);
+    } else if (j.idle && (!c.connected() || now - j.t_state >= HTTP_TIMEOUT_MS))
+      return _http_job_end(j, j.code);
+    return false;
   }
-  return code;  // timeout or disconnect : return what we have
-}
-
-// _stream_send_req : send HTTP request header and body (if any).
-// If body is nullptr or body_len is 0, sends a GET; otherwise POST.
-template<typename T>
-static void _stream_send_req(T &client, const char *host, const char *path,
-                               const char *extra_headers,
-                               const char *body, uint16_t body_len) {
-  // USB keepalive during request assembly on ESP32-C3 native USB, the TX
-  // buffer can take 100-200ms to drain, during which the USB bus is silent
-  // and the host may drop the COM port. The keepalive fires every 200ms.
-  unsigned long last_ka = millis();
-
-  if (body && body_len > 0) {
-    client.printf("POST %s HTTP/1.1\r\n", path);
-    yield(); usb_keepalive(last_ka);
-    client.printf("Host: %s\r\n", host);
-    yield(); usb_keepalive(last_ka);
-    client.printf("Content-Type: application/json\r\n");
-    yield(); usb_keepalive(last_ka);
-    if (extra_headers && extra_headers[0])
-      client.print(extra_headers);
-    yield(); usb_keepalive(last_ka);
-    client.printf("Content-Length: %u\r\nConnection: close\r\n\r\n", body_len);
-    yield(); usb_keepalive(last_ka);
-    // Write body in CHUNK-sized pieces
-    uint16_t sent = 0;
-    while (sent < body_len) {
-      uint16_t n = (body_len - sent > CHUNK) ? CHUNK : (body_len - sent);
-      client.write((const uint8_t*)body + sent, n);
-      sent += n;
-      yield(); usb_keepalive(last_ka);
+
+  case HS_BODY: {
+    int avail = c.available();
+    if (j.sink) {
+      if (avail > 0) {
+        char tmp[256];
+        int got = c.read((uint8_t *)tmp, (uint16_t)avail < sizeof(tmp) ? (uint16_t)avail : sizeof(tmp));
+        if (got > 0) {
+          _http_sink_feed(j, tmp, (uint16_t)got);
+          j.idle    = false;
+          j.t_state = now;             // a stream may run long: time out on stalls only
+        }
+        if (j.ck_state == CK_DONE || (j.clen >= 0 && j.body_in >= (uint32_t)j.clen))
+          return _http_job_end(j, j.code, true);
+        return false;
+      }
+      if (!c.connected() || now - j.t_state >= HTTP_TIMEOUT_MS)
+        return _http_job_end(j, j.code);
+      return false;
     }
-  } else {
-    client.printf("GET %s HTTP/1.1\r\n", path);
-    yield(); usb_keepalive(last_ka);
-    client.printf("Host: %s\r\n", host);
-    yield(); usb_keepalive(last_ka);
-    if (extra_headers && extra_headers[0])
-      client.print(extra_headers);
-    yield(); usb_keepalive(last_ka);
-    client.print("Connection: close\r\n\r\n");
-    yield(); usb_keepalive(last_ka);
+    if (avail > 0) {
+      if (!j.out || j.out_len + 1 >= j.out_cap) return _http_job_end(j, j.code);
+      uint16_t room = j.out_cap - 1 - j.out_len;
+      uint16_t n = (uint16_t)avail < room ? (uint16_t)avail : room;
+      if (n > HTTP_STEP_BYTES) n = HTTP_STEP_BYTES;
+      int got = c.read((uint8_t *)j.out + j.out_len, n);
+      if (got > 0) { j.out_len += (uint16_t)got; j.idle = false; }
+      if (_http_body_done(j)) return _http_job_end(j, j.code, true);
+      return false;
+    }
+    // Done when the peer closes, the buffer is full (silent truncation,
+    // caller handles sizing) or the body stalls past the timeout.
+    if (!c.connected() || now - j.t_state >= HTTP_TIMEOUT_MS)
+      return _http_job_end(j, j.code);
+    return false;
+  }
+
+  default:
+    return true;
   }
 }
 
+/*
+*   ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+*                              Network core
+*   ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+*
+* With FC_NET_CORE the HttpJob pipeline (TLS handshake included) runs on
+* the other core, so the loop() core never sits in connect():
+*
+*   ESP32 / ESP32-S3 : FreeRTOS task "fc_net" pinned to core 0, next to the
+*                      WiFi / lwIP tasks (Arduino loop() runs on core 1)
+*   Pico W           : core1, through setup1() / loop1()
+*
+* The loop() core posts job pointers on g_net_req; the net core keeps up
+* to NET_MAX_JOBS of them active, steps them round-robin and hands each
+* back on g_net_rep when it finishes. Each queue has exactly one producer
+* and one consumer, so they are lock-free SPSC rings (spsc.h). Until the
+* reply arrives the job, its buffers and its client belong to the net
+* core; jobs in flight together must use different clients.
+*
+* Two ways in, both from the loop() core:
+*   net_call()    blocking, keeps the contract of https_req(): the caller
+*                 waits, running sched_yield_io(), so shell, actions, UART
+*                 rings, servo motion and USB keepalive stay live.
+*                 net_busy() is true meanwhile; the shell and the
+*                 scheduler's net tasks gate on it.
+*   net_submit()  asynchronous, for requests that park on the server
+*                 (Telegram long poll). Check net_job_done() later.
+*
+* Without FC_NET_CORE (ESP32-C3, -DFC_SINGLE_CORE), or before the net core
+* is up, the same queues are drained inline: net_call() steps the jobs
+* itself while it waits, and the "net" io task steps them otherwise.
+*/
+static constexpr uint32_t NET_TASK_STACK = 12288;   // ESP32 task; mbedTLS handshake needs ~8 KB
+static constexpr uint8_t  NET_MAX_JOBS   = 3;
+
+static SpscQueue<HttpJob *, 4> g_net_req;           // loop() core → net core
+static SpscQueue<HttpJob *, 4> g_net_rep;           // net core → loop() core
+static std::atomic<bool> g_net_inflight{false};
+static std::atomic<bool> g_net_core_up{false};
+static HttpJob *g_net_out[NET_MAX_JOBS];            // submitted, not yet reaped (loop() core)
+static uint8_t  g_net_outstanding = 0;
+static uint32_t g_net_jobs   = 0;
+static uint32_t g_net_max_ms = 0;
+
+static inline bool net_busy() { return g_net_inflight.load(std::memory_order_acquire); }
+
+static inline bool net_inline() {
+#if FC_NET_CORE
+  return !g_net_core_up.load(std::memory_order_acquire);
+#else
+  return true;
+#endif
+}
+
+/*
+* Net core side: admit queued jobs, step every active job once, hand back
+* the finished ones. Returns true when any job moved bytes.
+*/
+static bool net_core_poll() {
+  static HttpJob *s_active[NET_MAX_JOBS];
+  static uint8_t  s_n  = 0;
+  static bool     s_in = false;        // inline mode: never nest
+  if (s_in) return false;
+  s_in = true;
+
+  HttpJob *j;
+  while (s_n < NET_MAX_JOBS && g_net_req.pop(j)) s_active[s_n++] = j;
+
+  bool moved = false;
+  for (uint8_t i = 0; i < s_n; ) {
+    HttpJob *a = s_active[i];
+    if (http_job_step(*a)) {
+      g_net_rep.push(a);               // outstanding ≤ NET_MAX_JOBS < capacity
+      s_active[i] = s_active[--s_n];
+      moved = true;
+      continue;
+    }
+    if (!a->idle) moved = true;
+    ++i;
+  }
+  s_in = false;
+  return moved;
+}
+
+#if FC_NET_CORE && defined(BOARD_ESP32)
+static void net_core_task(void *) {
+  for (;;)
+    if (!net_core_poll()) delay(1);    // lets lwIP / the idle task run on this core
+}
+#endif
+
+// Called once from setup() on ESP32; Pico W starts core1 from setup1().
+static void net_core_start() {
+#if FC_NET_CORE && defined(BOARD_ESP32)
+  if (g_net_core_up.load()) return;
+  TaskHandle_t h = nullptr;
+  if (xTaskCreatePinnedToCore(net_core_task, "fc_net", NET_TASK_STACK,
+                              nullptr, 1, &h, 0) != pdPASS) {
+    Serial.println("[net] WARNING: could not start net task : running requests inline");
+    return;
+  }
+  mem_stack_watch("fc_net", h, NET_TASK_STACK);
+  g_net_core_up.store(true, std::memory_order_release);
+#elif FC_NET_CORE && defined(BOARD_PICO_W)
+  g_net_core_up.store(true, std::memory_order_release);
+#endif
+}
+
+// Loop side: a submitted job owns this client, so only the net core may touch it.
+static bool net_uses(const WiFiClient *c) {
+  for (uint8_t i = 0; i < g_net_outstanding; ++i)
+    if (g_net_out[i]->cli == c) return true;
+  return false;
+}
+
+/*
+*   ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+*                          TLS session budget
+*   ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+*
+* An open mbedTLS session keeps its record buffers on the heap: with the
+* arduino-esp32 2.x defaults (16 KB in, 4 KB out) about 25 KB, and a
+* handshake needs about 15 KB more while it runs. With Telegram and
+* Discord both on, up to four sessions sit open next to the LLM one:
+*
+*   g_tls_tg_poll  between long polls            idle, may be closed
+*   g_tls_tg       warm sends / live edits       idle, may be closed
+*   g_tls_dc       warm sends / REST polls       idle, may be closed
+*   g_tls_dc_gw    Gateway                       held
+*
+* That is ~100 KB. On an ESP32-C3 (FC_PROFILE_TINY, ~190 KB free with
+* WiFi up, estimated) llm_chat would find ~90 KB, under HEAP_REBOOT_MIN,
+* and reboot. So:
+*
+*   • after each reaped job, idle sessions beyond TLS_IDLE_MAX (per
+*     profile, constants.h) are closed, least recently used first;
+*   • before an LLM request, when free heap is short of HEAP_REBOOT_MIN
+*     plus one handshake (the measured TLS cost, TLS_HS_HEAP until there
+*     is one), every idle session is closed.
+*
+* 'mem' lists the open sessions; "after connect" there is the figure to
+* set HEAP_REBOOT_MIN from.
+*/
+struct TlsIdle {
+  WiFiClientSecure *cli;
+  const char       *name;
+  uint32_t          used_ms;     // millis() when its last job was reaped
+};
+
+static TlsIdle  g_tls_idle[] = {
+  { &g_tls_tg_poll, "tg_poll", 0 },
+  { &g_tls_tg,      "tg",      0 },
+  { &g_tls_dc,      "dc",      0 },
+};
+static uint32_t g_tls_trimmed = 0;   // idle sessions closed by the budget
+
+// Close idle sessions, least recently used first, until at most keep are
+// open. Loop core only. Returns how many were closed.
+static uint8_t tls_trim_idle(uint8_t keep) {
+  TlsIdle *open[sizeof(g_tls_idle) / sizeof(g_tls_idle[0])];
+  uint8_t  n = 0, closed = 0;
+  for (TlsIdle &t : g_tls_idle)
+    if (!net_uses(t.cli) && t.cli->connected()) open[n++] = &t;
+  while (n > keep) {
+    uint8_t lru = 0;
+    for (uint8_t i = 1; i < n; ++i)
+      if ((int32_t)(open[i]->used_ms - open[lru]->used_ms) < 0) lru = i;
+    open[lru]->cli->stop();
+    open[lru] = open[--n];
+    ++closed;
+  }
+  g_tls_trimmed += closed;
+  return closed;
+}
+
+// Before a request that needs its own handshake (llm_chat).
+static uint32_t tls_make_room() {
+  uint32_t f    = mem_sample();
+  uint32_t cost = g_mem.tls_cost_max ? g_mem.tls_cost_max : TLS_HS_HEAP;
+  if (f < HEAP_REBOOT_MIN + cost && tls_trim_idle(0)) {
+    uint32_t g = mem_sample();
+    Serial.printf("[TLS] closed idle sessions for the handshake : free heap %lu → %lu B\r\n",
+                  (unsigned long)f, (unsigned long)g);
+    f = g;
+  }
+  return f;
+}
+
+static void tls_print() {
+  Serial.print("\r\n  TLS open      :");
+  uint8_t n = 0;
+  for (const TlsIdle &t : g_tls_idle)
+    if (net_uses(t.cli) || t.cli->connected()) { Serial.printf(" %s", t.name); ++n; }
+  if (net_uses(&g_tls_dc_gw) || g_tls_dc_gw.connected()) { Serial.print(" dc_gw"); ++n; }
+  if (!n) Serial.print(" none");
+  Serial.printf("   (idle max %u, %lu closed for heap)\r\n",
+                (unsigned)TLS_IDLE_MAX, (unsigned long)g_tls_trimmed);
+}
+
+// Loop side: collect finished jobs.
+static void net_reap() {
+  HttpJob *j;
+  bool any = false;
+  while (g_net_rep.pop(j)) {
+    j->done = true;
+    any = true;
+    for (TlsIdle &t : g_tls_idle)
+      if (j->cli == t.cli) t.used_ms = millis();
+    for (uint8_t i = 0; i < g_net_outstanding; ++i)
+      if (g_net_out[i] == j) { g_net_out[i] = g_net_out[--g_net_outstanding]; break; }
+  }
+  if (any) tls_trim_idle(TLS_IDLE_MAX);
+}
+
+// Queue a job without waiting. false when NET_MAX_JOBS are already out.
+static bool net_submit(HttpJob &j) {
+  if (g_net_outstanding >= NET_MAX_JOBS) return false;
+  j.done = false;
+  if (!g_net_req.push(&j)) return false;
+  g_net_out[g_net_outstanding++] = &j;
+  return true;
+}
+
+// Loop side: some submitted job is reading its response body.
+static bool net_streaming() {
+  for (uint8_t i = 0; i < g_net_outstanding; ++i)
+    if (g_net_out[i]->streaming.load(std::memory_order_acquire)) return true;
+  return false;
+}
+
+static bool net_job_done(HttpJob &j) {
+  net_reap();
+  return j.done;
+}
+
+// Scheduler task (io): steps queued jobs when there is no net core.
+static void net_task() {
+  if (net_inline()) net_core_poll();
+}
+
+// Run a job and wait for it. on_wait (optional) runs on every pass of the
+// wait, after the io tasks: streaming callers read j.pub there.
+static int16_t net_call(HttpJob &j, void (*on_wait)() = nullptr) {
+  g_net_inflight.store(true, std::memory_order_release);
+  uint32_t t0 = millis();
+  while (!net_submit(j)) {             // every slot taken : wait for one
+    if (net_inline()) net_core_poll();
+    net_reap();
+    sched_yield_io();
+    delay(1);
+  }
+  while (!net_job_done(j)) {
+    bool moved = net_inline() && net_core_poll();
+    sched_yield_io();
+    if (on_wait) on_wait();
+    if (!moved) delay(1);              // let the idle task / WiFi stack run
+  }
+  uint32_t ms = millis() - t0;
+  if (ms > g_net_max_ms) g_net_max_ms = ms;
+  ++g_net_jobs;
+  g_net_inflight.store(false, std::memory_order_release);
+  return j.code;
+}
+
+static void net_print_stats() {
+  Serial.printf("  Net       : %s  jobs %lu  worst %lu ms\r\n",
+#if FC_NET_CORE && defined(BOARD_ESP32)
+                g_net_core_up.load() ? "core 0 (fc_net task)" : "inline",
+#elif FC_NET_CORE
+                g_net_core_up.load() ? "core 1" : "inline",
+#else
+                "inline (single core)",
+#endif
+                (unsigned long)g_net_jobs, (unsigned long)g_net_max_ms);
+}
+
 /*
 * `https_req` takes explicit WiFiClientSecure reference.
 *
@@ -260,60 +892,25 @@ static void _stream_send_req(T &client, const char *host, const char *path,
 * and the internal state was reset by the underlying TCP stack.
 *
 * TLS connection messages suppressed when g_suppress_tls_logs is true.
+*
+* meta (optional) asks for keep-alive and returns the rate-limit headers.
 */
 static int16_t https_req(WiFiClientSecure &tls,
                           const char *host, const char *path,
                           const char *extra_headers,
                           const char *body, uint16_t body_len,
-                          char *out, uint16_t out_cap) {
-  /*
-   Always stop before reconnecting to ensure lwIP releases the socket FD.
-   Without this, WiFiClientSecure leaks ~2-4KB TLS heap per call and after
-   3-4 LLM responses the ESP32-C3's heap is exhausted, causing TLS connect
-   failures and USB-CDC crashes. The 30ms settle gives lwIP time to free FDs.
-  */
-  tls.stop();
-  delay(TLS_SETTLE_MS);
-  tls_set_insecure(tls);
-  tls.setTimeout(HTTP_TIMEOUT_MS);
-
-  // Only show TLS logs for direct LLM/chat operations, suppress for background polling
-  if (!g_suppress_tls_logs) {
-    Serial.printf("[TLS] connecting to %s ...\r\n", host);
-  }
-
-  if (!tls.connect(host, 443)) {
-    if (!g_suppress_tls_logs) {
-      Serial.printf("[TLS] connect failed: %s\r\n", host);
-    }
-    if (out && out_cap > 0) out[0] = '\0';
-    Serial.flush();
-    return -1;
-  }
-
-  if (!g_suppress_tls_logs) {
-    Serial.printf("[TLS] connected — sending request\r\n");
-  }
-
-  yield();
-  _stream_send_req(tls, host, path, extra_headers, body, body_len);
-
-  // Sending null-byte keepalives until the first byte arrives.
-  {
-    unsigned long t0 = millis(), last_ka = t0;
-    while (!tls.available() && tls.connected() &&
-           (millis() - t0) < HTTP_TIMEOUT_MS) {
-      usb_keepalive(last_ka);
-      delay(1);
-    }
+                          char *out, uint16_t out_cap,
+                          HttpMeta *meta = nullptr) {
+  HttpJob j;
+  http_job_begin(j, tls, true, host, 443, path, extra_headers, body, body_len, out, out_cap,
+                 meta && meta->keep_alive);
+  int16_t code = net_call(j);
+  if (meta) {
+    meta->reused         = j.reused;
+    meta->rl_remaining   = j.rl_remaining;
+    meta->rl_reset_ms    = j.rl_reset_ms;
+    meta->retry_after_ms = j.retry_ms;
   }
-
-  int16_t code = _stream_drain_headers(tls, HTTP_TIMEOUT_MS);
-  g_http_streaming = true;  // start blocking keepalive
-  uint16_t blen = _stream_read_body(tls, out, out_cap);
-  g_http_streaming = false; // resume keepalive
-  unchunk(out, blen);
-  tls.stop();
   return code;
 }
 
@@ -322,8 +919,10 @@ static int16_t http_req(const char *host_port, const char *path,
                          const char *body, uint16_t body_len,
                          char *out, uint16_t out_cap) {
   /*
-  http_req is currently only called from llm_chat() under g_http_busy, but
+  http_req is currently only called from llm_chat() (one job in flight), but
   a local is safer and costs only 128 bytes of stack for the call duration.
+  'host' (port stripped) is what goes into the Host: header, passing
+  host_port would include the port number twice on some servers.
   */
   char host[CFG_S];
   strlcpy(host, host_port, CFG_S);
@@ -331,58 +930,99 @@ static int16_t http_req(const char *host_port, const char *path,
   char *colon = strrchr(host, ':');
   if (colon) { port = (uint16_t)atoi(colon + 1); *colon = '\0'; }
 
-  g_tcp.stop();
-  delay(20);  // let lwIP release the FD cleanly
-  Serial.flush();
-  if (!g_tcp.connect(host, port)) return -1;
-  g_tcp.setTimeout(HTTP_TIMEOUT_MS);
-  // Pass 'host' (port stripped) to _stream_send_req, it's used for the Host:
-  // header. Passing host_port would include the port number twice on some servers.
-  _stream_send_req(g_tcp, host, path, extra_headers, body, body_len);
-  g_tcp.flush();
-
-  unsigned long t0 = millis();
-  while (!g_tcp.available() && (millis()-t0) < HTTP_TIMEOUT_MS) { yield(); }
-  int16_t code = _stream_drain_headers(g_tcp, HTTP_TIMEOUT_MS);
-  uint16_t blen = _stream_read_body(g_tcp, out, out_cap);
-  unchunk(out, blen);
-  g_tcp.stop();
-  return code;
+  HttpJob j;
+  http_job_begin(j, g_tcp, false, host, port, path, extra_headers, body, body_len, out, out_cap);
+  return net_call(j);
 }
 
-/*
-*   ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
-*                           Shared TX buffers
-*   ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
-*/
-static char g_tx_body[JSON_OUT_S];
-static char g_tx_auth[LLM_KEY + 32];
-static char g_tx_path[CFG_S];
-
 /*
 *   ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
 *                           Base-64 decoder
 *   ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
 */
-static const char b64_table[] =
+static constexpr char b64_table[] =
     "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
 
-static uint16_t base64_decode(const char *in, uint16_t in_len,
+// Reverse table, built at compile time: symbol → 0-63, anything else 0xFF.
+struct B64Rev { uint8_t v[256]; };
+static constexpr B64Rev _b64_rev() {
+    B64Rev r = {};
+    for (int i = 0; i < 256; ++i) r.v[i] = 0xFF;
+    for (uint8_t i = 0; i < 64; ++i) r.v[(uint8_t)b64_table[i]] = i;
+    return r;
+}
+static constexpr B64Rev k_b64_rev = _b64_rev();
+
+// Sec-WebSocket-Key (discord_gw.h): 16 random bytes → 24 chars.
+static uint16_t base64_encode(const uint8_t *in, uint16_t in_len,
                                char *out, uint16_t out_cap) {
     uint16_t w = 0;
-    int val = 0, valb = -8;
-    for (uint16_t i = 0; i < in_len && w + 1 < out_cap; ++i) {
-        char c = in[i];
-        if (c == '=') break;
-        const char *pos = strchr(b64_table, c);
-        if (!pos) continue;   // skip whitespace / newlines silently
-        val  = (val << 6) + (int)(pos - b64_table);
-        valb += 6;
-        if (valb >= 0) {
-            out[w++] = (char)((val >> valb) & 0xFF);
-            valb -= 8;
+    for (uint16_t i = 0; i < in_len && w + 4 < out_cap; i += 3) {
+        uint32_t v = (uint32_t)in[i] << 16;
+        if (i + 1 < in_len) v |= (uint32_t)in[i + 1] << 8;
+        if (i + 2 < in_len) v |= in[i + 2];
+        out[w++] = b64_table[(v >> 18) & 0x3F];
+        out[w++] = b64_table[(v >> 12) & 0x3F];
+        out[w++] = i + 1 < in_len ? b64_table[(v >> 6) & 0x3F] : '=';
+        out[w++] = i + 2 < in_len ? b64_table[v & 0x3F] : '=';
+    }
+    out[w] = '\0';
+    return w;
+}
+
+/*
+* Streaming decoder: the input may be split anywhere (the board push
+* 'chunk' lines), the bits of a split group carry over in B64Dec.
+* Anything that is not a base64 symbol (whitespace, newlines, NUL) is
+* skipped; '=' ends the data and later input is ignored.
+*/
+struct B64Dec {
+    uint32_t val;             // only the low 14 bits are ever pending
+    int8_t   valb;            // bits pending - 8
+    bool     done;            // '=' seen
+    bool     full;            // a byte did not fit in out_cap
+};
+
+static inline void base64_dec_init(B64Dec &d) { d = { 0, -8, false, false }; }
+
+// Decodes into out[0 … out_cap-1] (no terminator); bytes written.
+static uint16_t base64_decode_feed(B64Dec &d, const char *in, uint16_t in_len,
+                                   char *out, uint16_t out_cap) {
+    uint16_t w = 0, i = 0;
+    // Whole groups of 4 symbols → 3 bytes while nothing is pending.
+    const uint8_t *u = (const uint8_t *)in;
+    while (d.valb == -8 && !d.done && i + 4 <= in_len && w + 3 <= out_cap) {
+        uint8_t a = k_b64_rev.v[u[i]],     b = k_b64_rev.v[u[i + 1]];
+        uint8_t c = k_b64_rev.v[u[i + 2]], e = k_b64_rev.v[u[i + 3]];
+        if ((a | b | c | e) > 63) break;             // padding / whitespace: the rest one by one
+        uint32_t v = (uint32_t)a << 18 | (uint32_t)b << 12 | (uint32_t)c << 6 | e;
+        out[w]     = (char)(v >> 16);
+        out[w + 1] = (char)(v >> 8);
+        out[w + 2] = (char)v;
+        w += 3;
+        i += 4;
+    }
+    for (; i < in_len && !d.done; ++i) {
+        uint8_t c = (uint8_t)in[i];
+        uint8_t v = k_b64_rev.v[c];
+        if (v > 63) { d.done = c == '='; continue; }
+        d.val   = ((d.val << 6) | v) & 0xFFFFFF;
+        d.valb += 6;
+        if (d.valb >= 0) {
+            if (w >= out_cap) { d.full = true; break; }
+            out[w++] = (char)((d.val >> d.valb) & 0xFF);
+            d.valb -= 8;
         }
     }
+    return w;
+}
+
+static uint16_t base64_decode(const char *in, uint16_t in_len,
+                               char *out, uint16_t out_cap) {
+    if (!out_cap) return 0;
+    B64Dec d;
+    base64_dec_init(d);
+    uint16_t w = base64_decode_feed(d, in, in_len, out, out_cap - 1);
     out[w] = '\0';
     return w;
 }
\ No newline at end of file
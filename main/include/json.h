@@ -32,6 +32,49 @@ static uint16_t json_escape_into(char *dst, uint16_t cap, const char *s) {
   return w;
 }
 
+/*
+ * json_escape_fit : the longest prefix of s[0, slen) whose escaped form
+ * (json_escape_into) takes at most budget bytes.
+ */
+static uint16_t json_escape_fit(const char *s, uint16_t slen, uint16_t budget) {
+  uint16_t w = 0, i = 0;
+  for (; i < slen; ++i) {
+    uint8_t c = (uint8_t)s[i];
+    uint16_t k = (c == '"' || c == '\\' || c == '\n' || c == '\r' || c == '\t') ? 2 : 1;
+    if (w + k > budget) break;
+    w += k;
+  }
+  return i;
+}
+
+/*
+ * json_escape_in_place : escape s[0, slen) where it stands, back to front
+ * (each character only grows, so nothing unread is overwritten). s is cut
+ * first so the escaped text and its '\0' fit cap bytes. Returns its length.
+ */
+static uint16_t json_escape_in_place(char *s, uint16_t slen, uint16_t cap) {
+  if (!cap) return 0;
+  slen = json_escape_fit(s, slen, cap - 1);
+  uint16_t w = slen;
+  for (uint16_t i = 0; i < slen; ++i) {
+    uint8_t c = (uint8_t)s[i];
+    if (c == '"' || c == '\\' || c == '\n' || c == '\r' || c == '\t') ++w;
+  }
+  s[w] = '\0';
+  for (uint16_t i = slen, o = w; i > 0; ) {
+    char c = s[--i];
+    switch ((uint8_t)c) {
+      case '"':  s[--o]='"';  s[--o]='\\'; break;
+      case '\\': s[--o]='\\'; s[--o]='\\'; break;
+      case '\n': s[--o]='n';  s[--o]='\\'; break;
+      case '\r': s[--o]='r';  s[--o]='\\'; break;
+      case '\t': s[--o]='t';  s[--o]='\\'; break;
+      default:   s[--o]=c;    break;
+    }
+  }
+  return w;
+}
+
 /*
  * json_escape_n_into used by llm_chat() for session history
  * entries, whose content is bounded by '\x02' delimiters, not null bytes.
@@ -62,6 +105,46 @@ static const char *jfind(const char *j, const char *key) {
   return p;
 }
 
+/*
+ *   `jmember` : like jfind, but only matches a direct member of the object
+ *   that starts at obj ('{'). A key of the same name inside a nested object
+ *   or array is skipped ("id" of a message vs. "id" of its author). Returns
+ *   nullptr at the end of the object or of a truncated buffer.
+ */
+static const char *jmember(const char *obj, const char *key) {
+  if (!obj) return nullptr;
+  while (*obj == ' ') ++obj;
+  if (*obj != '{') return nullptr;
+  size_t klen = strlen(key);
+  int  depth = 0;
+  bool want_key = false;
+  for (const char *p = obj; *p; ++p) {
+    char c = *p;
+    if (c == '"') {
+      const char *s = ++p;
+      while (*p && *p != '"') { if (*p == '\\' && p[1]) ++p; ++p; }
+      if (!*p) return nullptr;
+      if (want_key && depth == 1) {
+        const char *v = p + 1;
+        while (*v == ' ') ++v;
+        if (*v == ':' && (size_t)(p - s) == klen && !strncmp(s, key, klen)) {
+          ++v;
+          while (*v == ' ') ++v;
+          return v;
+        }
+      }
+      want_key = false;
+    } else if (c == '{' || c == '[') {
+      want_key = ++depth == 1;
+    } else if (c == '}' || c == ']') {
+      if (--depth <= 0) return nullptr;
+    } else if (c == ',' && depth == 1) {
+      want_key = true;
+    }
+  }
+  return nullptr;
+}
+
 static bool jstr(const char *p, char *out, uint16_t cap,
                   const char *buf_end = nullptr) {
   // buf_end: optional pointer to one-past-end of the source buffer.
@@ -74,7 +157,7 @@ static bool jstr(const char *p, char *out, uint16_t cap,
     if (buf_end && p >= buf_end) break;  // buffer boundary —> stop safely
     if (*p == '\\') {
       ++p;
-      if (buf_end && p >= buf_end) break;
+      if (!*p || (buf_end && p >= buf_end)) break;  // input ends on a lone backslash
       switch (*p) {
         case 'n': out[w++]='\n'; break;
         case 'r': out[w++]='\r'; break;
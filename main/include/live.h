@@ -0,0 +1,312 @@
+/*
+ * ─────────────────────────────────────────────────────────────
+ * FemtoClaw : progressive (live) replies.
+ *
+ * With stream_replies on, a Telegram or Discord message gets a "…"
+ * placeholder reply right away, which is then edited in place as the LLM
+ * streams its answer (llm.h, g_llm_on_text) and edited a last time with
+ * the final text. Everything runs from agent_task: the placeholder and
+ * the edits are async jobs stepped next to the streaming LLM request.
+ *
+ * Depends on: http.h, llm.h, msgq.h, actions.h, json.h, config.h
+ * ─────────────────────────────────────────────────────────────
+ */
+
+#pragma once
+
+/*
+ * ─── Live reply ──────────────────────────────────────────────────────────────
+ *
+ *   placeholder  sendMessage / POST messages with "…"; the message id
+ *                comes back in the response. If it fails the live reply
+ *                is abandoned and the outbox delivers the whole reply.
+ *   edits        editMessageText / PATCH messages/{id}, at most one in
+ *                flight, at most one per LIVE_TG_EDIT_MS / LIVE_DC_EDIT_MS
+ *                and only once LIVE_MIN_GROW new bytes arrived. Complete
+ *                action tags are stripped and a tag still being streamed
+ *                is held back. 429 pauses the edits for retry_after.
+ *   final edit   the finished reply (action tags already stripped by
+ *                agent_run), sent once the throttle allows. A reply longer
+ *                than one message keeps its first chunk here; the rest
+ *                goes to the outbox as a normal reply. One try: if it
+ *                fails, or a 429 still holds the edits, the outbox sends
+ *                the whole reply, and a retry_after holds the outbox
+ *                (not_before) instead of agent_task.
+ *   body         the text is cut where its JSON-escaped form (up to twice
+ *                as long) still fits LIVE_BODY_S, the rest goes on. It is
+ *                written straight into the body after the JSON head and
+ *                escaped there, so there is no separate text buffer.
+ *
+ * Clients: g_tls_tg / g_tls_dc, the outbox's. Both run as net tasks and
+ * net tasks never nest, so the outbox is idle while a live reply runs.
+ * The body, path and response buffers are the live reply's own: the LLM
+ * request in flight still owns g_tx_body and g_http_resp.
+ */
+static constexpr uint16_t LIVE_MIN_GROW = 24;
+static constexpr uint16_t LIVE_BODY_S   = TG_MSG_CHUNK + 512;
+static constexpr uint16_t LIVE_TEXT_ESC = LIVE_BODY_S - 128;   // ids, JSON envelope, " …"
+
+enum : uint8_t { LIVE_NONE, LIVE_PLACEHOLDER, LIVE_EDIT };
+
+struct LiveReply {
+    HttpJob  job;
+    uint8_t  pending;               // LIVE_* request in flight
+    bool     on;
+    bool     dead;                  // no placeholder: the outbox delivers
+    uint8_t  ch;
+    char     chat[ALLOW_ID_LEN];
+    char     msg_id[ALLOW_ID_LEN];  // placeholder message, "" until known
+    uint32_t t_in;
+    uint32_t not_before;            // millis(): edit throttle / retry_after
+    uint16_t shown;                 // text length behind the last edit
+    bool     first;                 // first text shown (time to first text)
+    uint8_t  kind;                  // LIVE_* request being built
+    uint16_t head;                  // body bytes before the text
+    char     path[CFG_S + 64];
+    char     auth[CFG_S + 32];
+    char     body[LIVE_BODY_S];
+    char     resp[RESP_S];          // a Discord message object runs ~1 KB
+    // metrics
+    uint32_t replies, edits, limited, failed, first_n, first_ms;
+};
+
+static LiveReply g_live = {};
+
+static inline uint32_t _live_gap(uint8_t ch) {
+    return ch == CH_TELEGRAM ? LIVE_TG_EDIT_MS : LIVE_DC_EDIT_MS;
+}
+
+// Bytes of text (len, lim for the channel) that one edit carries.
+static uint16_t _live_cut(const char *text, uint16_t len, uint16_t lim) {
+    uint16_t n = len > lim ? _out_cut(text, lim) : len;
+    uint16_t fit = json_escape_fit(text, n, LIVE_TEXT_ESC);
+    return fit < n ? _out_cut(text, fit) : n;
+}
+
+// The outbox delivers after all: hold its channel until `until` (retry_after).
+static void _live_hold_outbox(uint8_t ch, uint32_t until) {
+    ChanOut &o = g_out[ch];
+    if ((int32_t)(until - o.not_before) > 0) o.not_before = until;
+}
+
+// Start a request (placeholder or edit) in the live buffers: path, auth and
+// the body up to its text, which the caller writes at the pointer returned.
+static char *_live_head(LiveReply &l, uint8_t kind) {
+    bool     tg = l.ch == CH_TELEGRAM;
+    uint16_t n;
+    if (tg) {
+        snprintf(l.path, sizeof(l.path), "/bot%s/%s", g_cfg.telegram.token,
+                 kind == LIVE_EDIT ? "editMessageText" : "sendMessage");
+        n = snprintf(l.body, LIVE_BODY_S, "{\"chat_id\":\"%s\",", l.chat);
+        if (kind == LIVE_EDIT)
+            n += snprintf(l.body + n, LIVE_BODY_S - n, "\"message_id\":%s,", l.msg_id);
+        n += snprintf(l.body + n, LIVE_BODY_S - n, "\"text\":\"");
+    } else {
+        snprintf(l.auth, sizeof(l.auth), "Authorization: Bot %s\r\n", g_cfg.discord.token);
+        if (kind == LIVE_EDIT)
+            snprintf(l.path, sizeof(l.path), "/api/v10/channels/%s/messages/%s", l.chat, l.msg_id);
+        else
+            snprintf(l.path, sizeof(l.path), "/api/v10/channels/%s/messages", l.chat);
+        n = strlcpy(l.body, "{\"content\":\"", LIVE_BODY_S);
+    }
+    l.kind = kind;
+    l.head = n;
+    l.body[n] = '\0';
+    return l.body + n;
+}
+
+// Finish the request: escape the text in place and close the body.
+static void _live_request(LiveReply &l) {
+    bool     tg = l.ch == CH_TELEGRAM;
+    uint16_t n  = l.head;
+    n += json_escape_in_place(l.body + n, strlen(l.body + n), LIVE_BODY_S - n - 2);
+    l.body[n++] = '"';
+    l.body[n++] = '}';
+    l.body[n]   = '\0';
+
+    g_suppress_tls_logs = true;
+    http_job_begin(l.job, tg ? g_tls_tg : g_tls_dc, true,
+                   tg ? "api.telegram.org" : "discord.com", 443, l.path,
+                   tg ? nullptr : l.auth, l.body, n, l.resp, sizeof(l.resp), true);
+    g_suppress_tls_logs = false;
+    if (!tg && l.kind == LIVE_EDIT) l.job.method = "PATCH";
+}
+
+static void _live_submit(LiveReply &l) {
+    _live_request(l);
+    if (net_submit(l.job)) l.pending = l.kind;  // else: every slot taken, next pass
+}
+
+// Telegram refuses an edit that changes nothing; that is not a failure.
+static inline bool _live_ok(const LiveReply &l, int16_t code) {
+    return (code >= 200 && code < 300) ||
+           (code == 400 && strstr(l.resp, "not modified"));
+}
+
+// Collect the request in flight, if it finished.
+static void _live_reap(LiveReply &l) {
+    if (l.pending == LIVE_NONE || !net_job_done(l.job)) return;
+    uint8_t kind = l.pending;
+    int16_t code = l.job.code;
+    l.pending = LIVE_NONE;
+
+    if (kind == LIVE_PLACEHOLDER) {
+        if (code >= 200 && code < 300) {
+            int64_t id = jint(jfind(l.resp, "message_id"));
+            if (l.ch == CH_DISCORD) id_from_str(jmember(l.resp, "id"), l.msg_id, ALLOW_ID_LEN);
+            else if (id)            id_from_int64(id, l.msg_id, ALLOW_ID_LEN);
+        }
+        if (!l.msg_id[0]) {
+            l.dead = true;
+            ++l.failed;
+            Serial.printf("[live] %s placeholder failed code=%d : reply goes to the outbox\r\n",
+                          ch_name(l.ch), code);
+        }
+        return;
+    }
+    ++l.edits;
+    if (code == 429) {
+        const char *v = jfind(l.resp, "retry_after");
+        uint32_t wait = l.job.retry_ms ? l.job.retry_ms : v ? _http_secs_ms(v) : 0;
+        ++l.limited;
+        l.not_before = millis() + (wait ? wait : _live_gap(l.ch));
+    } else if (!_live_ok(l, code)) {
+        Serial.printf("[live] %s edit code=%d\r\n", ch_name(l.ch), code);
+    }
+}
+
+// Edit request for the text so far: one message worth, no action tags.
+// Returns the length shown, 0 = nothing to show yet.
+static uint16_t _live_preview(LiveReply &l, const char *text, uint16_t len) {
+    uint16_t lim = _out_limit(l.ch) - 4;
+    uint16_t n   = _live_cut(text, len, lim);
+    char    *t   = _live_head(l, LIVE_EDIT);
+    memcpy(t, text, n);
+    t[n] = '\0';
+    strip_action_tags(t);
+    char *open = strrchr(t, '[');                      // tag still arriving
+    if (open && !strchr(open, ']')) *open = '\0';
+    open = strrchr(t, '<');
+    if (open && !strchr(open, '>')) *open = '\0';
+    n = strlen(t);
+    while (n && (t[n - 1] == ' ' || t[n - 1] == '\n')) t[--n] = '\0';
+    if (n && n + 4 <= lim) { memcpy(t + n, " \xE2\x80\xA6", 5); n += 4; }   // " …": more to come
+    return n;
+}
+
+// ─── live_begin ───────────────────────────────────────────────────────────────
+// agent_task, before agent_run: start a live reply. false = not possible
+// (channel without message edits), reply the usual way.
+static bool live_begin(uint8_t ch, const char *chat, uint32_t t_in) {
+    LiveReply &l = g_live;
+    if (ch != CH_TELEGRAM && ch != CH_DISCORD) return false;
+    l.on = true;  l.dead = false;
+    l.ch = ch;    l.t_in = t_in;
+    strlcpy(l.chat, chat, sizeof(l.chat));
+    l.msg_id[0]  = '\0';
+    l.shown      = 0;
+    l.first      = false;
+    l.not_before = millis() + _live_gap(ch);
+    strcpy(_live_head(l, LIVE_PLACEHOLDER), "\xE2\x80\xA6");
+    _live_submit(l);
+    ++l.replies;
+    return true;
+}
+
+// ─── live_progress ────────────────────────────────────────────────────────────
+// g_llm_on_text, on every pass while the LLM streams: reap, maybe edit.
+static void live_progress(const char *text, uint16_t len) {
+    LiveReply &l = g_live;
+    if (!l.on) return;
+    _live_reap(l);
+    if (l.dead || l.pending) return;
+    if (!l.msg_id[0]) {                         // placeholder could not be queued yet
+        strcpy(_live_head(l, LIVE_PLACEHOLDER), "\xE2\x80\xA6");
+        _live_submit(l);
+        return;
+    }
+    if (len < l.shown) l.shown = 0;             // next LLM round (after a tool call)
+    uint32_t now = millis();
+    if (len < l.shown + LIVE_MIN_GROW || (int32_t)(now - l.not_before) < 0) return;
+    if (!_live_preview(l, text, len)) return;
+    _live_submit(l);
+    if (!l.pending) return;
+    if (!l.first) {
+        l.first = true;
+        ++l.first_n;
+        l.first_ms += now - l.t_in;
+    }
+    l.shown      = len;
+    l.not_before = now + _live_gap(l.ch);
+}
+
+// ─── live_finish ──────────────────────────────────────────────────────────────
+// agent_task, after agent_run: final edit. Returns what the outbox still
+// has to send: "" when the live message holds the whole reply.
+static const char *live_finish(const char *reply) {
+    LiveReply &l = g_live;
+    if (!l.on) return reply;
+    l.on = false;
+
+    // the placeholder (or last edit) in flight
+    while (l.pending) {
+        bool moved = net_inline() && net_core_poll();
+        _live_reap(l);
+        sched_yield_io();
+        if (!moved) delay(1);
+    }
+    if (l.dead || !l.msg_id[0]) return reply;
+
+    // The edit throttle is waited out; a 429 hold is the outbox's to wait.
+    int32_t hold = (int32_t)(l.not_before - millis());
+    if (hold > (int32_t)_live_gap(l.ch)) {
+        _live_hold_outbox(l.ch, l.not_before);
+        ++l.failed;
+        Serial.printf("[live] %s rate-limited for %ld ms : reply goes to the outbox\r\n",
+                      ch_name(l.ch), (long)hold);
+        return reply;
+    }
+    while ((int32_t)(millis() - l.not_before) < 0) { sched_yield_io(); delay(1); }
+
+    uint16_t cut  = _live_cut(reply, strlen(reply), _out_limit(l.ch));
+    char    *t    = _live_head(l, LIVE_EDIT);
+    memcpy(t, reply, cut);
+    t[cut] = '\0';
+    const char *rest = reply + cut;
+    while (*rest == '\n' || *rest == ' ') ++rest;
+
+    _live_request(l);
+    int16_t code = net_call(l.job);
+    ++l.edits;
+    uint32_t now = millis();
+    if (_live_ok(l, code)) {
+        if (!l.first) { ++l.first_n; l.first_ms += now - l.t_in; }
+        if (!rest[0]) {
+            _lat_add(l.ch, now - l.t_in);
+            if (l.ch == CH_DISCORD) dc_chan_delivered(l.chat, now - l.t_in);
+            ++g_out[l.ch].delivered;
+        }
+        Serial.printf("[live] %s final edit code=%d%s\r\n", ch_name(l.ch), code,
+                      rest[0] ? " : rest to the outbox" : "");
+        return rest;
+    }
+    if (code == 429) {
+        const char *v = jfind(l.resp, "retry_after");
+        uint32_t wait = l.job.retry_ms ? l.job.retry_ms : v ? _http_secs_ms(v) : OUT_BACKOFF_MS;
+        ++l.limited;
+        _live_hold_outbox(l.ch, now + wait);
+    }
+    ++l.failed;
+    Serial.printf("[live] %s final edit code=%d : reply goes to the outbox\r\n", ch_name(l.ch), code);
+    return reply;
+}
+
+static void live_print_stats() {
+    const LiveReply &l = g_live;
+    Serial.printf("  Live      : %s  replies %lu  edits %lu  429 %lu  failed %lu"
+                  "  first text avg %lu ms\r\n",
+                  g_cfg.stream_replies ? "on" : "off",
+                  (unsigned long)l.replies, (unsigned long)l.edits,
+                  (unsigned long)l.limited, (unsigned long)l.failed,
+                  (unsigned long)(l.first_n ? l.first_ms / l.first_n : 0));
+}
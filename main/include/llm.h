@@ -36,6 +36,7 @@ static const char k_sys_prompt[] =
 
     "Available actions:\n"
     "  [ACTION:gpio_set     pin=<n>   value=<0|1>]\n"
+    "  [ACTION:gpio_set     pins=<n,n,...> value=<0|1>]   (switches all at once)\n"
     "  [ACTION:gpio_get     pin=<n>]\n"
     "  [ACTION:adc_read     pin=<n>]\n"
     "  [ACTION:serial_write port=<n>  data=<msg>]\n"
@@ -46,8 +47,10 @@ static const char k_sys_prompt[] =
     "  [ACTION:oled_print   bus=<n>   text=<msg> x=<n> y=<n>]\n"
     "  [ACTION:oled_clear   bus=<n>]\n"
     "  [ACTION:tft_print    bus=<n>   text=<msg> x=<n> y=<n> color=<hex>]\n"
-    "  [ACTION:i2c_write    bus=<n>   reg=<hex>  data=<hex>]\n"
-    "  [ACTION:i2c_read     bus=<n>   reg=<hex>  len=<n>]\n\n"
+    "  [ACTION:display_text bus=<n>   lines=\"<l1>|<l2>|...\" x=<n> y=<n> size=<1-4>]\n"
+    "  [ACTION:i2c_write    bus=<n>   reg=<hex>  data=<hex,hex,...>]\n"
+    "  [ACTION:i2c_read     bus=<n>   reg=<hex>  len=<1-32>]\n"
+    "  [ACTION:i2c_xfer     bus=<n>   seq=<w:hex,hex;r:n;...>]   (steps in one action)\n\n"
 
     "Action results come back as [RESULT:...] in the conversation.\n\n"
 
@@ -66,7 +69,7 @@ static const char k_sys_prompt[] =
  * Packed format: role \x01 content \x02 ... repeated.
  * session_append evicts the oldest message when the buffer is too full.
  */
-static char     g_session[SESSION_S];
+static FC_EXT_BSS char g_session[SESSION_S];
 static uint16_t g_session_len = 0;
 
 static void session_append(const char *role, const char *content) {
@@ -85,19 +88,128 @@ static void session_append(const char *role, const char *content) {
     memcpy(g_session + g_session_len, content, clen); g_session_len += clen;
     g_session[g_session_len++] = '\x02';
     g_session[g_session_len]   = '\0';
+    mem_buf_note(MB_SESSION, g_session_len + 1u, SESSION_S);
 }
 
 static void session_clear() { g_session_len = 0; g_session[0] = '\0'; }
 
-// ─── llm_chat ─────────────────────────────────────────────────────────────────
-static bool llm_chat(const char *user_prompt, char *out, uint16_t out_cap) {
+/*
+ * One history buffer, several conversation slots (DcChannel::session;
+ * Telegram and the shell use slot 0). A message for another slot than the
+ * one the history belongs to starts a fresh history, so channels bound to
+ * different slots never see each other's conversation.
+ */
+static uint8_t g_session_slot = 0;
+
+static void session_bind(uint8_t slot) {
+    if (slot == g_session_slot) return;
+    session_clear();
+    g_session_slot = slot;
+}
+
+// ─── Streaming ────────────────────────────────────────────────────────────────
+/*
+ * While g_llm_on_text is set (progressive replies, live.h) llm_chat asks
+ * for "stream":true. The server answers with server-sent events, one
+ * "data: {...choices[0].delta.content...}" line per few tokens. The net
+ * core decodes them as they arrive (HttpJob::sink) and appends only the
+ * delta text to g_http_resp, so a long stream never fills the buffer with
+ * JSON envelopes. The waiting loop() core hands the text so far to
+ * g_llm_on_text on every pass of net_call().
+ *
+ * A server that ignores "stream" sends one plain JSON body; it is kept
+ * raw and parsed as usual once complete.
+ */
+static void (*g_llm_on_text)(const char *text, uint16_t len) = nullptr;
+
+struct LlmStream {
+    HttpJob *job;
+    char     line[LLM_SSE_LINE];
+    uint16_t line_len;
+    bool     started;           // first body byte seen
+    bool     raw;               // not an event stream (error / non-streaming server)
+};
+static LlmStream s_llm_stream;
+
+// Net core: one complete event line.
+static void _llm_sse_line(HttpJob &j, const char *line) {
+    if (strncmp(line, "data:", 5)) return;          // ": keep-alive", "event:", "id:"
+    const char *d = strstr(line, "\"delta\"");
+    if (!d) return;
+    const char *c = jfind(d, "content");
+    if (!c || *c != '"') return;                    // null on the role / finish events
+    uint16_t room = j.out_cap - 1 - j.out_len;
+    if (room < 2) return;
+    jstr(c, j.out + j.out_len, room + 1);
+    j.out_len += strlen(j.out + j.out_len);
+    j.pub.store(j.out_len, std::memory_order_release);
+}
+
+// Net core: HttpJob::sink of a streaming request.
+static void _llm_sink(HttpJob &j, const char *p, uint16_t n) {
+    LlmStream &s = s_llm_stream;
+    if (!s.started) {
+        while (n && (*p == ' ' || *p == '\r' || *p == '\n')) { ++p; --n; }
+        if (!n) return;
+        s.started = true;
+        s.raw = j.code != 200 || *p == '{';
+    }
+    if (s.raw) {
+        uint16_t room = j.out_cap - 1 - j.out_len;
+        if (n > room) n = room;
+        memcpy(j.out + j.out_len, p, n);
+        j.out_len += n;
+        return;
+    }
+    for (; n; ++p, --n) {
+        if (*p != '\n') {
+            if (s.line_len + 1 < LLM_SSE_LINE) s.line[s.line_len++] = *p;
+            continue;
+        }
+        if (s.line_len && s.line[s.line_len - 1] == '\r') --s.line_len;
+        s.line[s.line_len] = '\0';
+        _llm_sse_line(j, s.line);
+        s.line_len = 0;
+    }
+}
+
+// loop() core, inside net_call(): pass the text received so far.
+static void _llm_stream_wait() {
+    if (g_llm_on_text)
+        g_llm_on_text(g_http_resp, s_llm_stream.job->pub.load(std::memory_order_acquire));
+}
+
+static int16_t _llm_stream(char *host, bool plain, uint16_t body_len) {
+    uint16_t port = 443;
+    if (plain) {
+        port = 80;
+        char *colon = strrchr(host, ':');
+        if (colon) { port = (uint16_t)atoi(colon + 1); *colon = '\0'; }
+    }
+    HttpJob j;
+    http_job_begin(j, plain ? (WiFiClient &)g_tcp : g_tls_llm, !plain, host, port,
+                   g_tx_path, g_tx_auth, g_tx_body, body_len, g_http_resp, HTTP_RESP_S);
+    memset(&s_llm_stream, 0, sizeof(s_llm_stream));
+    s_llm_stream.job = &j;
+    j.sink = _llm_sink;
+    return net_call(j, _llm_stream_wait);
+}
+
+// ─── Request body ─────────────────────────────────────────────────────────────
+/*
+ * Assemble the chat-completions request (system prompt + board config,
+ * session history, user_prompt) into g_tx_body.
+ * Returns the body length, or 0 if it did not fit in JSON_OUT_S.
+ */
+static uint16_t _llm_build_body(const char *user_prompt, bool stream) {
     uint16_t pos = 0;
 
     // ── JSON envelope header ────────────────────────────────────────────────
     pos += snprintf(g_tx_body + pos, JSON_OUT_S - pos,
         "{\"model\":\"%s\",\"max_tokens\":%u,\"temperature\":%.2f,"
-        "\"stream\":false,\"messages\":[",
-        g_cfg.llm_model, g_cfg.max_tokens, (double)g_cfg.temperature);
+        "\"stream\":%s,\"messages\":[",
+        g_cfg.llm_model, g_cfg.max_tokens, (double)g_cfg.temperature,
+        stream ? "true" : "false");
 
     // ── System message — direct write, zero intermediate buffers ───────────
     //
@@ -148,7 +260,15 @@ static bool llm_chat(const char *user_prompt, char *out, uint16_t out_cap) {
     //                       json_escape_into returns actual bytes, not would-be).
     // last byte != '\0'  : belt-and-suspenders buffer was completely filled.
     //
-    if (pos >= JSON_OUT_S || g_tx_body[JSON_OUT_S - 1] != '\0') {
+    if (pos >= JSON_OUT_S || g_tx_body[JSON_OUT_S - 1] != '\0') return 0;
+    return pos;
+}
+
+// ─── llm_chat ─────────────────────────────────────────────────────────────────
+static bool _llm_chat(const char *user_prompt, char *out, uint16_t out_cap) {
+    bool stream = g_llm_on_text != nullptr;
+    uint16_t pos = _llm_build_body(user_prompt, stream);
+    if (!pos) {
         session_clear();
         snprintf(out, out_cap, "[session overflow — cleared, retry]");
         return false;
@@ -168,37 +288,41 @@ static bool llm_chat(const char *user_prompt, char *out, uint16_t out_cap) {
         strlcpy(g_tx_path, "/chat/completions", CFG_S);
     }
 
-#ifdef BOARD_ESP32
-    Serial.printf("[LLM] tx=%u B  free_heap=%lu B\r\n",
-                  (unsigned)pos, (unsigned long)ESP.getFreeHeap());
-    if (ESP.getFreeHeap() < 120000) {
+    uint32_t heap = tls_make_room();
+    Serial.printf("[LLM] tx=%u B  free_heap=%lu B\r\n", (unsigned)pos, (unsigned long)heap);
+    if (heap < HEAP_REBOOT_MIN) {
         Serial.println("[WARN] Heap critically low — rebooting to prevent crash");
+        mem_task();                     // last [mem] line, for tuning HEAP_REBOOT_MIN
         delay(200);
+#ifdef BOARD_ESP32
         ESP.restart();
-    }
 #elif defined(BOARD_PICO_W)
-    Serial.printf("[LLM] tx=%u B  free_heap=%lu B\r\n",
-                  (unsigned)pos, (unsigned long)rp2040.getFreeHeap());
-    if (rp2040.getFreeHeap() < 120000) {
-        Serial.println("[WARN] Heap critically low — rebooting to prevent crash");
-        delay(200);
         rp2040.reboot();
-    }
 #endif
+    }
 
-    g_http_busy = true;
     int16_t code;
-    if (strncmp(g_cfg.llm_api_base, "http://", 7) == 0)
+    bool plain = strncmp(g_cfg.llm_api_base, "http://", 7) == 0;
+    if (stream)
+        code = _llm_stream(host, plain, pos);
+    else if (plain)
         code = http_req(host, g_tx_path, g_tx_auth, g_tx_body, pos, g_http_resp, HTTP_RESP_S);
     else
         code = https_req(g_tls_llm, host, g_tx_path, g_tx_auth, g_tx_body, pos, g_http_resp, HTTP_RESP_S);
-    g_http_busy = false;
 
     if (code != 200) {
         snprintf(out, out_cap, "[LLM %d] %.200s", code, g_http_resp);
         return false;
     }
 
+    // Event stream: g_http_resp already holds the plain reply text.
+    if (stream && !s_llm_stream.raw) {
+        strlcpy(out, g_http_resp, out_cap);
+        if (out[0] == '\0') strlcpy(out, "[model returned empty response]", out_cap);
+        return true;
+    }
+
+    uint32_t parse_us = micros();
     char *json_start = g_http_resp;
     if (json_start[0] != '{') {
         char *brace = strchr(g_http_resp, '{');
@@ -237,5 +361,13 @@ static bool llm_chat(const char *user_prompt, char *out, uint16_t out_cap) {
         }
     }
     if (out[0] == '\0') strlcpy(out, "[model returned empty response]", out_cap);
+    hist_add(H_PARSE, micros() - parse_us);
     return true;
+}
+
+static bool llm_chat(const char *user_prompt, char *out, uint16_t out_cap) {
+    uint32_t t0 = micros();
+    bool ok = _llm_chat(user_prompt, out, out_cap);
+    hist_add(H_LLM, micros() - t0);
+    return ok;
 }
\ No newline at end of file
@@ -0,0 +1,231 @@
+/*
+ * ─────────────────────────────────────────────────────────────
+ * FemtoClaw : heap, stack and static-buffer telemetry.
+ *
+ * Heap    free now, lowest free ever, largest free block and the
+ *         fragmentation that follows from them (1 - largest / free).
+ *         Sampled when an HTTP job begins, right after its connect
+ *         (TLS session allocated, the usual low point) and when it
+ *         ends; the largest begin → connect drop is kept as the TLS
+ *         cost. HEAP_REBOOT_MIN (constants.h) should sit below the
+ *         'after connect' minimum seen in normal use.
+ *   ESP32   ESP.getFreeHeap / getMinFreeHeap / getMaxAllocHeap
+ *   Pico W  rp2040.getFreeHeap; the minimum is tracked here and the
+ *           largest block is probed with malloc() on 'mem' only
+ *
+ * Stack   bytes never touched per task / core:
+ *   ESP32   uxTaskGetStackHighWaterMark() of loopTask and fc_net
+ *   Pico W  core0 (linker stack) and core1 (core1_separate_stack) are
+ *           painted with MEM_PAINT at start-up and scanned on 'mem'
+ *
+ * Buffers largest fill seen of the big static buffers, noted where
+ *         they are written (mem_buf_note).
+ *
+ * 'mem' prints everything; a one-line [mem] summary is logged every
+ * MEM_LOG_MS by the "mem" scheduler task.
+ * ─────────────────────────────────────────────────────────────
+ */
+
+#pragma once
+
+static constexpr uint32_t MEM_LOG_MS = 60000;
+static constexpr uint32_t MEM_PAINT  = 0x5AC35AC3u;
+#ifdef CONFIG_ARDUINO_LOOP_STACK_SIZE
+static constexpr uint32_t MEM_LOOP_STACK = CONFIG_ARDUINO_LOOP_STACK_SIZE;
+#else
+static constexpr uint32_t MEM_LOOP_STACK = 8192;     // Arduino-ESP32 loopTask default
+#endif
+static constexpr uint32_t MEM_CORE1_STACK = 0x2000;  // arduino-pico core1_separate_stack
+
+// ─── Heap ─────────────────────────────────────────────────────────────────────
+struct MemStats {
+    uint32_t free_min;        // lowest free heap sampled (Pico W; ESP32 asks the IDF)
+    uint32_t tls_cost_max;    // largest heap drop begin → connect
+    uint32_t conn_free_min;   // lowest free heap right after a connect
+    uint32_t samples;
+};
+
+static MemStats g_mem = { 0xFFFFFFFFu, 0, 0xFFFFFFFFu, 0 };
+
+static inline uint32_t mem_free() {
+#ifdef BOARD_ESP32
+    return ESP.getFreeHeap();
+#else
+    return rp2040.getFreeHeap();
+#endif
+}
+
+static uint32_t mem_free_min() {
+#ifdef BOARD_ESP32
+    return ESP.getMinFreeHeap();
+#else
+    return g_mem.free_min;
+#endif
+}
+
+// Called on either core; a lost update only misses one sample.
+static uint32_t mem_sample() {
+    uint32_t f = mem_free();
+    if (f < g_mem.free_min) g_mem.free_min = f;
+    ++g_mem.samples;
+    return f;
+}
+
+// Around an HTTP connect: `before` is mem_sample() at job begin.
+static void mem_sample_conn(uint32_t before) {
+    uint32_t f = mem_sample();
+    if (f < g_mem.conn_free_min) g_mem.conn_free_min = f;
+    if (before > f && before - f > g_mem.tls_cost_max) g_mem.tls_cost_max = before - f;
+}
+
+#ifdef BOARD_PICO_W
+// No allocator query for it: binary-search the largest malloc() that succeeds.
+static uint32_t _mem_largest_probe() {
+    uint32_t lo = 0, hi = rp2040.getFreeHeap();
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo + 1) / 2;
+        void *p = malloc(mid);
+        if (p) { free(p); lo = mid; }
+        else   hi = mid - 1;
+    }
+    return lo;
+}
+#endif
+
+static uint32_t mem_largest() {
+#ifdef BOARD_ESP32
+    return ESP.getMaxAllocHeap();
+#else
+    return _mem_largest_probe();
+#endif
+}
+
+// ─── Stack ────────────────────────────────────────────────────────────────────
+struct MemStack {
+    const char *name;
+    uint32_t    size;
+#ifdef BOARD_ESP32
+    TaskHandle_t task;
+#else
+    uint32_t   *bottom;       // lowest word of the painted region
+    uint32_t    words;
+#endif
+};
+
+static MemStack g_mem_stk[2];
+static uint8_t  g_mem_stk_n = 0;
+
+#ifdef BOARD_ESP32
+// h == nullptr : the calling task.
+static void mem_stack_watch(const char *name, TaskHandle_t h, uint32_t size) {
+    if (g_mem_stk_n >= 2) return;
+    g_mem_stk[g_mem_stk_n++] = { name, size, h ? h : xTaskGetCurrentTaskHandle() };
+}
+
+static uint32_t _mem_stack_free(const MemStack &s) {
+    return uxTaskGetStackHighWaterMark(s.task);   // bytes on ESP-IDF
+}
+#else
+extern "C" uint32_t __StackBottom, __StackTop;    // core0 stack, from the linker script
+extern uint32_t *core1_separate_stack_address;    // arduino-pico, core1_separate_stack
+
+/*
+* Paint the calling core's stack from `bottom` up to a little below the
+* current frame. Untouched words are counted from the bottom later on.
+*/
+static void mem_stack_watch(const char *name, uint32_t *bottom, uint32_t size) {
+    if (g_mem_stk_n >= 2 || !bottom) return;
+    volatile uint32_t here;
+    uint32_t *top = (uint32_t *)((uintptr_t)&here & ~3u) - 64;
+    if (top <= bottom) return;
+    for (uint32_t *p = bottom; p < top; ++p) *p = MEM_PAINT;
+    g_mem_stk[g_mem_stk_n++] = { name, size, bottom, (uint32_t)(top - bottom) };
+}
+
+static uint32_t _mem_stack_free(const MemStack &s) {
+    uint32_t n = 0;
+    while (n < s.words && s.bottom[n] == MEM_PAINT) ++n;
+    return n * 4;
+}
+#endif
+
+// ─── Static buffers ───────────────────────────────────────────────────────────
+enum MemBuf : uint8_t {
+    MB_HTTP_RESP, MB_TG_POLL, MB_TX_BODY, MB_SESSION, MB_LLM_OUT,
+    MB_CMD, MB_BOARD_MD, MB_ARENA, MB_COUNT
+};
+
+static const char *const k_mem_buf_name[MB_COUNT] = {
+    "g_http_resp", "tg poll resp", "g_tx_body", "g_session", "g_llm_out",
+    "g_cmd", "board_md", "g_arena"
+};
+
+struct MemBufUse {
+    uint16_t cap;
+    uint16_t max;
+};
+
+static MemBufUse g_mem_buf[MB_COUNT];
+
+static inline void mem_buf_note(uint8_t b, uint32_t used, uint16_t cap) {
+    MemBufUse &u = g_mem_buf[b];
+    u.cap = cap;
+    if (used > u.max) u.max = used > 0xFFFF ? 0xFFFF : (uint16_t)used;
+}
+
+// ─── Report ───────────────────────────────────────────────────────────────────
+static uint8_t _mem_frag_pct(uint32_t free_b, uint32_t largest) {
+    if (!free_b || largest >= free_b) return 0;
+    return (uint8_t)(100 - (uint64_t)largest * 100 / free_b);
+}
+
+static void mem_print() {
+    uint32_t f = mem_sample(), big = mem_largest();
+    Serial.printf("\r\n  heap free     : %lu B\r\n"
+                  "  heap min ever : %lu B\r\n"
+                  "  largest block : %lu B  (fragmentation %u%%)\r\n"
+                  "  after connect : %lu B min   TLS cost %lu B max   (%lu samples)\r\n"
+                  "  reboot below  : %lu B\r\n",
+                  (unsigned long)f, (unsigned long)mem_free_min(),
+                  (unsigned long)big, (unsigned)_mem_frag_pct(f, big),
+                  (unsigned long)(g_mem.conn_free_min == 0xFFFFFFFFu ? 0 : g_mem.conn_free_min),
+                  (unsigned long)g_mem.tls_cost_max, (unsigned long)g_mem.samples,
+                  (unsigned long)HEAP_REBOOT_MIN);
+
+    Serial.print("\r\n  stack          size    unused\r\n");
+    for (uint8_t i = 0; i < g_mem_stk_n; ++i)
+        Serial.printf("  %-10s %8lu  %8lu\r\n", g_mem_stk[i].name,
+                      (unsigned long)g_mem_stk[i].size,
+                      (unsigned long)_mem_stack_free(g_mem_stk[i]));
+
+    mem_buf_note(MB_BOARD_MD, strlen(g_cfg.board_md) + 1, sizeof(g_cfg.board_md));
+    mem_buf_note(MB_ARENA, g_arena_peak, ARENA_S);
+    Serial.print("\r\n  buffer             max      cap\r\n");
+    for (uint8_t b = 0; b < MB_COUNT; ++b) {
+        const MemBufUse &u = g_mem_buf[b];
+        if (!u.cap) { Serial.printf("  %-14s        -        -\r\n", k_mem_buf_name[b]); continue; }
+        Serial.printf("  %-14s %7u  %7u  %3u%%\r\n", k_mem_buf_name[b],
+                      (unsigned)u.max, (unsigned)u.cap, (unsigned)(u.max * 100u / u.cap));
+    }
+    if (g_arena_fails) Serial.printf("  arena full    : %u time(s)\r\n", (unsigned)g_arena_fails);
+#ifdef FC_ARENA_DEBUG
+    Serial.printf("  arena canaries: %s\r\n", arena_check() && !g_arena_smashed ? "intact" : "SMASHED");
+#endif
+}
+
+// Scheduler task (io), every MEM_LOG_MS. No largest-block probe here.
+static void mem_task() {
+    uint32_t f = mem_sample();
+    Serial.printf("[mem] free=%lu min=%lu conn_min=%lu tls_max=%lu",
+                  (unsigned long)f, (unsigned long)mem_free_min(),
+                  (unsigned long)(g_mem.conn_free_min == 0xFFFFFFFFu ? 0 : g_mem.conn_free_min),
+                  (unsigned long)g_mem.tls_cost_max);
+#ifdef BOARD_ESP32
+    uint32_t big = ESP.getMaxAllocHeap();
+    Serial.printf(" big=%lu frag=%u%%", (unsigned long)big, (unsigned)_mem_frag_pct(f, big));
+#endif
+    for (uint8_t i = 0; i < g_mem_stk_n; ++i)
+        Serial.printf(" %s=%lu", g_mem_stk[i].name, (unsigned long)_mem_stack_free(g_mem_stk[i]));
+    Serial.printf(" arena=%u/%u", (unsigned)g_arena_peak, (unsigned)ARENA_S);
+    Serial.print("\r\n");
+}
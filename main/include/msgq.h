@@ -0,0 +1,365 @@
+/*
+ * ─────────────────────────────────────────────────────────────
+ * FemtoClaw : channel ⇄ agent message queues.
+ *
+ * Polling, the agent and sending are three separate scheduler tasks:
+ *
+ *   tg_poll / dc_poll ─▶ g_inbox ─▶ agent_task ─▶ g_out[ch].q ─▶ outbox_task
+ *   (parse + enqueue)              (agent_run)                 (tg_send_chunk /
+ *                                                               dc_send_chunk)
+ *
+ * A poll only parses g_http_resp and enqueues, so the buffer is never
+ * overwritten by an LLM call half way through a batch of updates, and a
+ * slow LLM call no longer delays the next poll past one scheduler pass.
+ * agent_task runs one message per pass; outbox_task delivers replies,
+ * see "Outbound delivery" below.
+ *
+ * Both queues are SpscQueue rings (spsc.h), and every producer and
+ * consumer runs on the loop() core. The inbox is filled by the pollers
+ * (net tasks) and by webhook_task / dcg_task, which are io tasks and so
+ * may also run inside a net task's request (sched_yield_io). None of
+ * them yields between back() and commit(), so posts never interleave and
+ * the ring still sees one producer context; agent_task is its only
+ * consumer. Records are filled and read in place (back/commit,
+ * front/drop): no copies of the text.
+ *
+ * Pollers ask inbox_room() for the number of free slots and request at
+ * most that many updates, so nothing is fetched that cannot be queued.
+ *
+ * Depends on: spsc.h, arena.h, agent.h, http.h, config.h
+ * ─────────────────────────────────────────────────────────────
+ */
+
+#pragma once
+
+enum : uint8_t { CH_TELEGRAM = 0, CH_DISCORD = 1 };
+
+struct InMsg {
+    uint8_t  ch;
+    uint8_t  session;           // conversation slot (llm.h session_bind)
+    uint32_t t_in;              // millis() when polled, for reply latency
+    char     chat[ALLOW_ID_LEN];
+    char     text[PROMPT_S];
+};
+
+static SpscQueue<InMsg, INBOX_Q> g_inbox;
+static uint32_t g_inbox_full = 0;      // posts refused because the inbox was full
+
+static const char *ch_name(uint8_t ch) {
+    return ch == CH_TELEGRAM ? "Telegram" : "Discord";
+}
+
+static inline uint8_t inbox_room() { return (uint8_t)(INBOX_Q - g_inbox.size()); }
+
+// Channel side: queue one incoming message. false when the inbox is full.
+static bool inbox_post(uint8_t ch, const char *chat, const char *text, uint8_t session = 0) {
+    InMsg *m = g_inbox.back();
+    if (!m) { ++g_inbox_full; return false; }
+    m->ch      = ch;
+    m->session = session;
+    m->t_in = millis();
+    strlcpy(m->chat, chat, sizeof(m->chat));
+    strlcpy(m->text, text, sizeof(m->text));
+    g_inbox.commit();
+    return true;
+}
+
+/*
+ * ─── Outbound delivery ───────────────────────────────────────────────────────
+ *
+ * One ChanOut per channel: a reply queue plus the delivery state.
+ *
+ *   packing    replies are cut into channel-sized chunks at a line break,
+ *              else a space, else a UTF-8 character boundary. Replies
+ *              queued for the same chat share a chunk while they fit
+ *              (blank line between), so a burst costs one request.
+ *              A chunk is only a span of the queue (off, chunk_n,
+ *              chunk_cut): its text is put together in the arena for
+ *              each try, and the replies leave the queue once it is
+ *              delivered or dropped.
+ *   pacing     token bucket per channel (OUT_*_RATE_MS per message,
+ *              OUT_*_BURST deep). X-RateLimit-Remaining: 0 holds the
+ *              channel until X-RateLimit-Reset-After.
+ *   429        wait Retry-After / "retry_after" from the body, then resend
+ *              the same chunk; counted apart from failed tries, and
+ *              OUT_MAX_429 of them drop the chunk, so a chat that stays
+ *              rate-limited cannot hold the channel forever.
+ *   failure    network errors, 408 and 5xx retry with exponential backoff
+ *              from OUT_BACKOFF_MS; other 4xx, or OUT_MAX_TRIES failures,
+ *              drop the chunk and count it.
+ *   warm TLS   sends ask https_req() for keep-alive, so back-to-back
+ *              chunks reuse the open connection instead of a new handshake.
+ *
+ * outbox_task makes at most one request per channel per pass.
+ */
+static constexpr uint8_t  OUT_MAX_TRIES     = 5;
+static constexpr uint8_t  OUT_MAX_429       = 8;
+static constexpr uint32_t OUT_BACKOFF_MS    = 1000;
+static constexpr uint32_t OUT_BACKOFF_MAX   = 30000;
+static constexpr uint32_t OUT_TG_RATE_MS    = 1000;   // Telegram: ~1 msg/s per chat
+static constexpr uint8_t  OUT_TG_BURST      = 3;
+static constexpr uint32_t OUT_DC_RATE_MS    = 1000;   // Discord: 5 msg / 5 s per channel
+static constexpr uint8_t  OUT_DC_BURST      = 5;
+
+struct OutMsg {
+    uint32_t t_in;              // from the InMsg it answers
+    char     chat[ALLOW_ID_LEN];
+    char     text[RESP_S];
+};
+
+struct ChanOut {
+    SpscQueue<OutMsg, OUTBOX_Q> q;
+    uint16_t off;                   // bytes of q.front() already sent
+    uint16_t chunk_len;             // 0 = nothing packed
+    uint16_t chunk_cut;             // bytes of q.front() in the chunk, 0 = whole replies
+    uint8_t  chunk_n;               // queued replies the chunk spans
+    char     chat[ALLOW_ID_LEN];    // target of the packed chunk
+    uint8_t  chunk_msgs;            // replies finished by this chunk
+    uint32_t chunk_t_in;            // oldest t_in among them
+    uint8_t  tries;
+    uint8_t  limits;                // 429s for this chunk
+    uint32_t not_before;            // millis(): backoff / retry_after / reset
+    uint32_t credit_ms;             // token bucket, in ms of send time
+    uint32_t credit_at;
+    bool     primed;
+    // metrics
+    uint32_t requests, delivered, retries, limited, dropped, reused;
+};
+
+static ChanOut g_out[2];
+
+/*
+ * Reply latency: message polled → last chunk of its reply delivered.
+ * The last LAT_N samples are kept; status prints median and max.
+ */
+static constexpr uint8_t LAT_N = 32;
+static uint32_t g_lat[LAT_N];
+static uint8_t  g_lat_n = 0, g_lat_w = 0;
+
+static void _lat_add(uint8_t ch, uint32_t ms) {
+    hist_add_ms(ch == CH_TELEGRAM ? H_E2E_TG : H_E2E_DC, ms);
+    g_lat[g_lat_w] = ms;
+    g_lat_w = (uint8_t)((g_lat_w + 1) % LAT_N);
+    if (g_lat_n < LAT_N) ++g_lat_n;
+}
+
+static inline uint16_t _out_limit(uint8_t ch) { return ch == CH_TELEGRAM ? TG_MSG_CHUNK : DC_MSG_CHUNK; }
+
+// Length of the first piece of s (≤ room bytes) that ends on a boundary.
+static uint16_t _out_cut(const char *s, uint16_t room) {
+    uint16_t half = room / 2;
+    for (uint16_t i = room; i > half; --i) if (s[i - 1] == '\n') return i;
+    for (uint16_t i = room; i > half; --i) if (s[i - 1] == ' ')  return i;
+    uint16_t i = room;
+    while (i > 0 && ((uint8_t)s[i] & 0xC0) == 0x80) --i;    // not inside a UTF-8 sequence
+    return i ? i : room;
+}
+
+// Plan the channel's next chunk from its queue. Returns false when idle.
+static bool _out_pack(uint8_t ch) {
+    ChanOut &c   = g_out[ch];
+    uint16_t lim = _out_limit(ch);
+    uint16_t len = 0;
+    c.chunk_n    = 0;
+    c.chunk_cut  = 0;
+    c.chunk_msgs = 0;
+    c.chunk_t_in = 0;
+
+    OutMsg *m;
+    while ((m = c.q.peek(c.chunk_n)) != nullptr) {
+        if (len && strcmp(m->chat, c.chat) != 0) break;
+        if (!len) strlcpy(c.chat, m->chat, sizeof(c.chat));
+
+        const char *s   = m->text + (c.chunk_n ? 0 : c.off);
+        uint16_t    rem = strlen(s);
+        uint16_t    sep = len ? 2 : 0;
+        if (len + sep + rem <= lim) {
+            len += sep + rem;
+            if (!c.chunk_msgs) c.chunk_t_in = m->t_in;
+            ++c.chunk_n;
+            ++c.chunk_msgs;
+            continue;
+        }
+        if (len) break;                   // next reply goes in the next chunk
+
+        c.chunk_cut = len = _out_cut(s, lim);
+        c.chunk_n   = 1;
+        while (s[len] == '\n' || s[len] == ' ') ++len;
+        if (!s[len]) {
+            c.chunk_t_in = m->t_in;
+            ++c.chunk_msgs;
+        }
+        len = c.chunk_cut;
+        break;
+    }
+    c.chunk_len = len;
+    c.tries     = 0;
+    c.limits    = 0;
+    return len > 0;
+}
+
+// Put the packed chunk's text together in buf (chunk_len + 1 bytes).
+static void _out_render(ChanOut &c, char *buf) {
+    uint16_t len = 0;
+    for (uint8_t i = 0; i < c.chunk_n; ++i) {
+        const char *s = c.q.peek(i)->text + (i ? 0 : c.off);
+        uint16_t    n = c.chunk_cut ? c.chunk_cut : strlen(s);
+        if (i) { buf[len++] = '\n'; buf[len++] = '\n'; }
+        memcpy(buf + len, s, n);
+        len += n;
+    }
+    buf[len] = '\0';
+}
+
+// The chunk is done with (delivered or dropped): its replies leave the queue.
+static void _out_consume(ChanOut &c) {
+    if (c.chunk_cut) {
+        const char *t = c.q.front()->text;
+        c.off += c.chunk_cut;
+        while (t[c.off] == '\n' || t[c.off] == ' ') ++c.off;
+        if (!t[c.off]) { c.off = 0; c.q.drop(); }
+    } else {
+        for (uint8_t i = 0; i < c.chunk_n; ++i) c.q.drop();
+        c.off = 0;
+    }
+    c.chunk_len = 0;
+}
+
+static bool _out_take_token(ChanOut &c, uint8_t ch, uint32_t now) {
+    uint32_t rate = ch == CH_TELEGRAM ? OUT_TG_RATE_MS : OUT_DC_RATE_MS;
+    uint32_t cap  = rate * (ch == CH_TELEGRAM ? OUT_TG_BURST : OUT_DC_BURST);
+    if (!c.primed) { c.primed = true; c.credit_ms = cap; c.credit_at = now; }
+    c.credit_ms += now - c.credit_at;
+    c.credit_at  = now;
+    if (c.credit_ms > cap) c.credit_ms = cap;
+    if (c.credit_ms < rate) return false;
+    c.credit_ms -= rate;
+    return true;
+}
+
+// Telegram puts retry_after (s) in the JSON body, Discord as well (float s).
+static uint32_t _out_body_retry_ms() {
+    const char *v = jfind(g_http_resp, "retry_after");
+    return v ? _http_secs_ms(v) : 0;
+}
+
+static int16_t tg_send_chunk(const char *chat_id, const char *text, HttpMeta *meta);   // telegram.h
+static int16_t dc_send_chunk(const char *channel, const char *text, HttpMeta *meta);   // discord.h
+static void    dc_chan_delivered(const char *channel, uint32_t ms);                    // discord.h
+
+static void _out_service(uint8_t ch) {
+    ChanOut &c = g_out[ch];
+    if (!c.chunk_len && !_out_pack(ch)) return;
+
+    uint32_t now = millis();
+    if ((int32_t)(now - c.not_before) < 0) return;
+    if (!_out_take_token(c, ch, now)) return;
+
+    ArenaScope scope;
+    char *text = arena_alloc(c.chunk_len + 1);
+    if (!text) return;                    // logged; next pass
+    _out_render(c, text);
+
+    HttpMeta meta = {};
+    meta.keep_alive = true;
+    uint32_t t0 = micros();
+    int16_t code = (ch == CH_TELEGRAM) ? tg_send_chunk(c.chat, text, &meta)
+                                       : dc_send_chunk(c.chat, text, &meta);
+    hist_add(H_SEND, micros() - t0);
+    now = millis();
+    ++c.requests;
+    if (meta.reused) ++c.reused;
+    if (meta.rl_remaining == 0 && meta.rl_reset_ms) c.not_before = now + meta.rl_reset_ms;
+
+    if (code >= 200 && code < 300) {
+        if (c.chunk_msgs) _lat_add(ch, now - c.chunk_t_in);
+        if (c.chunk_msgs && ch == CH_DISCORD) dc_chan_delivered(c.chat, now - c.chunk_t_in);
+        c.delivered += c.chunk_msgs;
+        _out_consume(c);
+        return;
+    }
+    if (code == 429 && ++c.limits < OUT_MAX_429) {
+        uint32_t wait = meta.retry_after_ms ? meta.retry_after_ms : _out_body_retry_ms();
+        if (!wait) wait = OUT_BACKOFF_MS;
+        ++c.limited;
+        c.not_before = now + wait;
+        Serial.printf("[%s] 429 : retrying in %lu ms\r\n", ch_name(ch), (unsigned long)wait);
+        return;
+    }
+    bool transient = code < 0 || code == 408 || code >= 500;
+    if (transient && ++c.tries < OUT_MAX_TRIES) {
+        uint32_t wait = OUT_BACKOFF_MS << (c.tries - 1);
+        if (wait > OUT_BACKOFF_MAX) wait = OUT_BACKOFF_MAX;
+        ++c.retries;
+        c.not_before = now + wait;
+        Serial.printf("[%s] send failed code=%d : retry %u in %lu ms\r\n",
+                      ch_name(ch), code, (unsigned)c.tries, (unsigned long)wait);
+        return;
+    }
+    ++c.dropped;
+    Serial.printf("[%s] send FAILED code=%d : chunk dropped  resp=%.100s\r\n",
+                  ch_name(ch), code, g_http_resp);
+    _out_consume(c);
+}
+
+// ─── outbox_task ──────────────────────────────────────────────────────────────
+// Scheduler task (net): at most one request per channel per pass.
+static void outbox_task() {
+    _out_service(CH_TELEGRAM);
+    _out_service(CH_DISCORD);
+}
+
+static bool        live_begin(uint8_t ch, const char *chat, uint32_t t_in);         // live.h
+static void        live_progress(const char *text, uint16_t len);                   // live.h
+static const char *live_finish(const char *reply);                                  // live.h
+
+// ─── agent_task ───────────────────────────────────────────────────────────────
+// Scheduler task (net): one inbox message → agent_run → one reply on the
+// channel's queue. Waits while that queue is full so replies are never lost.
+// With stream_replies the reply is shown as it is generated (live.h); only
+// what did not fit the live message, or all of it if that failed, is queued.
+static void agent_task() {
+    InMsg *m = g_inbox.front();
+    if (!m) return;
+    OutMsg *o = g_out[m->ch].q.back();
+    if (!o) return;
+
+    Serial.printf("[agent] %s chat %s : '%s'\r\n", ch_name(m->ch), m->chat, m->text);
+    session_bind(m->session);
+    g_agent_turn = true;                        // live_finish() yields too
+    bool live = g_cfg.stream_replies && live_begin(m->ch, m->chat, m->t_in);
+    if (live) g_llm_on_text = live_progress;
+    const char *reply = agent_run(m->text);
+    g_llm_on_text = nullptr;
+    if (live) reply = live_finish(reply);
+    g_agent_turn = false;
+
+    if (reply[0]) {
+        o->t_in = m->t_in;
+        strlcpy(o->chat, m->chat, sizeof(o->chat));
+        strlcpy(o->text, reply,   sizeof(o->text));
+        g_out[m->ch].q.commit();
+    }
+    g_inbox.drop();
+}
+
+static void msgq_print_stats() {
+    uint32_t s[LAT_N];
+    memcpy(s, g_lat, sizeof(s));
+    for (uint8_t i = 1; i < g_lat_n; ++i)              // insertion sort, ≤ 32 samples
+        for (uint8_t k = i; k > 0 && s[k - 1] > s[k]; --k) { uint32_t x = s[k]; s[k] = s[k - 1]; s[k - 1] = x; }
+    Serial.printf("  Inbox     : %u/%u  (full %lu)  reply latency median %lu ms  max %lu ms  (n=%u)\r\n",
+                  (unsigned)g_inbox.size(), (unsigned)INBOX_Q, (unsigned long)g_inbox_full,
+                  (unsigned long)(g_lat_n ? s[g_lat_n / 2] : 0),
+                  (unsigned long)(g_lat_n ? s[g_lat_n - 1] : 0), (unsigned)g_lat_n);
+    for (uint8_t ch = CH_TELEGRAM; ch <= CH_DISCORD; ++ch) {
+        const ChanOut &c = g_out[ch];
+        Serial.printf("  Out %-8s: queued %u/%u%s  req %lu  delivered %lu  reused %lu"
+                      "  retries %lu  429 %lu  dropped %lu\r\n",
+                      ch_name(ch), (unsigned)c.q.size(), (unsigned)OUTBOX_Q,
+                      c.chunk_len ? "+chunk" : "",
+                      (unsigned long)c.requests, (unsigned long)c.delivered,
+                      (unsigned long)c.reused, (unsigned long)c.retries,
+                      (unsigned long)c.limited, (unsigned long)c.dropped);
+    }
+}
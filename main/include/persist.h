@@ -1,7 +1,7 @@
 #pragma once
 
 static int64_t g_tg_offset = 0;
-static char g_dc_last_msg_id[ALLOW_ID_LEN] = {0};
+static char g_dc_cursor[DC_CHANNELS_MAX][ALLOW_ID_LEN] = {};   // per g_cfg.dc_ch row
 
 #if PERSIST_IMPL == 1
 // ESP32: use Preferences (NVS)
@@ -17,6 +17,8 @@ static void cfg_save() {
   prefs.putFloat ("temperature",      g_cfg.temperature);
   prefs.putUChar ("max_tool_iters",   g_cfg.max_tool_iters);
   prefs.putUInt  ("heartbeat_ms",     g_cfg.heartbeat_ms);
+  prefs.putBool  ("stream_replies",   g_cfg.stream_replies);
+  prefs.putString("api_host",         g_cfg.api_host);
   prefs.putBool  ("tg_enabled",       g_cfg.telegram.enabled);
   prefs.putString("tg_token",         g_cfg.telegram.token);
   prefs.putUChar ("tg_allow_count",   g_cfg.telegram.allow_count);
@@ -24,9 +26,13 @@ static void cfg_save() {
     char k[16]; snprintf(k, 16, "tg_allow_%u", i);
     prefs.putString(k, g_cfg.telegram.allow_from[i]);
   }
+  prefs.putUShort("tg_wh_port",       g_cfg.tg_webhook_port);
+  prefs.putString("tg_wh_secret",     g_cfg.tg_webhook_secret);
   prefs.putBool  ("dc_enabled",       g_cfg.discord.enabled);
   prefs.putString("dc_token",         g_cfg.discord.token);
-  prefs.putString("dc_channel_id",    g_cfg.discord_channel_id);
+  prefs.putUChar ("dc_ch_count",      g_cfg.dc_ch_count);
+  if (g_cfg.dc_ch_count)
+    prefs.putBytes("dc_ch", g_cfg.dc_ch, sizeof(DcChannel) * g_cfg.dc_ch_count);
   prefs.putUChar ("dc_allow_count",   g_cfg.discord.allow_count);
   for (uint8_t i = 0; i < g_cfg.discord.allow_count; ++i) {
     char k[16]; snprintf(k, 16, "dc_allow_%u", i);
@@ -34,7 +40,7 @@ static void cfg_save() {
   }
   // Save polling cursors so they persist across reboots
   prefs.putLong64("tg_offset", g_tg_offset);
-  prefs.putString("dc_last_id", g_dc_last_msg_id);
+  prefs.putBytes("dc_cursor", g_dc_cursor, sizeof(g_dc_cursor));
   // Board config : stored as a NVS blob (up to 4 KB)
   prefs.putBool  ("board_loaded",  g_cfg.board_md_loaded);
   if (g_cfg.board_md_loaded)
@@ -42,6 +48,23 @@ static void cfg_save() {
   prefs.end();
 }
 
+// Stored board config → g_cfg.board_md (cfg_load, and a failed board push
+// putting the old one back). false when none is stored.
+static bool board_md_load() {
+  g_cfg.board_md[0] = '\0';
+  prefs.begin("femtoclaw", true);
+  g_cfg.board_md_loaded = prefs.getBool("board_loaded", false);
+  if (g_cfg.board_md_loaded) {
+    size_t bsz = prefs.getBytesLength("board_md");
+    if (bsz > 0 && bsz < sizeof(g_cfg.board_md))
+      prefs.getBytes("board_md", g_cfg.board_md, bsz);
+    else
+      g_cfg.board_md_loaded = false; // corrupt / oversized => ignore
+  }
+  prefs.end();
+  return g_cfg.board_md_loaded;
+}
+
 static void cfg_load() {
   // Set defaults first
   strlcpy(g_cfg.llm_provider,  "openrouter", 32);
@@ -67,6 +90,8 @@ static void cfg_load() {
   g_cfg.temperature    = prefs.getFloat ("temperature",    g_cfg.temperature);
   g_cfg.max_tool_iters = prefs.getUChar ("max_tool_iters", g_cfg.max_tool_iters);
   g_cfg.heartbeat_ms   = prefs.getUInt  ("heartbeat_ms",   g_cfg.heartbeat_ms);
+  g_cfg.stream_replies = prefs.getBool  ("stream_replies", false);
+  prefs.getString("api_host",      g_cfg.api_host,         CFG_S);
   g_cfg.telegram.enabled = prefs.getBool("tg_enabled", false);
   prefs.getString("tg_token",      g_cfg.telegram.token,   CFG_S);
   g_cfg.telegram.allow_count = prefs.getUChar("tg_allow_count", 0);
@@ -74,9 +99,10 @@ static void cfg_load() {
     char k[16]; snprintf(k, 16, "tg_allow_%u", i);
     prefs.getString(k, g_cfg.telegram.allow_from[i], ALLOW_ID_LEN);
   }
+  g_cfg.tg_webhook_port = prefs.getUShort("tg_wh_port", 0);
+  prefs.getString("tg_wh_secret",  g_cfg.tg_webhook_secret, sizeof(g_cfg.tg_webhook_secret));
   g_cfg.discord.enabled = prefs.getBool("dc_enabled", false);
   prefs.getString("dc_token",      g_cfg.discord.token,    CFG_S);
-  prefs.getString("dc_channel_id", g_cfg.discord_channel_id, ALLOW_ID_LEN);
   g_cfg.discord.allow_count = prefs.getUChar("dc_allow_count", 0);
   for (uint8_t i = 0; i < g_cfg.discord.allow_count; ++i) {
     char k[16]; snprintf(k, 16, "dc_allow_%u", i);
@@ -84,23 +110,32 @@ static void cfg_load() {
   }
   // Restore polling cursors
   g_tg_offset = prefs.getLong64("tg_offset", 0);
-  prefs.getString("dc_last_id", g_dc_last_msg_id, sizeof(g_dc_last_msg_id));
-  g_cfg.board_md_loaded = prefs.getBool("board_loaded", false);
-  if (g_cfg.board_md_loaded) {
-    size_t bsz = prefs.getBytesLength("board_md");
-    if (bsz > 0 && bsz < sizeof(g_cfg.board_md))
-      prefs.getBytes("board_md", g_cfg.board_md, bsz);
-    else
-      g_cfg.board_md_loaded = false; // corrupt / oversized => ignore
+  g_cfg.dc_ch_count = prefs.getUChar("dc_ch_count", 0xFF);
+  if (g_cfg.dc_ch_count == 0xFF) {
+    // Saved before the channel table: one channel id + one cursor.
+    g_cfg.dc_ch_count = 0;
+    prefs.getString("dc_channel_id", g_cfg.dc_ch[0].id, ALLOW_ID_LEN);
+    if (g_cfg.dc_ch[0].id[0]) {
+      g_cfg.dc_ch_count = 1;
+      prefs.getString("dc_last_id", g_dc_cursor[0], ALLOW_ID_LEN);
+    }
+  } else {
+    if (g_cfg.dc_ch_count > DC_CHANNELS_MAX) g_cfg.dc_ch_count = 0;
+    if (g_cfg.dc_ch_count)
+      prefs.getBytes("dc_ch", g_cfg.dc_ch, sizeof(DcChannel) * g_cfg.dc_ch_count);
+    prefs.getBytes("dc_cursor", g_dc_cursor, sizeof(g_dc_cursor));
   }
   prefs.end();
+  board_md_load();
 }
 
 #elif PERSIST_IMPL == 2
 // Pico W: LittleFS
 static void cfg_save() {
-  static char buf[2048];
-  int n = snprintf(buf, sizeof(buf),
+  ArenaScope scope;
+  char *buf = arena_alloc(CFG_JSON_S);
+  if (!buf) { Serial.println("[cfg_save] ERROR: no scratch memory — not saved"); return; }
+  int n = snprintf(buf, CFG_JSON_S,
     "{"
       "\"wifi_ssid\":\"%s\","
       "\"wifi_pass\":\"%s\","
@@ -112,6 +147,8 @@ static void cfg_save() {
       "\"temperature\":%.2f,"
       "\"max_tool_iters\":%u,"
       "\"heartbeat_ms\":%lu,"
+      "\"stream_replies\":%s,"
+      "\"api_host\":\"%s\","
       "\"tg_enabled\":%s,"
       "\"tg_token\":\"%s\","
       "\"tg_allow_count\":%u,"
@@ -120,31 +157,41 @@ static void cfg_save() {
     g_cfg.llm_provider, g_cfg.llm_api_key, g_cfg.llm_api_base, g_cfg.llm_model,
     g_cfg.max_tokens, (double)g_cfg.temperature, g_cfg.max_tool_iters,
     (unsigned long)g_cfg.heartbeat_ms,
+    g_cfg.stream_replies?"true":"false",
+    g_cfg.api_host,
     g_cfg.telegram.enabled?"true":"false",
     g_cfg.telegram.token, g_cfg.telegram.allow_count);
   for (uint8_t i=0; i<g_cfg.telegram.allow_count; ++i) {
-    n += snprintf(buf+n, sizeof(buf)-n, "%s\"%s\"", i?",":"", g_cfg.telegram.allow_from[i]);
+    n += snprintf(buf+n, CFG_JSON_S-n, "%s\"%s\"", i?",":"", g_cfg.telegram.allow_from[i]);
   }
-  n += snprintf(buf+n, sizeof(buf)-n,
+  n += snprintf(buf+n, CFG_JSON_S-n,
     "],"
+    "\"tg_wh_port\":%u,"
+    "\"tg_wh_secret\":\"%s\","
     "\"dc_enabled\":%s,"
     "\"dc_token\":\"%s\","
-    "\"dc_channel_id\":\"%s\","
     "\"dc_allow_count\":%u,"
     "\"dc_allow\":[",
+    (unsigned)g_cfg.tg_webhook_port, g_cfg.tg_webhook_secret,
     g_cfg.discord.enabled?"true":"false",
-    g_cfg.discord.token, g_cfg.discord_channel_id, g_cfg.discord.allow_count);
+    g_cfg.discord.token, g_cfg.discord.allow_count);
   for (uint8_t i=0; i<g_cfg.discord.allow_count; ++i) {
-    n += snprintf(buf+n, sizeof(buf)-n, "%s\"%s\"", i?",":"", g_cfg.discord.allow_from[i]);
+    n += snprintf(buf+n, CFG_JSON_S-n, "%s\"%s\"", i?",":"", g_cfg.discord.allow_from[i]);
+  }
+  // Channel table, one compact row each: [id, allow mask, session, cursor]
+  n += snprintf(buf+n, CFG_JSON_S-n, "],\"dc_ch\":[");
+  for (uint8_t i=0; i<g_cfg.dc_ch_count; ++i) {
+    const DcChannel &c = g_cfg.dc_ch[i];
+    n += snprintf(buf+n, CFG_JSON_S-n, "%s[\"%s\",%u,%u,\"%s\"]", i?",":"",
+                  c.id, (unsigned)c.allow, (unsigned)c.session, g_dc_cursor[i]);
   }
-  n += snprintf(buf+n, sizeof(buf)-n,
+  n += snprintf(buf+n, CFG_JSON_S-n,
     "],"
-    "\"tg_offset\":%lld,"
-    "\"dc_last_id\":\"%s\""
+    "\"tg_offset\":%lld"
     "}",
-    (long long)g_tg_offset, g_dc_last_msg_id);
+    (long long)g_tg_offset);
 
-  if (n < 0 || n >= (int)sizeof(buf)) {
+  if (n < 0 || n >= (int)CFG_JSON_S) {
     Serial.printf("[cfg_save] ERROR: JSON too large (%d bytes) — not saved\r\n", n);
     return;
   }
@@ -162,6 +209,25 @@ static void cfg_save() {
   LittleFS.end();
 }
 
+// Stored board config → g_cfg.board_md (cfg_load, and a failed board push
+// putting the old one back): a separate /control.md file. false when none.
+static bool board_md_load() {
+  g_cfg.board_md[0]     = '\0';
+  g_cfg.board_md_loaded = false;
+  LittleFS.begin();
+  if (LittleFS.exists("/control.md")) {
+    File bm = LittleFS.open("/control.md", "r");
+    if (bm) {
+      size_t bsz = bm.readBytes(g_cfg.board_md, sizeof(g_cfg.board_md) - 1);
+      g_cfg.board_md[bsz] = '\0';
+      bm.close();
+      g_cfg.board_md_loaded = true;
+    }
+  }
+  LittleFS.end();
+  return g_cfg.board_md_loaded;
+}
+
 static void cfg_load() {
   strlcpy(g_cfg.llm_provider, "openrouter", 32);
   strlcpy(g_cfg.llm_api_base, "https://openrouter.ai/api/v1", CFG_S);
@@ -179,8 +245,10 @@ static void cfg_load() {
   if (!LittleFS.exists("/femtoclaw.json")) { LittleFS.end(); return; }
   File f = LittleFS.open("/femtoclaw.json", "r");
   if (!f) { LittleFS.end(); return; }
-  static char jbuf[2048];
-  size_t sz = f.readBytes(jbuf, sizeof(jbuf)-1);
+  ArenaScope scope;
+  char *jbuf = arena_alloc(CFG_JSON_S);
+  if (!jbuf) { f.close(); LittleFS.end(); return; }
+  size_t sz = f.readBytes(jbuf, CFG_JSON_S - 1);
   f.close(); LittleFS.end();
   jbuf[sz] = '\0';
 
@@ -195,6 +263,8 @@ static void cfg_load() {
   if ((v=jfind(jbuf,"temperature")))    g_cfg.temperature    = (float)atof(v);
   if ((v=jfind(jbuf,"max_tool_iters"))) g_cfg.max_tool_iters = (uint8_t)jint(v);
   if ((v=jfind(jbuf,"heartbeat_ms")))   g_cfg.heartbeat_ms   = (uint32_t)jint(v);
+  if ((v=jfind(jbuf,"stream_replies"))) g_cfg.stream_replies = (*v=='t');
+  if ((v=jfind(jbuf,"api_host")))       jstr(v, g_cfg.api_host,         CFG_S);
   if ((v=jfind(jbuf,"tg_enabled")))     g_cfg.telegram.enabled = (*v=='t');
   if ((v=jfind(jbuf,"tg_token")))       jstr(v, g_cfg.telegram.token,   CFG_S);
   if ((v=jfind(jbuf,"tg_allow_count"))) g_cfg.telegram.allow_count = (uint8_t)jint(v);
@@ -209,9 +279,10 @@ static void cfg_load() {
     }
   }
 dc_section:
+  if ((v=jfind(jbuf,"tg_wh_port")))     g_cfg.tg_webhook_port = (uint16_t)jint(v);
+  if ((v=jfind(jbuf,"tg_wh_secret")))   jstr(v, g_cfg.tg_webhook_secret, sizeof(g_cfg.tg_webhook_secret));
   if ((v=jfind(jbuf,"dc_enabled")))     g_cfg.discord.enabled = (*v=='t');
   if ((v=jfind(jbuf,"dc_token")))       jstr(v, g_cfg.discord.token,    CFG_S);
-  if ((v=jfind(jbuf,"dc_channel_id")))  jstr(v, g_cfg.discord_channel_id, ALLOW_ID_LEN);
   if ((v=jfind(jbuf,"dc_allow_count"))) g_cfg.discord.allow_count = (uint8_t)jint(v);
   if ((v=jfind(jbuf,"dc_allow"))) {
     const char *p = strchr(v, '['); if (!p) goto cursors;
@@ -225,20 +296,33 @@ dc_section:
   }
 cursors:
   if ((v=jfind(jbuf,"tg_offset")))   g_tg_offset = jint(v);
-  if ((v=jfind(jbuf,"dc_last_id"))) jstr(v, g_dc_last_msg_id, sizeof(g_dc_last_msg_id));
-  // Board config : stored in a separate /control.md file.
-  // LittleFS was closed after reading femtoclaw.json above; re-open it here.
-  g_cfg.board_md_loaded = false;
-  LittleFS.begin();
-  if (LittleFS.exists("/control.md")) {
-    File bm = LittleFS.open("/control.md", "r");
-    if (bm) {
-      size_t bsz = bm.readBytes(g_cfg.board_md, sizeof(g_cfg.board_md) - 1);
-      g_cfg.board_md[bsz] = '\0';
-      bm.close();
-      g_cfg.board_md_loaded = true;
+  g_cfg.dc_ch_count = 0;
+  if ((v=jfind(jbuf,"dc_ch"))) {
+    const char *p = strchr(v, '[');
+    if (p && p[1] == ']') p = nullptr;             // empty table
+    while (p && g_cfg.dc_ch_count < DC_CHANNELS_MAX && (p = strchr(p + 1, '['))) {
+      uint8_t i = g_cfg.dc_ch_count;
+      DcChannel &c = g_cfg.dc_ch[i];
+      if (!jstr(p + 1, c.id, ALLOW_ID_LEN)) break;
+      const char *q = strchr(p + 2, '"');          // closing quote of the id
+      if (!q) break;
+      char *e;
+      c.allow   = (uint8_t)strtoul(q + 2, &e, 10);
+      c.session = (uint8_t)strtoul(e + 1, &e, 10);
+      jstr(e + 1, g_dc_cursor[i], ALLOW_ID_LEN);
+      if (c.id[0]) ++g_cfg.dc_ch_count;
+      p = strchr(e, ']');
+      if (!p || p[1] != ',') break;                // last row
+    }
+  } else if ((v=jfind(jbuf,"dc_channel_id"))) {
+    // Saved before the channel table: one channel id + one cursor.
+    jstr(v, g_cfg.dc_ch[0].id, ALLOW_ID_LEN);
+    if (g_cfg.dc_ch[0].id[0]) {
+      g_cfg.dc_ch_count = 1;
+      if ((v=jfind(jbuf,"dc_last_id"))) jstr(v, g_dc_cursor[0], ALLOW_ID_LEN);
     }
   }
-  LittleFS.end();
+  // LittleFS was closed after reading femtoclaw.json above.
+  board_md_load();
 }
 #endif
\ No newline at end of file
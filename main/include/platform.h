@@ -21,7 +21,11 @@
     #include <esp_psram.h>
   #endif
   #include <Preferences.h>
-  #define PLATFORM_NAME "ESP32"
+  #ifdef FC_NATIVE
+    #define PLATFORM_NAME "Native (Linux)"   // [env:native]: ESP32 API over native/ shims
+  #else
+    #define PLATFORM_NAME "ESP32"
+  #endif
   #define PERSIST_IMPL 1
   static Preferences prefs;
 #elif defined(BOARD_PICO_W)
@@ -33,6 +37,35 @@
   // namespace rp2040 { extern void reboot(); }
 #endif
 
+// ─── PSRAM placement ─────────────────────────────────────────────────────────
+// FC_PROFILE_PSRAM grows the big buffers (constants.h). When the SDK is
+// built to allow .bss in PSRAM they are placed there; otherwise they stay
+// in internal RAM, which an ESP32-S3 has enough of.
+#if defined(FC_PROFILE_PSRAM) && defined(BOARD_ESP32) && defined(CONFIG_SPIRAM_ALLOW_BSS_SEG_EXTERNAL_MEMORY)
+  #include <esp_attr.h>
+  #ifdef EXT_RAM_BSS_ATTR
+    #define FC_EXT_BSS EXT_RAM_BSS_ATTR
+  #else
+    #define FC_EXT_BSS EXT_RAM_ATTR         // ESP-IDF 4.x name
+  #endif
+#else
+  #define FC_EXT_BSS
+#endif
+
+// ─── Network core ────────────────────────────────────────────────────────────
+// FC_NET_CORE = 1 : HTTP/TLS jobs run on the second core (see http.h).
+// Single-core chips (ESP32-C3/C6, CONFIG_FREERTOS_UNICORE) run them inline
+// on the loop() core; -DFC_SINGLE_CORE forces that on dual-core parts too.
+#if defined(FC_SINGLE_CORE)
+  #define FC_NET_CORE 0
+#elif defined(BOARD_ESP32) && !defined(CONFIG_FREERTOS_UNICORE)
+  #define FC_NET_CORE 1
+#elif defined(BOARD_PICO_W)
+  #define FC_NET_CORE 1
+#else
+  #define FC_NET_CORE 0
+#endif
+
 // ─── LED pin ────────────────────────────────────────────────────────
 #ifndef LED_PIN
   #if defined(LED_BUILTIN)
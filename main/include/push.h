@@ -0,0 +1,216 @@
+/*
+ * ─────────────────────────────────────────────────────────────
+ * FemtoClaw : board push receiver.
+ *
+ * Two ways to get [CONTROL].md onto the board over the shell port:
+ *
+ * Text  (any terminal, older GUIs; the commands live in shell.h)
+ *   board push begin
+ *   board push chunk <base64_fragment>   (repeated)
+ *   board push end                       → PUSH OK <len> | PUSH ERR <why>
+ *
+ * Binary (the GUI): raw file bytes in COBS frames, acknowledged
+ *   board push bin <len> <crc32 hex>     → PUSH READY <window> <frame data>
+ *   then, until the last byte is in, the shell port carries frames:
+ *
+ *     0x00 │ COBS( type │ seq u16 │ data ≤ PUSH_FRAME_DATA │ crc32 u32 ) │ 0x00 │ ...
+ *
+ *   type 'D' data (frame seq holds file bytes seq * PUSH_FRAME_DATA ...)
+ *        'X' abort
+ *   crc32 covers type, seq and data; u16 / u32 are little-endian. The
+ *   leading 0x00 drops whatever followed the command line ('\n').
+ *
+ *   The host keeps up to <window> frames in flight (go-back-N). Replies
+ *   are text lines, so they interleave with the log; ACK / NAK go out
+ *   when the port goes quiet, at most one per quiet spell:
+ *     PUSH ACK <n>      frames 0 … n-1 are in
+ *     PUSH NAK <n>      frames 0 … n-1 are in, then a bad CRC or a gap :
+ *                       resend from frame n
+ *     PUSH OK <len>     whole-file CRC32 matched, config parsed and saved
+ *     PUSH ERR <why>    size / crc / rejected / abort / idle : push dropped
+ *
+ * A push line that arrives while the shell is held (a request or an agent
+ * turn, shell_byte) is not parked but answered at once with PUSH ERR busy,
+ * so the host neither falls back nor streams into a push that starts late.
+ *
+ * Both write the file straight into g_cfg.board_md as it arrives (text
+ * chunks go through the streaming base64 decoder, http.h), so nothing
+ * is staged and 'board push end' has nothing left to decode. The old
+ * text is gone from RAM meanwhile: g_push_active holds requests back
+ * until the push ends or goes PUSH_IDLE_MS without a chunk / frame, and
+ * a push that fails puts the stored config back (push_restore).
+ * board_push_apply() (shell.h) parses what arrived.
+ *
+ * Depends on: constants.h, board_parser.h, persist.h, http.h
+ * ─────────────────────────────────────────────────────────────
+ */
+
+#pragma once
+
+static uint16_t g_push_len    = 0;              // file bytes in g_cfg.board_md
+static uint32_t g_push_ms     = 0;              // last begin / chunk / frame
+static B64Dec   g_push_b64;                     // text push decoder state
+
+static bool board_push_apply(uint16_t mdlen);   // shell.h
+
+// A push starts: board_md is overwritten from here on.
+static void push_start() {
+    g_push_len            = 0;
+    g_cfg.board_md[0]     = '\0';
+    g_cfg.board_md_loaded = false;
+    g_push_active         = true;
+    g_push_ms             = millis();
+}
+
+// A push that did not make it: reload the stored config and its tables.
+static void push_restore() {
+    g_push_active = false;
+    g_push_len    = 0;
+    if (board_md_load()) {
+        board_parse_md(g_cfg.board_md);
+        Serial.println("[Board] Stored config restored.");
+    }
+}
+
+// ─── CRC-32 ───────────────────────────────────────────────────────────────────
+// IEEE 802.3 (zlib.crc32 on the host), a nibble at a time: 64 B of table.
+static const uint32_t k_crc32_nib[16] = {
+    0x00000000u, 0x1DB71064u, 0x3B6E20C8u, 0x26D930ACu,
+    0x76DC4190u, 0x6B6B51F4u, 0x4DB26158u, 0x5005713Cu,
+    0xEDB88320u, 0xF00F9344u, 0xD6D6A3E8u, 0xCB61B38Cu,
+    0x9B64C2B0u, 0x86D3D2D4u, 0xA00AE278u, 0xBDBDF21Cu
+};
+
+static uint32_t crc32_update(uint32_t crc, const uint8_t *p, uint16_t n) {
+    crc = ~crc;
+    while (n--) {
+        crc ^= *p++;
+        crc = (crc >> 4) ^ k_crc32_nib[crc & 0x0F];
+        crc = (crc >> 4) ^ k_crc32_nib[crc & 0x0F];
+    }
+    return ~crc;
+}
+
+// ─── Binary receiver ──────────────────────────────────────────────────────────
+static constexpr uint8_t  PUSH_HDR_S   = 3;                 // type, seq
+static constexpr uint16_t PUSH_FRAME_S = PUSH_HDR_S + PUSH_FRAME_DATA + 4;
+
+struct PushBin {
+    bool     on;
+    uint16_t len;             // file size announced by 'board push bin'
+    uint32_t crc;             // its CRC-32
+    uint16_t next;            // next frame expected
+    uint16_t acked;           // last PUSH ACK / NAK sent
+    bool     reack;           // a duplicate came in: the host missed an ACK
+    bool     gap;             // bad or out-of-order frame since the last NAK
+    // COBS decoder
+    uint8_t  frame[PUSH_FRAME_S];
+    uint16_t flen;
+    uint8_t  code;            // code byte of the current block, 0 = none yet
+    uint8_t  left;            // bytes left in the block
+    bool     overrun;         // frame longer than PUSH_FRAME_S : drop it
+    // metrics
+    uint16_t frames, bad, dups;
+};
+
+static PushBin g_pushb = {};
+
+static void _push_bin_end(const char *err) {
+    PushBin &b = g_pushb;
+    b.on          = false;
+    g_push_active = false;
+    if (err) {
+        push_restore();
+        Serial.printf("PUSH ERR %s\r\n", err);
+        Serial.printf("[Board] Binary push failed (%s) : %u frames, %u bad, %u resent\r\n",
+                      err, (unsigned)b.frames, (unsigned)b.bad, (unsigned)b.dups);
+    }
+}
+
+// 'board push bin <len> <crc32 hex>'
+static void push_bin_begin(const char *args) {
+    char *end;
+    unsigned long len = strtoul(args, &end, 10);
+    unsigned long crc = strtoul(end, nullptr, 16);
+    if (!len || len >= BOARD_MD_S) {
+        Serial.printf("PUSH ERR size\r\n[Board] ERROR: push of %lu bytes, 1-%u fit.\r\n",
+                      len, (unsigned)(BOARD_MD_S - 1));
+        return;
+    }
+    PushBin &b = g_pushb;
+    memset(static_cast<void *>(&b), 0, sizeof(b));
+    b.on  = true;
+    b.len = (uint16_t)len;
+    b.crc = (uint32_t)crc;
+    push_start();
+    Serial.printf("PUSH READY %u %u\r\n", (unsigned)PUSH_WINDOW, (unsigned)PUSH_FRAME_DATA);
+}
+
+// One decoded frame.
+static void _push_bin_frame() {
+    PushBin &b = g_pushb;
+    if (b.flen < PUSH_HDR_S + 4) return;            // runt ('\n' after the command)
+    uint16_t n = b.flen - 4;
+    uint32_t want;
+    memcpy(&want, b.frame + n, 4);
+    if (crc32_update(0, b.frame, n) != want) { ++b.bad; b.gap = true; return; }
+    if (b.frame[0] == 'X') return _push_bin_end("abort");
+    if (b.frame[0] != 'D') return;
+
+    uint16_t seq = (uint16_t)(b.frame[1] | (b.frame[2] << 8));
+    if (seq < b.next) { ++b.dups; b.reack = true; return; }
+    if (seq > b.next) { b.gap = true; return; }     // one went missing
+    uint16_t dlen = n - PUSH_HDR_S;
+    uint32_t at   = (uint32_t)seq * PUSH_FRAME_DATA;
+    if (at != g_push_len || at + dlen > b.len) return _push_bin_end("size");
+    memcpy(g_cfg.board_md + at, b.frame + PUSH_HDR_S, dlen);  // b.len < BOARD_MD_S
+    g_push_len += dlen;
+    g_cfg.board_md[g_push_len] = '\0';
+    ++b.next;
+    ++b.frames;
+    b.gap      = false;
+    g_push_ms  = millis();
+    if (g_push_len < b.len) return;
+
+    // Last byte in: whole-file check before anything is parsed.
+    if (crc32_update(0, (const uint8_t *)g_cfg.board_md, g_push_len) != b.crc)
+        return _push_bin_end("crc");
+    _push_bin_end(nullptr);
+    if (!board_push_apply(g_push_len)) { Serial.print("PUSH ERR rejected\r\n"); return; }
+    Serial.printf("PUSH OK %u\r\n", (unsigned)g_push_len);
+}
+
+// Shell port byte while a binary push is on (shell_byte).
+static void push_bin_byte(uint8_t c) {
+    PushBin &b = g_pushb;
+    if (c == 0) {                                    // delimiter
+        if (!b.overrun) _push_bin_frame();
+        b.flen = 0; b.code = 0; b.left = 0; b.overrun = false;
+        return;
+    }
+    if (b.left) {
+        if (b.flen < PUSH_FRAME_S) b.frame[b.flen++] = c;
+        else                       b.overrun = true;
+        --b.left;
+        return;
+    }
+    // Code byte: the block before it ends in an implied zero unless it was full.
+    if (b.code && b.code != 0xFF) {
+        if (b.flen < PUSH_FRAME_S) b.frame[b.flen++] = 0;
+        else                       b.overrun = true;
+    }
+    b.code = c;
+    b.left = c - 1;
+}
+
+// Shell port drained: acknowledge what came in, give up on a silent host.
+static void push_bin_idle() {
+    PushBin &b = g_pushb;
+    if (!b.on) return;
+    if (millis() - g_push_ms >= PUSH_IDLE_MS) return _push_bin_end("idle");
+    if (b.gap)                              Serial.printf("PUSH NAK %u\r\n", (unsigned)b.next);
+    else if (b.next != b.acked || b.reack)  Serial.printf("PUSH ACK %u\r\n", (unsigned)b.next);
+    else return;
+    b.acked = b.next;
+    b.reack = b.gap = false;
+}
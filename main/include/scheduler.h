@@ -0,0 +1,150 @@
+/*
+ * ─────────────────────────────────────────────────────────────
+ * FemtoClaw : cooperative task scheduler.
+ *
+ * loop() is a single sched_run() pass. Every periodic job is a task with
+ * a period (next deadline = last start + period) and a priority. A pass
+ * runs every due task, PRIO_HIGH first, and inside one priority the most
+ * overdue task first.
+ *
+ * Two kinds of task:
+ *   io  — short, never block (shell, UART rings, servo motion, USB
+ *         keepalive, the net-core stepper, and the webhook listener and
+ *         Gateway socket, which only take what has already arrived)
+ *   net — issue HTTP(S) requests (Telegram, Discord, agent, outbox,
+ *         heartbeat). Skipped while WiFi is down, a blocking request is
+ *         already in flight or a board push holds the shared arena (http.h).
+ * A net task runs a request either with net_call(), which waits for the
+ * job (on the net core, or stepped inline) and calls sched_yield_io() on
+ * every pass of the wait, or with net_submit(), checking net_job_done()
+ * on a later run. Either way io tasks keep running for the whole
+ * transaction. A task never re-enters itself, and the shell only parks
+ * command lines while an agent turn is running (agent.h g_agent_turn).
+ *
+ * Per-task run time and start lateness are printed by 'status'.
+ *
+ * Depends on: http.h (net_busy), mcu_wifi.h
+ * ─────────────────────────────────────────────────────────────
+ */
+
+#pragma once
+
+// femtoclaw_mcu.cpp registers 13; the rest is headroom for new tasks.
+#ifndef SCHED_MAX_TASKS
+  #define SCHED_MAX_TASKS  16
+#endif
+
+enum : uint8_t { PRIO_HIGH = 0, PRIO_NORMAL = 1, PRIO_LOW = 2 };
+
+struct SchedTask {
+    const char *name;
+    void      (*fn)();
+    uint32_t    period_ms;     // 0 = every pass
+    uint32_t    due_ms;
+    uint8_t     prio;
+    bool        net;
+    bool        running;       // on the call stack right now
+    uint32_t    runs;
+    uint32_t    last_us;
+    uint32_t    max_us;
+    uint64_t    total_us;
+    uint32_t    late_max_ms;   // worst start delay past the deadline
+};
+
+static SchedTask g_tasks[SCHED_MAX_TASKS];
+static uint8_t   g_task_count = 0;
+static uint8_t   g_task_lost  = 0;     // sched_add() calls refused, shown by 'status'
+
+// Returns the task id, or -1 when the table is full. A refused task is a
+// build mistake: the native build stops on it, the boards say so at boot
+// and in every 'status'.
+static int sched_add(const char *name, void (*fn)(), uint32_t period_ms,
+                     uint8_t prio, bool net) {
+    if (g_task_count >= SCHED_MAX_TASKS) {
+        Serial.printf("[sched] ERROR: task '%s' exceeds SCHED_MAX_TASKS=%u : not scheduled\r\n",
+                      name, SCHED_MAX_TASKS);
+        ++g_task_lost;
+#ifdef FC_NATIVE
+        abort();
+#endif
+        return -1;
+    }
+    SchedTask &t = g_tasks[g_task_count];
+    memset(&t, 0, sizeof(t));
+    t.name      = name;
+    t.fn        = fn;
+    t.period_ms = period_ms;
+    t.prio      = prio;
+    t.net       = net;
+    t.due_ms    = millis();
+    return g_task_count++;
+}
+
+static void _sched_exec(SchedTask &t, uint32_t now) {
+    int32_t late = (int32_t)(now - t.due_ms);
+    if (t.period_ms && late > 0 && (uint32_t)late > t.late_max_ms) t.late_max_ms = (uint32_t)late;
+
+    t.running = true;
+    uint32_t t0 = micros();
+    t.fn();
+    uint32_t us = micros() - t0;
+    t.running = false;
+
+    ++t.runs;
+    t.last_us   = us;
+    t.total_us += us;
+    if (us > t.max_us) t.max_us = us;
+    t.due_ms = now + t.period_ms;
+}
+
+// One pass over the table. io_only skips net tasks (used from inside a request).
+static void _sched_pass(bool io_only) {
+    for (uint8_t prio = PRIO_HIGH; prio <= PRIO_LOW; ++prio) {
+        uint8_t order[SCHED_MAX_TASKS];
+        uint8_t n = 0;
+        uint32_t now = millis();
+        for (uint8_t i = 0; i < g_task_count; ++i) {
+            const SchedTask &t = g_tasks[i];
+            if (t.prio != prio || t.running) continue;
+            if (t.net && io_only) continue;
+            if ((int32_t)(now - t.due_ms) < 0) continue;
+            // Insertion sort: most overdue first.
+            uint8_t k = n++;
+            while (k > 0 && (int32_t)(g_tasks[order[k - 1]].due_ms - t.due_ms) > 0) {
+                order[k] = order[k - 1];
+                --k;
+            }
+            order[k] = i;
+        }
+        for (uint8_t k = 0; k < n; ++k) {
+            SchedTask &t = g_tasks[order[k]];
+            if (t.net && (net_busy() || g_push_active || WiFi.status() != WL_CONNECTED)) continue;
+            _sched_exec(t, millis());
+        }
+    }
+}
+
+static void sched_run() { _sched_pass(false); }
+
+// Called between HTTP steps and from long actions (delay_ms).
+static void sched_yield_io() {
+    static bool s_in_yield = false;
+    if (s_in_yield) return;
+    s_in_yield = true;
+    _sched_pass(true);
+    s_in_yield = false;
+}
+
+static void sched_print_stats() {
+    if (g_task_lost)
+        Serial.printf("  Tasks     : ERROR %u task(s) not scheduled, raise SCHED_MAX_TASKS\r\n",
+                      (unsigned)g_task_lost);
+    Serial.print("  Tasks     : name        runs      avg_us    max_us    late_max_ms\r\n");
+    for (uint8_t i = 0; i < g_task_count; ++i) {
+        const SchedTask &t = g_tasks[i];
+        Serial.printf("              %-10s  %-8lu  %-8lu  %-8lu  %lu\r\n",
+                      t.name, (unsigned long)t.runs,
+                      (unsigned long)(t.runs ? t.total_us / t.runs : 0),
+                      (unsigned long)t.max_us, (unsigned long)t.late_max_ms);
+    }
+}
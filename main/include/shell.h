@@ -9,25 +9,51 @@
 
 #pragma once
 
-// ─── Board push state machine ─────────────────────────────────────────────────
-/*
- * The GUI sends [CONTROL].md base64-encoded in chunks:
- *   board push begin
- *   board push chunk <base64_fragment>   (repeated)
- *   board push end
- */
-static char     g_push_buf[6144];
-static uint16_t g_push_len   = 0;
-static bool     g_push_active = false;
-
 // ─── Shell state ──────────────────────────────────────────────────────────────
 static char     g_cmd[CMD_S];
 static uint16_t g_cmd_len = 0;
+static char     g_cmd_pending[CMD_S];      // line entered while a request was in flight
+static bool     g_cmd_has_pending = false;
 
 static void shell_prompt() {
     Serial.print("\r\n\033[1;32mfemtoclaw>\033[0m ");
 }
 
+// ─── Board push apply ─────────────────────────────────────────────────────────
+// A finished push (text or binary, push.h) sits in g_cfg.board_md: take it
+// as the board config if it parses. Rejected configs bring the stored one
+// back and leave the running hardware alone; an accepted one first releases
+// what the old config set up (snapshot taken before the parse overwrites
+// the tables), so no UART keeps a callback into a reused slot.
+static bool board_push_apply(uint16_t mdlen) {
+    BoardHwSnap old;
+    board_hw_snapshot(old);
+    if (mdlen >= sizeof(g_cfg.board_md)) {
+        Serial.printf("[Board] ERROR: %u bytes > %u --> config rejected.\r\n",
+                      (unsigned)mdlen, (unsigned)(sizeof(g_cfg.board_md) - 1));
+        push_restore();
+        return false;
+    }
+    g_cfg.board_md[mdlen] = '\0';
+    if (!board_parse_md(g_cfg.board_md)) {
+        Serial.println("[Board] ERROR: config rejected (no entries, duplicate names or pin conflicts).");
+        push_restore();
+        return false;
+    }
+    g_cfg.board_md_loaded = true;
+    board_release_peripherals(old);
+    board_release_hardware(old);
+    board_init_hardware();
+    board_init_peripherals();
+    cfg_save();
+    Serial.printf("[Board] Config accepted : "
+                  "%u GPIO, %u UART, %u ADC, %u I2C, %u SPI, %u Servo, %u PWM\r\n",
+                  g_board_pin_count, g_board_serial_count, g_board_adc_count,
+                  g_board_i2c_count,  g_board_spi_count,
+                  g_board_servo_count, g_board_pwm_count);
+    return true;
+}
+
 // ─── shell_run ────────────────────────────────────────────────────────────────
 static void shell_run(const char *line) {
 
@@ -37,6 +63,8 @@ static void shell_run(const char *line) {
             "\r\n┌─ FemtoClaw MCU Shell ─────────────────────────────────────────┐\r\n"
             "│  help / ?                     — this message                       │\r\n"
             "│  status                       — WiFi, channels, uptime            │\r\n"
+            "│  stats [json|reset]           — latency histograms per stage      │\r\n"
+            "│  mem                          — heap, stack and buffer usage      │\r\n"
             "│  wifi <ssid> <pw>             — save WiFi credentials             │\r\n"
             "│  connect                      — (re)connect WiFi                  │\r\n"
             "│  set <key> <value>            — update any config key             │\r\n"
@@ -46,8 +74,13 @@ static void shell_run(const char *line) {
             "│  tg allow list                — show Telegram allow list          │\r\n"
             "│  tg allow clear               — clear Telegram allow list         │\r\n"
             "│  tg enable / tg disable       — toggle Telegram channel           │\r\n"
+            "│  tg webhook <port> <url> [s]  — receive via webhook (setWebhook)  │\r\n"
+            "│  tg webhook off               — back to long polling              │\r\n"
             "│  dc token <TOKEN>             — set Discord bot token             │\r\n"
-            "│  dc channel <CHANNEL_ID>      — set Discord channel               │\r\n"
+            "│  dc channel <CHANNEL_ID>      — add channel (none = all channels) │\r\n"
+            "│  dc channel list / rm <ID>    — show / remove channels            │\r\n"
+            "│  dc channel <ID> session <n>  — bind channel to history slot n    │\r\n"
+            "│  dc channel <ID> allow <uid>  — limit channel to users (or 'all') │\r\n"
             "│  dc allow <user_id>           — add allowed Discord user          │\r\n"
             "│  dc enable / dc disable       — toggle Discord channel            │\r\n"
             "│  diag                         — LLM host/path/heap diagnostics    │\r\n"
@@ -56,27 +89,29 @@ static void shell_run(const char *line) {
             "│  reboot                       — restart MCU                       │\r\n"
             "├─ Board & Hardware ────────────────────────────────────────────────┤\r\n"
             "│  board push begin/chunk/end   — push [CONTROL].md (base64 chunks)  │\r\n"
+            "│  board push bin <len> <crc>   — framed binary push (GUI, CRC32)    │\r\n"
             "│  board show                   — print stored board config          │\r\n"
-            "│  board reset                  — clear config, set all outputs LOW  │\r\n"
+            "│  board reset                  — clear config, set all outputs OFF  │\r\n"
             "│  gpio get <pin>               — read GPIO (0 or 1)                 │\r\n"
             "│  gpio set <pin> <0|1>         — set GPIO output                    │\r\n"
             "│  gpio mode <pin> <mode>       — change pin mode                    │\r\n"
             "│  adc read <pin>               — read ADC (0-4095)                  │\r\n"
             "│  serial write <n> <data>      — write to named serial port         │\r\n"
-            "│  serial read <n>              — read from named serial port        │\r\n"
+            "│  serial read <n>              — next buffered line from port       │\r\n"
             "│  servo set <name> <angle>     — set servo angle                    │\r\n"
             "│  pwm set <name> <duty>        — set PWM duty (0-255)               │\r\n"
+            "│  i2c scan                     — rescan I2C buses, refresh cache    │\r\n"
             "└────────────────────────────────────────────────────────────────────┘\r\n");
 
     // ── Status ─────────────────────────────────────────────────────────
     } else if (!strcmp(line,"status")) {
         Serial.printf(
-            "\r\n  Board     : " PLATFORM_NAME "\r\n"
+            "\r\n  Board     : " PLATFORM_NAME "  (memory profile " FC_PROFILE_NAME ")\r\n"
             "  WiFi      : %s / %s\r\n"
             "  IP        : %s  RSSI %d dBm\r\n"
             "  Provider  : %s  Model : %s\r\n"
             "  Telegram  : %s  (token: %s  allow: %u)\r\n"
-            "  Discord   : %s  (channel: %s  allow: %u)\r\n"
+            "  Discord   : %s  (channels: %u%s  allow: %u)\r\n"
             "  TG offset : %lld\r\n"
             "  GPIO/UART/ADC/I2C/SPI/Servo/PWM: %u/%u/%u/%u/%u/%u/%u\r\n"
             "  Uptime    : %lu ms\r\n",
@@ -89,13 +124,35 @@ static void shell_run(const char *line) {
             g_cfg.telegram.token[0] ? "set" : "(none)",
             (unsigned)g_cfg.telegram.allow_count,
             g_cfg.discord.enabled ? "ENABLED" : "disabled",
-            g_cfg.discord_channel_id[0] ? g_cfg.discord_channel_id : "(none)",
+            (unsigned)g_cfg.dc_ch_count, g_cfg.dc_ch_count ? "" : " = all",
             (unsigned)g_cfg.discord.allow_count,
             (long long)g_tg_offset,
             g_board_pin_count, g_board_serial_count, g_board_adc_count,
             g_board_i2c_count, g_board_spi_count,
             g_board_servo_count, g_board_pwm_count,
             millis());
+        sched_print_stats();
+        net_print_stats();
+        msgq_print_stats();
+        live_print_stats();
+        if (webhook_on() || g_wh.requests) webhook_print_stats();
+        if (!webhook_on()) tg_print_stats();
+        dcg_print_stats();
+        dc_print_stats();
+
+    // ── Heap / stack / buffer usage (mem.h) ────────────────────────────
+    } else if (!strcmp(line,"mem")) {
+        mem_print();
+        tls_print();
+
+    // ── Latency histograms (hist.h) ────────────────────────────────────
+    } else if (!strcmp(line,"stats")) {
+        hist_print();
+    } else if (!strcmp(line,"stats json")) {
+        hist_print_json();
+    } else if (!strcmp(line,"stats reset")) {
+        hist_reset();
+        Serial.println("Latency histograms cleared.");
 
     // ── WiFi ───────────────────────────────────────────────────────────
     } else if (!strncmp(line,"wifi ",5)) {
@@ -115,8 +172,16 @@ static void shell_run(const char *line) {
         char *rest=(char*)line+4, *sp=strchr(rest,' ');
         if (!sp) { Serial.println("Usage: set <key> <value>"); return; }
         *sp='\0';
-        static char args[LLM_KEY+64];
-        snprintf(args, sizeof(args), "{\"key\":\"%s\",\"value\":\"%s\"}", rest, sp+1);
+        if (!strcmp(rest,"api_host")) {     // test hook: shell only, not the agent's set_config
+            strlcpy(g_cfg.api_host, strcmp(sp+1,"off") ? sp+1 : "", CFG_S);
+            cfg_save();
+            Serial.println("set api_host ok");
+            return;
+        }
+        ArenaScope scope;
+        char *args = arena_alloc(LLM_KEY + 64);
+        if (!args) return;
+        snprintf(args, LLM_KEY + 64, "{\"key\":\"%s\",\"value\":\"%s\"}", rest, sp+1);
         tool_dispatch("set_config", args);
         Serial.println(g_tool_result);
 
@@ -130,21 +195,27 @@ static void shell_run(const char *line) {
             "  temperature  : %.2f\r\n"
             "  max_iters    : %u\r\n"
             "  heartbeat_ms : %lu\r\n"
+            "  stream_repl  : %s\r\n"
+            "  api_host     : %s\r\n"
             "  tg_enabled   : %s\r\n"
             "  tg_token     : %s\r\n"
             "  tg_allow_cnt : %u\r\n"
+            "  tg_webhook   : %s%u\r\n"
             "  dc_enabled   : %s\r\n"
-            "  dc_channel   : %s\r\n"
+            "  dc_channels  : %u%s\r\n"
             "  dc_allow_cnt : %u\r\n",
             g_cfg.wifi_ssid, g_cfg.llm_provider,
             g_cfg.llm_api_base, g_cfg.llm_model,
             g_cfg.max_tokens, (double)g_cfg.temperature,
             g_cfg.max_tool_iters, (unsigned long)g_cfg.heartbeat_ms,
+            g_cfg.stream_replies ? "on (placeholder + edits)" : "off",
+            g_cfg.api_host[0] ? g_cfg.api_host : "(real APIs)",
             g_cfg.telegram.enabled?"yes":"no",
             g_cfg.telegram.token[0] ? "[set]" : "(none)",
             (unsigned)g_cfg.telegram.allow_count,
+            g_cfg.tg_webhook_port ? "port " : "off (long polling) ", (unsigned)g_cfg.tg_webhook_port,
             g_cfg.discord.enabled?"yes":"no",
-            g_cfg.discord_channel_id[0] ? g_cfg.discord_channel_id : "(none)",
+            (unsigned)g_cfg.dc_ch_count, g_cfg.dc_ch_count ? "" : " (all channels)",
             (unsigned)g_cfg.discord.allow_count);
 
     // ── Telegram sub-commands ──────────────────────────────────────────
@@ -176,14 +247,89 @@ static void shell_run(const char *line) {
         }
     } else if (!strcmp(line,"tg enable"))  { g_cfg.telegram.enabled=true;  cfg_save(); Serial.println("Telegram enabled.");
     } else if (!strcmp(line,"tg disable")) { g_cfg.telegram.enabled=false; cfg_save(); Serial.println("Telegram disabled.");
+    } else if (!strcmp(line,"tg webhook off")) {
+        if (WiFi.status() != WL_CONNECTED) { Serial.println("[!] Not connected."); return; }
+        if (net_busy() || g_push_active) { Serial.println("[!] Network busy."); return; }
+        tg_delete_webhook();
+        g_cfg.tg_webhook_port = 0;
+        cfg_save(); Serial.println("Webhook off : long polling.");
+    } else if (!strncmp(line,"tg webhook ",11)) {
+        // tg webhook <port> <public_url> [secret]
+        ArenaScope scope;
+        char *args = arena_alloc(CFG_S + 80);
+        if (!args) return;
+        strlcpy(args, line+11, CFG_S + 80);
+        char *url = strchr(args,' ');
+        if (!url) { Serial.println("Usage: tg webhook <port> <public_url> [secret] | tg webhook off"); return; }
+        *url++ = '\0';
+        char *secret = strchr(url,' ');
+        if (secret) *secret++ = '\0';
+        long port = atol(args);
+        if (port <= 0 || port > 65535) { Serial.println("[!] Bad port."); return; }
+        if (secret && strlen(secret) >= sizeof(g_cfg.tg_webhook_secret)) {
+            Serial.printf("[!] Secret too long (max %u chars)\r\n",
+                          (unsigned)(sizeof(g_cfg.tg_webhook_secret) - 1));
+            return;
+        }
+        if (WiFi.status() != WL_CONNECTED) { Serial.println("[!] Not connected."); return; }
+        if (net_busy() || g_push_active) { Serial.println("[!] Network busy."); return; }
+        strlcpy(g_cfg.tg_webhook_secret, secret ? secret : "", sizeof(g_cfg.tg_webhook_secret));
+        int16_t code = tg_set_webhook(url, g_cfg.tg_webhook_secret);
+        if (code != 200) { Serial.println("[!] setWebhook failed : still polling."); return; }
+        g_cfg.tg_webhook_port = (uint16_t)port;
+        cfg_save(); Serial.printf("Webhook on : listening on port %ld.\r\n", port);
 
     // ── Discord sub-commands ───────────────────────────────────────────
     } else if (!strncmp(line,"dc token ",9)) {
         strlcpy(g_cfg.discord.token, line+9, CFG_S);
         cfg_save(); Serial.println("Discord token saved.");
+    } else if (!strcmp(line,"dc channel list")) {
+        if (!g_cfg.dc_ch_count) Serial.println("No channels : answering in every channel and DM.");
+        for (uint8_t i = 0; i < g_cfg.dc_ch_count; ++i) {
+            const DcChannel &c = g_cfg.dc_ch[i];
+            Serial.printf("  [%u] %s  session %u  allow ", i, c.id, (unsigned)c.session);
+            if (!c.allow) Serial.print("all");
+            for (uint8_t k = 0; k < g_cfg.discord.allow_count; ++k)
+                if (c.allow & (1u << k)) Serial.printf("%s ", g_cfg.discord.allow_from[k]);
+            Serial.printf("  cursor %s\r\n", g_dc_cursor[i][0] ? g_dc_cursor[i] : "-");
+        }
+    } else if (!strncmp(line,"dc channel rm ",14)) {
+        if (dc_chan_remove(line+14)) { cfg_save(); Serial.printf("Removed Discord channel %s\r\n", line+14); }
+        else Serial.println("[!] No such channel.");
     } else if (!strncmp(line,"dc channel ",11)) {
-        strlcpy(g_cfg.discord_channel_id, line+11, ALLOW_ID_LEN);
-        cfg_save(); Serial.printf("Discord channel: %s\r\n", g_cfg.discord_channel_id);
+        // dc channel <id> [session <n> | allow <user_id|all>]
+        ArenaScope scope;
+        char *args = arena_alloc(ALLOW_ID_LEN + 48);
+        if (!args) return;
+        strlcpy(args, line+11, ALLOW_ID_LEN + 48);
+        char *sub = strchr(args,' ');
+        if (sub) *sub++ = '\0';
+        if (strlen(args) >= ALLOW_ID_LEN) { Serial.println("[!] Channel ID too long."); return; }
+        int8_t row = sub ? dc_chan_find(args) : dc_chan_add(args);
+        if (row < 0) {
+            Serial.println(sub ? "[!] Add the channel first." : "[!] Channel table full.");
+            return;
+        }
+        DcChannel &c = g_cfg.dc_ch[row];
+        if (!sub) {
+            Serial.printf("Discord channel [%u] %s\r\n", (unsigned)row, c.id);
+        } else if (!strncmp(sub,"session ",8)) {
+            c.session = (uint8_t)atoi(sub+8);
+            Serial.printf("Channel %s → history slot %u\r\n", c.id, (unsigned)c.session);
+        } else if (!strcmp(sub,"allow all")) {
+            c.allow = 0;
+            Serial.printf("Channel %s : whole allow list\r\n", c.id);
+        } else if (!strncmp(sub,"allow ",6)) {
+            uint8_t k = 0;
+            while (k < g_cfg.discord.allow_count && strcmp(g_cfg.discord.allow_from[k], sub+6)) ++k;
+            if (k == g_cfg.discord.allow_count) { Serial.println("[!] Add the user with 'dc allow' first."); return; }
+            c.allow |= (uint8_t)(1u << k);
+            Serial.printf("Channel %s : allows %s\r\n", c.id, sub+6);
+        } else {
+            Serial.println("Usage: dc channel <id> [session <n> | allow <user_id|all>]");
+            return;
+        }
+        cfg_save();
     } else if (!strncmp(line,"dc allow ",9)) {
         const char *id_str = line + 9;
         if (g_cfg.discord.allow_count >= ALLOW_LIST_MAX)
@@ -200,7 +346,9 @@ static void shell_run(const char *line) {
 
     // ── Diagnostics ────────────────────────────────────────────────────
     } else if (!strcmp(line,"diag")) {
-        static char dhost[CFG_S];
+        ArenaScope scope;
+        char *dhost = arena_alloc(CFG_S);
+        if (!dhost) return;
         const char *hs = strstr(g_cfg.llm_api_base, "://");
         hs = hs ? hs+3 : g_cfg.llm_api_base;
         const char *ps = strchr(hs, '/');
@@ -213,25 +361,19 @@ static void shell_run(const char *line) {
                       "  path     : %s/chat/completions\r\n"
                       "  scheme   : %s\r\n"
                       "  wifi     : %s\r\n"
-#ifdef BOARD_ESP32
                       "  free_heap: %lu bytes\r\n",
-#else
-                      "  free_heap: n/a (Pico W)\r\n",
-#endif
             g_cfg.llm_api_base, dhost,
             ps ? ps : "/",
             is_http ? "HTTP (plain)" : "HTTPS (TLS)",
-            WiFi.status()==WL_CONNECTED ? WiFi.localIP().toString().c_str() : "disconnected"
-#ifdef BOARD_ESP32
-            , (unsigned long)ESP.getFreeHeap()
-#endif
-        );
+            WiFi.status()==WL_CONNECTED ? WiFi.localIP().toString().c_str() : "disconnected",
+            (unsigned long)mem_sample());
 
     // ── Chat ───────────────────────────────────────────────────────────
     } else if (!strncmp(line,"chat ",5)) {
         if (WiFi.status() != WL_CONNECTED) { Serial.println("[!] Not connected."); return; }
-        if (g_http_busy) { Serial.println("[!] Network busy."); return; }
+        if (net_busy() || g_push_active) { Serial.println("[!] Network busy."); return; }
         Serial.println("[LLM] Thinking...");
+        session_bind(0);
         const char *r = agent_run(line+5);
         Serial.printf("\r\n[femtoclaw] %s\r\n", r);
 
@@ -246,57 +388,45 @@ static void shell_run(const char *line) {
         rp2040.reboot();
 #endif
 
-    // ── Board push ─────────────────────────────────────────────────────
+    // ── Board push (push.h) ────────────────────────────────────────────
+    } else if (!strncmp(line, "board push bin ", 15)) {
+        if (g_push_active) Serial.println("PUSH ERR busy\r\n[Board] ERROR: a push is already in progress.");
+        else               push_bin_begin(line + 15);
+
     } else if (!strcmp(line, "board push begin")) {
-        g_push_len    = 0;
-        g_push_buf[0] = '\0';
-        g_push_active = true;
+        push_start();
+        base64_dec_init(g_push_b64);
         Serial.println("[Board] Push started : send 'board push chunk <b64>' then 'board push end'.");
 
     } else if (!strncmp(line, "board push chunk ", 17)) {
         if (!g_push_active) {
-            Serial.println("[Board] ERROR: send 'board push begin' first.");
+            Serial.println("PUSH ERR nopush\r\n[Board] ERROR: send 'board push begin' first.");
         } else {
             const char *chunk = line + 17;
-            uint16_t clen = (uint16_t)strlen(chunk);
-            if (g_push_len + clen + 1 < sizeof(g_push_buf)) {
-                memcpy(g_push_buf + g_push_len, chunk, clen);
-                g_push_len += clen;
-                g_push_buf[g_push_len] = '\0';
-            } else {
-                Serial.println("[Board] ERROR: push buffer full --> aborting.");
-                g_push_active = false;
-                g_push_len    = 0;
+            g_push_ms   = millis();
+            g_push_len += base64_decode_feed(g_push_b64, chunk, (uint16_t)strlen(chunk),
+                                             g_cfg.board_md + g_push_len,
+                                             (uint16_t)(sizeof(g_cfg.board_md) - 1 - g_push_len));
+            g_cfg.board_md[g_push_len] = '\0';
+            if (g_push_b64.full) {
+                Serial.printf("PUSH ERR size\r\n[Board] ERROR: config larger than %u bytes --> aborting.\r\n",
+                              (unsigned)(sizeof(g_cfg.board_md) - 1));
+                push_restore();
             }
         }
 
     } else if (!strcmp(line, "board push end")) {
         if (!g_push_active) {
-            Serial.println("[Board] ERROR: no push in progress.");
+            Serial.println("PUSH ERR nopush\r\n[Board] ERROR: no push in progress.");
         } else {
             g_push_active = false;
-            uint16_t mdlen = base64_decode(g_push_buf, g_push_len,
-                                           g_cfg.board_md, sizeof(g_cfg.board_md) - 1);
-            if (mdlen == 0) {
-                Serial.println("[Board] ERROR: base64 decode empty --> config rejected.");
+            if (g_push_len == 0) {
+                Serial.println("PUSH ERR empty\r\n[Board] ERROR: base64 decode empty --> config rejected.");
+                push_restore();
+            } else if (board_push_apply(g_push_len)) {
+                Serial.printf("PUSH OK %u\r\n", (unsigned)g_push_len);
             } else {
-                g_cfg.board_md[mdlen] = '\0';
-                bool ok = board_parse_md(g_cfg.board_md);
-                if (!ok) {
-                    Serial.println("[Board] ERROR: no entries found --> config rejected.");
-                    g_cfg.board_md[0]     = '\0';
-                    g_cfg.board_md_loaded = false;
-                } else {
-                    g_cfg.board_md_loaded = true;
-                    board_init_hardware();
-                    board_init_peripherals();
-                    cfg_save();
-                    Serial.printf("[Board] Config accepted : "
-                                  "%u GPIO, %u UART, %u ADC, %u I2C, %u SPI, %u Servo, %u PWM\r\n",
-                                  g_board_pin_count, g_board_serial_count, g_board_adc_count,
-                                  g_board_i2c_count,  g_board_spi_count,
-                                  g_board_servo_count, g_board_pwm_count);
-                }
+                Serial.println("PUSH ERR rejected");
             }
         }
 
@@ -313,10 +443,11 @@ static void shell_run(const char *line) {
 
             Serial.printf("[Board] UART (%u):\r\n", g_board_serial_count);
             for (uint8_t i = 0; i < g_board_serial_count; ++i)
-                Serial.printf("  UART%u  %-10s  baud=%-7lu  rx=%-2u  tx=%-2u  %s\r\n",
+                Serial.printf("  UART%u  %-10s  baud=%-7lu  rx=%-2u  tx=%-2u  lines=%u  dropped=%lu  %s\r\n",
                               g_board_serials[i].port_num, g_board_serials[i].name,
                               (unsigned long)g_board_serials[i].baud,
                               g_board_serials[i].rx_pin, g_board_serials[i].tx_pin,
+                              board_serial_lines(i), (unsigned long)board_serial_overflow(i),
                               g_board_serials[i].desc);
 
             Serial.printf("[Board] ADC (%u):\r\n", g_board_adc_count);
@@ -363,7 +494,7 @@ static void shell_run(const char *line) {
     // ── GPIO commands ──────────────────────────────────────────────────
     } else if (!strncmp(line, "gpio get ", 9)) {
         int pin = atoi(line + 9);
-        Serial.printf("GPIO %d = %d\r\n", pin, digitalRead(pin));
+        Serial.printf("GPIO %d = %d\r\n", pin, gpio_read((uint8_t)pin));
 
     } else if (!strncmp(line, "gpio set ", 9)) {
         char *rest = (char*)line + 9;
@@ -374,7 +505,7 @@ static void shell_run(const char *line) {
             if (!board_is_output_pin(pin))
                 Serial.printf("[!] GPIO %d not declared OUTPUT in board config.\r\n", pin);
             else {
-                digitalWrite(pin, val ? HIGH : LOW);
+                gpio_write((uint8_t)pin, val != 0);
                 Serial.printf("GPIO %d set to %d\r\n", pin, val ? 1 : 0);
             }
         }
@@ -422,9 +553,11 @@ static void shell_run(const char *line) {
         if (si < 0) Serial.printf("[!] No serial port named '%s'\r\n", name);
         else {
             char rbuf[128] = {};
-            // No explicit timeout — default 150 ms (Bug #6 fix)
-            board_serial_read(si, rbuf, sizeof(rbuf));
-            Serial.printf("serial '%s' → %s\r\n", name, rbuf);
+            uint32_t age = 0;
+            board_serial_read(si, rbuf, sizeof(rbuf), 150, &age);
+            Serial.printf("serial '%s' → %s  (%lu ms ago, %u more line(s), %lu dropped)\r\n",
+                          name, rbuf, (unsigned long)age, board_serial_lines(si),
+                          (unsigned long)board_serial_overflow(si));
         }
 
     // ── Servo shell commands ───────────────────────────────────────────
@@ -441,6 +574,7 @@ static void shell_run(const char *line) {
                 angle = max((int)g_board_servos[si].min_angle,
                             min((int)g_board_servos[si].max_angle, angle));
                 s_servos[si].write(angle);
+                s_sweep[si].pos = s_sweep[si].target = (int16_t)angle;   // cancel any sweep
                 Serial.printf("Servo '%s' → %d°\r\n", rest, angle);
             }
         }
@@ -468,6 +602,14 @@ static void shell_run(const char *line) {
             }
         }
 
+    // ── I2C scan ───────────────────────────────────────────────────────
+    // Only buses begun by board_init_peripherals() can be probed.
+    } else if (!strcmp(line, "i2c scan")) {
+        bool any = false;
+        for (uint8_t b = 0; b < 2; ++b)
+            if (s_i2c_scanned[b]) { i2c_scan_bus(b); any = true; }
+        if (!any) Serial.println("[!] No I2C bus configured.");
+
     } else if (line[0]) {
         Serial.printf("Unknown: '%s'  (type 'help')\r\n", line);
     }
@@ -476,24 +618,101 @@ static void shell_run(const char *line) {
 // ─── shell_byte ───────────────────────────────────────────────────────────────
 // IMPORTANT: bytes are ALWAYS consumed from the hardware FIFO so that the MCU
 // USB-CDC / UART receive buffer never overflows during a network operation.
-// Command *execution* is deferred until !g_http_busy; the partial line is
-// kept in g_cmd so the MCU can complete it once the network call finishes.
+// Command *execution* is deferred until !shell_held(): one completed line is
+// parked in g_cmd_pending and run by shell_task() once the request or the
+// agent turn (agent.h g_agent_turn) finishes.
+static inline bool shell_held() { return net_busy() || g_agent_turn; }
+
 static void shell_byte(uint8_t c) {
+    if (g_pushb.on) { push_bin_byte(c); return; }   // frames, not keystrokes
     if (c == '\n' || c == '\r') {
         g_cmd[g_cmd_len] = '\0';
+        mem_buf_note(MB_CMD, g_cmd_len + 1u, CMD_S);
         if (g_cmd_len > 0) {
             Serial.print("\r\n");
-            if (!g_http_busy) {
+            if (!shell_held()) {
                 shell_run(g_cmd);
+            } else if (!strncmp(g_cmd, "board push ", 11)) {
+                // A push must start now or not at all (push.h).
+                Serial.println("PUSH ERR busy\r\n[Board] ERROR: busy with a request : push again.");
+            } else if (!g_cmd_has_pending) {
+                strlcpy(g_cmd_pending, g_cmd, CMD_S);
+                g_cmd_has_pending = true;
             }
-            // else: board is mid-request drop silently; FIFO stays drained.
+            // else: a line is already parked, drop; FIFO stays drained.
         }
         g_cmd_len = 0;
-        if (!g_http_busy) shell_prompt();
+        if (!shell_held() && !g_pushb.on) shell_prompt();   // no prompt inside PUSH replies
     } else if (c == 127 || c == 8) {
-        if (g_cmd_len > 0) { --g_cmd_len; if (!g_http_busy) Serial.print("\b \b"); }
+        if (g_cmd_len > 0) { --g_cmd_len; if (!shell_held()) Serial.print("\b \b"); }
     } else if (g_cmd_len + 1 < CMD_S) {
         g_cmd[g_cmd_len++] = (char)c;
-        if (!g_http_busy) Serial.write(c);   // echo only when interactive
+        if (!shell_held()) Serial.write(c);   // echo only when interactive
+    }
+}
+
+// ─── shell_task ───────────────────────────────────────────────────────────────
+// Scheduler task (io): drain USB-CDC / UART0 into the line editor. Runs
+// between HTTP steps too, so typing stays live during a request.
+static void shell_task() {
+    // An abandoned push must not hold board_md (and the network) forever.
+    if (g_push_active && !g_pushb.on && millis() - g_push_ms >= PUSH_IDLE_MS) {
+        Serial.println("\r\n[Board] Push idle too long : aborted.");
+        push_restore();
+    }
+    const bool pushing = g_pushb.on;               // binary push (push.h) before this drain
+#if defined(ARDUINO_USB_CDC_ON_BOOT) && ARDUINO_USB_CDC_ON_BOOT
+    static bool     s_usb_state       = false;
+    static bool     s_usb_candidate   = false;
+    static uint32_t s_usb_debounce_ms = 0;
+    static constexpr uint32_t USB_DEBOUNCE_MS = 80;
+
+    bool raw = (bool)Serial;
+    if (raw != s_usb_candidate) {
+        s_usb_candidate   = raw;
+        s_usb_debounce_ms = millis();
+    }
+
+    if ((millis() - s_usb_debounce_ms) >= USB_DEBOUNCE_MS && s_usb_candidate != s_usb_state) {
+        bool prev    = s_usb_state;
+        s_usb_state  = s_usb_candidate;
+
+        if (s_usb_state && !prev) {
+            // USB reconnected : settle the PHY, then decide how to re-prompt
+            delay(50);
+            if (net_busy()) {
+                // LLM / Telegram / Discord request is in-flight, tell the user
+                // but do NOT print the normal prompt (it would appear mid-response)
+                Serial.println("\r\n[femtoclaw] reconnected : waiting for network response...");
+            } else if (g_cmd_len == 0) {
+                // Idle and buffer is empty, safe to re-prompt normally
+                shell_prompt();
+            }
+            // If g_cmd_len > 0, the user had a partial command typed before
+            // disconnect. The buffer is left intact and do not re-prompt so
+            // they can continue typing (their previous chars are lost from the
+            // terminal's perspective, but the MCU buffer still has them).
+        } else {
+            // USB disconnected : flush any pending TX so the host sees clean output
+            Serial.flush();
+        }
+    }
+
+    // Only process RX while USB is stably connected.
+    if (s_usb_state) {
+        while (Serial.available()) shell_byte((uint8_t)Serial.read());
+    }
+#else
+    while (Serial.available()) shell_byte((uint8_t)Serial.read());
+#endif
+    if (pushing) {
+        push_bin_idle();
+        if (!g_pushb.on) shell_prompt();            // back to the line editor
+    }
+
+    if (g_cmd_has_pending && !shell_held()) {
+        g_cmd_has_pending = false;
+        shell_run(g_cmd_pending);
+        shell_prompt();
     }
 }
\ No newline at end of file
@@ -0,0 +1,87 @@
+/*
+ * ─────────────────────────────────────────────────────────────
+ * FemtoClaw : lock-free single-producer / single-consumer queue.
+ *
+ * Fixed-capacity ring of N slots (power of two, ≤ 128). Exactly one
+ * context may call push() and exactly one other context may call pop();
+ * each side only writes its own index, so no lock or critical section is
+ * needed, across cores or between an ISR/callback and loop(). The
+ * release store on an index publishes the slot written before it.
+ *
+ * push() / pop() copy by value. For large records the producer can fill
+ * back() in place and commit() it, and the consumer can work on front()
+ * (or any queued slot, peek()) in place and drop() it when done.
+ *
+ * Depends on: <atomic>
+ * ─────────────────────────────────────────────────────────────
+ */
+
+#pragma once
+
+#include <atomic>
+
+template <typename T, uint8_t N>
+struct SpscQueue {
+    static_assert(N >= 2 && N <= 128 && (N & (N - 1)) == 0,
+                  "SpscQueue capacity must be a power of two in 2..128");
+
+    T                    slot[N];
+    std::atomic<uint8_t> head{0};     // written by the producer only
+    std::atomic<uint8_t> tail{0};     // written by the consumer only
+
+    // Producer side. Returns false when full; the value is not queued.
+    bool push(const T &v) {
+        uint8_t h = head.load(std::memory_order_relaxed);
+        if ((uint8_t)(h - tail.load(std::memory_order_acquire)) >= N) return false;
+        slot[h & (N - 1)] = v;
+        head.store((uint8_t)(h + 1), std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side. Returns false when empty.
+    bool pop(T &v) {
+        uint8_t t = tail.load(std::memory_order_relaxed);
+        if (t == head.load(std::memory_order_acquire)) return false;
+        v = slot[t & (N - 1)];
+        tail.store((uint8_t)(t + 1), std::memory_order_release);
+        return true;
+    }
+
+    // Producer side: fill the next free slot in place, then commit() it.
+    // nullptr when full.
+    T *back() {
+        uint8_t h = head.load(std::memory_order_relaxed);
+        if ((uint8_t)(h - tail.load(std::memory_order_acquire)) >= N) return nullptr;
+        return &slot[h & (N - 1)];
+    }
+    void commit() {
+        head.store((uint8_t)(head.load(std::memory_order_relaxed) + 1), std::memory_order_release);
+    }
+
+    // Consumer side: look at the oldest slot in place, nullptr when empty.
+    // The slot stays valid until drop() / pop().
+    T *front() {
+        uint8_t t = tail.load(std::memory_order_relaxed);
+        if (t == head.load(std::memory_order_acquire)) return nullptr;
+        return &slot[t & (N - 1)];
+    }
+    void drop() {
+        uint8_t t = tail.load(std::memory_order_relaxed);
+        if (t != head.load(std::memory_order_acquire))
+            tail.store((uint8_t)(t + 1), std::memory_order_release);
+    }
+    // Consumer side: the i-th oldest slot (peek(0) == front()), nullptr
+    // past the newest.
+    T *peek(uint8_t i) {
+        uint8_t t = tail.load(std::memory_order_relaxed);
+        if ((uint8_t)(head.load(std::memory_order_acquire) - t) <= i) return nullptr;
+        return &slot[(uint8_t)(t + i) & (N - 1)];
+    }
+
+    // Either side; a snapshot only.
+    uint8_t size() const {
+        return (uint8_t)(head.load(std::memory_order_acquire) -
+                         tail.load(std::memory_order_acquire));
+    }
+    bool empty() const { return size() == 0; }
+};
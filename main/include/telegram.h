@@ -1,83 +1,101 @@
 /*
  * ─────────────────────────────────────────────────────────────
- * FemtoClaw : Telegram long-polling channel.
+ * FemtoClaw : Telegram long-polling channel (webhook mode: webhook.h).
  *
- * Depends on: http.h, agent.h, config.h, json.h, persist.h
+ * tg_poll() only parses updates into the inbox (msgq.h); replies are
+ * packed, paced and retried by outbox_task, which calls tg_send_chunk().
+ *
+ * Depends on: http.h, msgq.h, config.h, json.h, persist.h
  * ─────────────────────────────────────────────────────────────
  */
 
 #pragma once
 
-static uint32_t g_tg_last_ms = 0;
-
-// ─── tg_send ──────────────────────────────────────────────────────────────────
-// Send text to Telegram chat, splitting into TG_MSG_CHUNK-byte chunks.
-static int16_t tg_send(const char *chat_id, const char *text) {
-    static char tg_esc[4096];
-    static char tg_path[CFG_S];
-    static char tg_body[4096];
-
-    uint16_t tlen = strlen(text);
-    int16_t last_code = 0;
-    uint16_t sent = 0;
-    while (sent < tlen) {
-        uint16_t chunk = min((uint16_t)(tlen - sent), TG_MSG_CHUNK);
-        json_escape(text + sent, chunk, tg_esc, JSON_OUT_S);
-        sent += chunk;
-        snprintf(tg_path, CFG_S, "/bot%s/sendMessage", g_cfg.telegram.token);
-        snprintf(tg_body, JSON_OUT_S,
-                 "{\"chat_id\":\"%s\",\"text\":\"%s\"}", chat_id, tg_esc);
-
-        g_suppress_tls_logs = true;
-        g_http_busy = true;
-        last_code = https_req(g_tls_tg, "api.telegram.org", tg_path, nullptr,
-                              tg_body, strlen(tg_body), g_http_resp, HTTP_RESP_S);
-        g_http_busy = false;
-        g_suppress_tls_logs = false;
-
-        Serial.printf("[Telegram] sendMessage code=%d\r\n", last_code);
-    }
-    return last_code;
-}
-
-// ─── tg_poll ──────────────────────────────────────────────────────────────────
-static void tg_poll() {
-    if (!g_cfg.telegram.enabled || !g_cfg.telegram.token[0]) return;
-    if ((millis() - g_tg_last_ms) < TG_POLL_MS) return;
-    if (g_http_busy) return;
-    g_tg_last_ms = millis();
-
-    snprintf(g_tx_path, CFG_S, "/bot%s/getUpdates?offset=%lld&timeout=1&limit=5",
-             g_cfg.telegram.token, (long long)g_tg_offset);
+// ─── tg_send_chunk ────────────────────────────────────────────────────────────
+// One sendMessage request; text is already cut to TG_MSG_CHUNK by msgq.h.
+// The JSON body is built in g_tx_body: net tasks never nest, so the LLM
+// request that also uses it is never in flight at the same time.
+static int16_t tg_send_chunk(const char *chat_id, const char *text, HttpMeta *meta) {
+    ArenaScope scope;
+    char *tg_path = arena_alloc(CFG_S + 32);            // a CFG_S token + "/bot" + method
+    if (!tg_path) return -1;
+    snprintf(tg_path, CFG_S + 32, "/bot%s/sendMessage", g_cfg.telegram.token);
+
+    uint16_t n = snprintf(g_tx_body, JSON_OUT_S, "{\"chat_id\":\"%s\",\"text\":\"", chat_id);
+    n += json_escape_into(g_tx_body + n, JSON_OUT_S - n - 2, text);
+    g_tx_body[n++] = '"';
+    g_tx_body[n++] = '}';
+    g_tx_body[n]   = '\0';
 
     g_suppress_tls_logs = true;
-    g_http_busy = true;
-    int16_t code = https_req(g_tls_tg, "api.telegram.org", g_tx_path, nullptr,
-                              nullptr, 0, g_http_resp, HTTP_RESP_S);
-    g_http_busy = false;
+    int16_t code = https_req(g_tls_tg, "api.telegram.org", tg_path, nullptr,
+                             g_tx_body, n, g_http_resp, HTTP_RESP_S, meta);
     g_suppress_tls_logs = false;
 
-    if (code != 200) {
-        Serial.printf("[Telegram] poll failed code=%d resp=%.150s\r\n", code, g_http_resp);
-        return;
-    }
+    Serial.printf("[Telegram] sendMessage code=%d%s\r\n", code,
+                  meta && meta->reused ? " (warm)" : "");
+    return code;
+}
 
-    const char *p = g_http_resp;
-    while ((p = strstr(p, "\"update_id\"")) != nullptr) {
-        int64_t uid = jint(p + strlen("\"update_id\"") + 1);
-        if (uid >= g_tg_offset) {
-            g_tg_offset = uid + 1;
-#if PERSIST_IMPL == 1
-            prefs.begin("femtoclaw", false);
-            prefs.putLong64("tg_offset", g_tg_offset);
-            prefs.end();
-#else
-            cfg_save();
-#endif
-        }
+/*
+ * ─── tg_poll ─────────────────────────────────────────────────────────────────
+ *
+ * Long polling: getUpdates?timeout=TG_LONG_POLL_S on its own client
+ * (g_tls_tg_poll) with keep-alive. The request is submitted to the net
+ * core without waiting (net_submit) and parks on Telegram's server until
+ * an update arrives or the timeout runs out; the scheduler task only
+ * checks for completion every pass, so a message is picked up within one
+ * pass of arriving and LLM calls / sends run while the poll is parked.
+ * The next poll goes out right away on the same warm connection, so an
+ * idle bot costs one small request per TG_LONG_POLL_S, not a handshake
+ * every TG_POLL_MS.
+ *
+ * Fallback: after TG_LP_FAILS failed long polls in a row (e.g. a proxy
+ * that cuts held requests), switch to short polling with an adaptive
+ * interval: TG_POLL_MIN_MS after activity, doubling while idle up to
+ * TG_POLL_MAX_MS. Long polling is tried again after TG_LP_RETRY_MS.
+ * Errors in either mode back off exponentially from TG_POLL_MS.
+ *
+ * At most inbox_room() updates are requested; the offset only moves past
+ * updates that were queued or skipped.
+ */
+static constexpr uint8_t  TG_LP_FAILS    = 3;
+static constexpr uint32_t TG_LP_RETRY_MS = 300000;
+
+struct TgPoller {
+    HttpJob  job;
+    char     path[CFG_S + 80];    // "/bot<token>/getUpdates?offset=…&timeout=…&limit=…"
+    char     resp[TG_POLL_RESP_S];
+    bool     started;
+    bool     active;          // job submitted, not yet reaped
+    bool     long_mode;
+    uint8_t  fails;           // consecutive failures
+    uint32_t interval_ms;     // short mode: current adaptive interval
+    uint32_t next_ms;         // earliest start of the next poll
+    uint32_t short_since;     // millis() when short mode began
+    // metrics
+    uint32_t polls, empty, errors, handshakes, hs_ms_total;
+};
+
+static TgPoller g_tgp = {};
+
+// Parse one getUpdates response (or one webhook update, webhook.h) into
+// the inbox. Returns updates queued. save_offset: write g_tg_offset to
+// flash once at the end if it moved.
+static uint8_t _tg_parse(const char *resp, bool save_offset = true) {
+    uint8_t queued = 0;
+    int64_t start_offset = g_tg_offset;
+    const char *p = resp;
+    for (; (p = strstr(p, "\"update_id\"")) != nullptr; ++p) {
+        const char *uv = p + strlen("\"update_id\"");
+        while (*uv == ' ' || *uv == ':') ++uv;
+        int64_t uid = jint(uv);
+        // jint saturates at INT64_MAX; no real update_id gets there, and
+        // uid + 1 below must not overflow.
+        if (uid < g_tg_offset || uid == INT64_MAX) continue;
 
         const char *msg_start = strstr(p, "\"message\"");
-        if (!msg_start) { ++p; continue; }
+        if (!msg_start) { g_tg_offset = uid + 1; continue; }
 
         char from_id[ALLOW_ID_LEN] = {0};
         char chat_id[ALLOW_ID_LEN] = {0};
@@ -99,21 +117,113 @@ static void tg_poll() {
         Serial.printf("[Telegram] update_id=%lld from=%s chat=%s text='%s'\r\n",
                       (long long)uid, from_id, chat_id, text);
 
-        if (!text[0]) { ++p; continue; }
-        if (!is_allowed(g_cfg.telegram, from_id)) {
+        if (text[0] && !is_allowed(g_cfg.telegram, from_id)) {
             Serial.printf("[Telegram] BLOCKED — from_id=%s not in allow list\r\n", from_id);
-            ++p; continue;
+        } else if (text[0]) {
+            if (!inbox_post(CH_TELEGRAM, chat_id, text)) {
+                Serial.printf("[Telegram] inbox full : update %lld left for the next poll\r\n",
+                              (long long)uid);
+                break;
+            }
+            ++queued;
         }
+        g_tg_offset = uid + 1;
+    }
 
-        const char *reply = agent_run(text);
-        Serial.printf("[Telegram] replying (%u chars) → chat %s\r\n",
-                      (unsigned)strlen(reply), chat_id);
+    // One flash write per poll, not one per update.
+    if (save_offset && g_tg_offset != start_offset) {
+#if PERSIST_IMPL == 1
+        prefs.begin("femtoclaw", false);
+        prefs.putLong64("tg_offset", g_tg_offset);
+        prefs.end();
+#else
+        cfg_save();
+#endif
+    }
+    return queued;
+}
 
-        delay(TLS_SETTLE_MS);
-        int16_t sc = tg_send(chat_id, reply);
-        if (sc != 200)
-            Serial.printf("[Telegram] send FAILED code=%d resp=%.100s\r\n", sc, g_http_resp);
+static void _tg_poll_done(TgPoller &t, uint32_t now) {
+    int16_t code = t.job.code;
+    ++t.polls;
+    if (code > 0) hist_add(H_POLL_TG, t.job.us_end - t.job.us_begin);
+    mem_buf_note(MB_TG_POLL, t.job.out_len + 1u, TG_POLL_RESP_S);
+    if (t.job.hs_ms) { ++t.handshakes; t.hs_ms_total += t.job.hs_ms; }
 
-        ++p;
+    if (code != 200) {
+        ++t.errors;
+        ++t.fails;
+        Serial.printf("[Telegram] poll failed code=%d resp=%.150s\r\n", code, t.resp);
+        if (t.long_mode && t.fails >= TG_LP_FAILS) {
+            Serial.println("[Telegram] long polling keeps failing : falling back to short polling");
+            t.long_mode   = false;
+            t.short_since = now;
+            t.interval_ms = TG_POLL_MS;
+        }
+        uint8_t  sh   = t.fails > 6 ? 6 : t.fails - 1;
+        uint32_t wait = TG_POLL_MS << sh;
+        t.next_ms = now + (wait > TG_POLL_MAX_MS ? TG_POLL_MAX_MS : wait);
+        return;
+    }
+    t.fails = 0;
+
+    uint8_t n = _tg_parse(t.resp);
+    if (!n) ++t.empty;
+
+    if (t.long_mode) {
+        t.next_ms = now;                                  // re-arm at once
+    } else {
+        if (n) t.interval_ms = TG_POLL_MIN_MS;
+        else   t.interval_ms = t.interval_ms * 2 > TG_POLL_MAX_MS ? TG_POLL_MAX_MS : t.interval_ms * 2;
+        t.next_ms = now + t.interval_ms;
+        if (TG_LONG_POLL_S && now - t.short_since >= TG_LP_RETRY_MS) t.long_mode = true;
     }
-}
\ No newline at end of file
+}
+
+// Scheduler task (net), every pass (20 ms).
+static void tg_poll() {
+    if (!g_cfg.telegram.enabled || !g_cfg.telegram.token[0]) return;
+    TgPoller &t = g_tgp;
+    uint32_t now = millis();
+
+    // Webhook mode (webhook.h): only reap a poll still in flight, which
+    // frees g_tgp.resp for the listener.
+    if (g_cfg.tg_webhook_port) {
+        if (t.active && net_job_done(t.job)) t.active = false;
+        return;
+    }
+
+    if (t.active) {
+        if (!net_job_done(t.job)) return;
+        t.active = false;
+        _tg_poll_done(t, now);
+    }
+    if (!t.started) {
+        t.started     = true;
+        t.long_mode   = TG_LONG_POLL_S > 0;
+        t.interval_ms = TG_POLL_MIN_MS;
+        t.short_since = now;
+    }
+    if ((int32_t)(now - t.next_ms) < 0) return;
+    uint8_t room = inbox_room();
+    if (!room) return;                                   // let the agent catch up
+
+    snprintf(t.path, sizeof(t.path), "/bot%s/getUpdates?offset=%lld&timeout=%u&limit=%u",
+             g_cfg.telegram.token, (long long)g_tg_offset,
+             t.long_mode ? (unsigned)TG_LONG_POLL_S : 0u, (unsigned)room);
+
+    g_suppress_tls_logs = true;
+    http_job_begin(t.job, g_tls_tg_poll, true, "api.telegram.org", 443, t.path,
+                   nullptr, nullptr, 0, t.resp, sizeof(t.resp), true);
+    t.job.park = t.long_mode;
+    g_suppress_tls_logs = false;
+    if (net_submit(t.job)) t.active = true;
+}
+
+static void tg_print_stats() {
+    const TgPoller &t = g_tgp;
+    Serial.printf("  TG poll   : %s  polls %lu (empty %lu, errors %lu)  handshakes %lu (%lu ms)\r\n",
+                  t.long_mode ? "long" : "short", (unsigned long)t.polls,
+                  (unsigned long)t.empty, (unsigned long)t.errors,
+                  (unsigned long)t.handshakes, (unsigned long)t.hs_ms_total);
+}
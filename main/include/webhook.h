@@ -0,0 +1,254 @@
+/*
+ * ─────────────────────────────────────────────────────────────
+ * FemtoClaw : Telegram webhook listener.
+ *
+ * With tg_webhook_port set, Telegram pushes each update to a small HTTP
+ * server on the device instead of the device polling getUpdates. The
+ * listener is plain HTTP: put a TLS-terminating reverse proxy or tunnel
+ * in front of it and register that public https:// URL with
+ * `tg webhook <port> <url> [secret]` (setWebhook). tg_poll() stands down
+ * while the port is set.
+ *
+ * Depends on: telegram.h, msgq.h, config.h, persist.h, http.h
+ * ─────────────────────────────────────────────────────────────
+ */
+
+#pragma once
+
+/*
+ * ─── webhook_task ────────────────────────────────────────────────────────────
+ *
+ * io task, every pass, never blocks: one connection at a time, stepped
+ * through WH_LISTEN → WH_HEAD → WH_BODY with whatever bytes are already
+ * in the socket, then answered and closed (Connection: close).
+ *
+ *   POST only                                   else 405
+ *   X-Telegram-Bot-Api-Secret-Token must match  else 401 (when a secret is set)
+ *   inbox_room() > 0                            else 503, Telegram redelivers
+ *   body up to TG_POLL_RESP_S - 1 bytes         else 200 and dropped, so an
+ *                                               oversized update is not
+ *                                               redelivered forever
+ *
+ * The body is read into g_tgp.resp: polling is off in webhook mode, and
+ * the listener waits for an in-flight poll to be reaped before it
+ * accepts. It goes through the same _tg_parse() as a getUpdates reply
+ * (allow list, inbox_post); g_tg_offset drops redeliveries but is not
+ * written to flash per update.
+ */
+static constexpr uint32_t WH_TIMEOUT_MS = 3000;     // whole request, accept → reply
+static constexpr uint16_t WH_READ_MAX   = 1024;     // bytes read per pass
+
+enum WhState : uint8_t { WH_OFF, WH_LISTEN, WH_HEAD, WH_BODY };
+
+struct Webhook {
+    WiFiClient cli;
+    WhState  state;
+    uint16_t port;            // port the server is bound to, 0 = not bound
+    uint32_t t0;              // millis() at accept
+    char     line[128];       // current header line (truncated, rest ignored)
+    uint8_t  line_len;
+    bool     first_line, post, secret_ok;
+    uint32_t clen, got;
+    // metrics
+    uint32_t requests, updates, rejected, busy, oversize, timeouts;
+    uint32_t bytes, first_ms, last_ms, max_ms;   // first_ms: first accept, last_ms: last update
+};
+
+static WiFiServer g_wh_server(80);
+static Webhook    g_wh = {};
+
+static inline bool webhook_on() {
+    return g_cfg.telegram.enabled && g_cfg.tg_webhook_port != 0;
+}
+
+static void _wh_reply(Webhook &w, int16_t code, const char *reason) {
+    char hdr[96];
+    int n = snprintf(hdr, sizeof(hdr),
+                     "HTTP/1.1 %d %s\r\nContent-Length: 0\r\nConnection: close\r\n\r\n",
+                     code, reason);
+    w.cli.write((const uint8_t *)hdr, n);
+    w.cli.stop();
+    w.state = WH_LISTEN;
+
+    uint32_t ms = millis() - w.t0;
+    if (ms > w.max_ms) w.max_ms = ms;
+    if (code >= 400 && code != 503) ++w.rejected;
+    if (code != 200)
+        Serial.printf("[Webhook] %d %s\r\n", code, reason);
+}
+
+// One complete header line in w.line (CR/LF stripped).
+static void _wh_header(Webhook &w) {
+    const char *l = w.line;
+    if (w.first_line) {
+        w.first_line = false;
+        w.post = !strncmp(l, "POST ", 5);
+        return;
+    }
+    if (!strncasecmp(l, "content-length:", 15)) {
+        w.clen = strtoul(l + 15, nullptr, 10);
+    } else if (!strncasecmp(l, "x-telegram-bot-api-secret-token:", 32)) {
+        const char *v = l + 32;
+        while (*v == ' ') ++v;
+        w.secret_ok = !strcmp(v, g_cfg.tg_webhook_secret);
+    }
+}
+
+// Headers done: answer now, or move on to the body.
+static void _wh_head_done(Webhook &w) {
+    if (!w.post)                                  return _wh_reply(w, 405, "Method Not Allowed");
+    if (g_cfg.tg_webhook_secret[0] && !w.secret_ok) return _wh_reply(w, 401, "Unauthorized");
+    if (!w.clen)                                  return _wh_reply(w, 411, "Length Required");
+    if (!inbox_room()) { ++w.busy;                return _wh_reply(w, 503, "Service Unavailable"); }
+    w.got   = 0;
+    w.state = WH_BODY;
+}
+
+static void _wh_body_done(Webhook &w) {
+    uint32_t now = millis();
+    w.bytes += w.got;
+    if (w.clen >= sizeof(g_tgp.resp)) {
+        ++w.oversize;
+        Serial.printf("[Webhook] update of %lu bytes > %u : acknowledged and dropped\r\n",
+                      (unsigned long)w.clen, (unsigned)(sizeof(g_tgp.resp) - 1));
+        return _wh_reply(w, 200, "OK");
+    }
+    g_tgp.resp[w.got] = '\0';
+    uint8_t n = _tg_parse(g_tgp.resp, false);
+    if (n) {
+        w.updates += n;
+        w.last_ms  = now;
+    }
+    _wh_reply(w, 200, "OK");
+}
+
+static void webhook_task() {
+    Webhook &w = g_wh;
+    uint16_t port = webhook_on() ? g_cfg.tg_webhook_port : 0;
+
+    // Port changed or webhook turned off: drop the listener.
+    if (w.port && w.port != port) {
+        if (w.state >= WH_HEAD) w.cli.stop();
+        g_wh_server.stop();
+        Serial.printf("[Webhook] stopped listening on :%u\r\n", (unsigned)w.port);
+        w.port  = 0;
+        w.state = WH_OFF;
+    }
+    if (!port) return;
+
+    if (w.state == WH_OFF) {
+        if (WiFi.status() != WL_CONNECTED) return;
+        g_wh_server.begin(port);
+        w.port  = port;
+        w.state = WH_LISTEN;
+        Serial.printf("[Webhook] listening on %s:%u\r\n",
+                      WiFi.localIP().toString().c_str(), (unsigned)port);
+    }
+
+    if (w.state == WH_LISTEN) {
+        if (g_tgp.active) return;                  // last poll still owns g_tgp.resp
+        w.cli = g_wh_server.accept();
+        if (!w.cli) return;
+        if (!w.requests++) w.first_ms = millis();
+        w.state      = WH_HEAD;
+        w.t0         = millis();
+        w.line_len   = 0;
+        w.first_line = true;
+        w.post = w.secret_ok = false;
+        w.clen = w.got = 0;
+    }
+
+    if (millis() - w.t0 >= WH_TIMEOUT_MS) {
+        ++w.timeouts;
+        return _wh_reply(w, 408, "Request Timeout");
+    }
+
+    uint16_t budget = WH_READ_MAX;
+    if (w.state == WH_HEAD) {
+        while (budget && w.cli.available()) {
+            int c = w.cli.read();
+            if (c < 0) break;
+            --budget;
+            if (c == '\r') continue;
+            if (c != '\n') {
+                if (w.line_len < sizeof(w.line) - 1) w.line[w.line_len++] = (char)c;
+                continue;
+            }
+            w.line[w.line_len] = '\0';
+            if (!w.line_len) { _wh_head_done(w); break; }
+            _wh_header(w);
+            w.line_len = 0;
+        }
+    }
+
+    if (w.state == WH_BODY) {
+        const uint32_t cap = sizeof(g_tgp.resp) - 1;
+        while (budget && w.got < w.clen) {
+            int avail = w.cli.available();
+            if (avail <= 0) break;
+            uint32_t want = w.clen - w.got;
+            if (want > (uint32_t)avail) want = avail;
+            if (want > budget)          want = budget;
+            int r;
+            if (w.got < cap) {
+                if (want > cap - w.got) want = cap - w.got;
+                r = w.cli.read((uint8_t *)g_tgp.resp + w.got, want);
+            } else {
+                r = w.cli.read() < 0 ? 0 : 1;      // past the buffer: discard
+            }
+            if (r <= 0) break;
+            w.got  += r;
+            budget -= r;
+        }
+        if (w.got >= w.clen) return _wh_body_done(w);
+    }
+
+    if (w.state >= WH_HEAD && !w.cli.connected() && !w.cli.available())
+        _wh_reply(w, 400, "Bad Request");          // peer gave up mid-request
+}
+
+/*
+ * ─── setWebhook / deleteWebhook ──────────────────────────────────────────────
+ * Blocking, from the shell. url is the public https:// address of the
+ * proxy in front of the listener; allowed_updates keeps pushes to the
+ * message updates _tg_parse() handles.
+ */
+static int16_t tg_set_webhook(const char *url, const char *secret) {
+    ArenaScope scope;
+    char *path = arena_alloc(CFG_S + 32);               // a CFG_S token + "/bot" + method
+    if (!path) return -1;
+    snprintf(path, CFG_S + 32, "/bot%s/setWebhook", g_cfg.telegram.token);
+    uint16_t n = snprintf(g_tx_body, JSON_OUT_S, "{\"url\":\"");
+    n += json_escape_into(g_tx_body + n, JSON_OUT_S - n - 64, url);
+    n += snprintf(g_tx_body + n, JSON_OUT_S - n,
+                  "\",\"secret_token\":\"%s\",\"allowed_updates\":[\"message\"]}", secret);
+    int16_t code = https_req(g_tls_tg, "api.telegram.org", path, nullptr,
+                             g_tx_body, n, g_http_resp, HTTP_RESP_S);
+    Serial.printf("[Telegram] setWebhook code=%d resp=%.150s\r\n", code, g_http_resp);
+    return code;
+}
+
+static int16_t tg_delete_webhook() {
+    ArenaScope scope;
+    char *path = arena_alloc(CFG_S + 32);
+    if (!path) return -1;
+    snprintf(path, CFG_S + 32, "/bot%s/deleteWebhook", g_cfg.telegram.token);
+    int16_t code = https_req(g_tls_tg, "api.telegram.org", path, nullptr,
+                             "{}", 2, g_http_resp, HTTP_RESP_S);
+    Serial.printf("[Telegram] deleteWebhook code=%d resp=%.150s\r\n", code, g_http_resp);
+    return code;
+}
+
+static void webhook_print_stats() {
+    const Webhook &w = g_wh;
+    // first request → last update, so the first update's own receive time counts
+    uint32_t span = w.updates ? w.last_ms - w.first_ms : 0;
+    uint32_t rate = span ? (uint32_t)((uint64_t)w.updates * 100000 / span) : 0;
+    Serial.printf("  TG hook   : :%u  requests %lu  updates %lu (%lu.%02lu/s)  "
+                  "rejected %lu  busy %lu  oversize %lu  timeouts %lu  %lu B  max %lu ms\r\n",
+                  (unsigned)w.port, (unsigned long)w.requests, (unsigned long)w.updates,
+                  (unsigned long)(rate / 100), (unsigned long)(rate % 100),
+                  (unsigned long)w.rejected, (unsigned long)w.busy,
+                  (unsigned long)w.oversize, (unsigned long)w.timeouts,
+                  (unsigned long)w.bytes, (unsigned long)w.max_ms);
+}
@@ -0,0 +1,192 @@
+/*
+ * ─────────────────────────────────────────────────────────────
+ * FemtoClaw : native (Linux) Arduino shim.
+ *
+ * [env:native] builds the firmware as a Linux process. It presents
+ * itself as an ESP32 (-DBOARD_ESP32 -DFC_NATIVE), so the sources need
+ * no extra branches; this header supplies the part of the ESP32 Arduino
+ * core they use:
+ *
+ *   Serial           stdin / stdout (raw mode on a terminal)
+ *   Serial1/2        UARTs with nothing attached: writes are dropped
+ *   millis / delay   CLOCK_MONOTONIC, nanosleep
+ *   GPIO / LEDC      a simulated pin table (FC_NATIVE_GPIO=1 traces it)
+ *   ESP / FreeRTOS   fixed heap figures; xTaskCreatePinnedToCore → thread
+ *
+ * WiFi.h, WiFiClientSecure.h, Preferences.h and Wire.h next to it cover
+ * sockets, storage and I2C. Implementation: arduino_native.cpp.
+ * ─────────────────────────────────────────────────────────────
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <stdarg.h>
+#include <math.h>
+#include <algorithm>
+#include <functional>
+#include <string>
+
+using std::min;
+using std::max;
+
+#define HIGH            1
+#define LOW             0
+#define INPUT           0x01
+#define OUTPUT          0x03
+#define INPUT_PULLUP    0x05
+#define INPUT_PULLDOWN  0x09
+#define LED_BUILTIN     2
+#define SERIAL_8N1      0x800001c
+
+#if !defined(__GLIBC__) || __GLIBC__ < 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ < 38)
+size_t strlcpy(char *dst, const char *src, size_t size);
+size_t strlcat(char *dst, const char *src, size_t size);
+#endif
+
+// ─── Timing ──────────────────────────────────────────────────────────────────
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+// ─── GPIO / PWM (simulated pin table) ────────────────────────────────────────
+static constexpr uint8_t NATIVE_PINS = 64;
+
+void     pinMode(uint8_t pin, uint8_t mode);
+void     digitalWrite(uint8_t pin, uint8_t val);
+int      digitalRead(uint8_t pin);
+uint16_t analogRead(uint8_t pin);
+void     analogWrite(uint8_t pin, int val);
+uint32_t ledcSetup(uint8_t chan, uint32_t freq, uint8_t bits);
+void     ledcAttachPin(uint8_t pin, uint8_t chan);
+void     ledcDetachPin(uint8_t pin);
+void     ledcWrite(uint8_t chan, uint32_t duty);
+
+// Test hooks: drive an input / read back an output.
+void     native_pin_set(uint8_t pin, uint8_t level, uint16_t analog);
+uint8_t  native_pin_level(uint8_t pin);
+void     native_reg_write(uint32_t reg, uint32_t val);    // soc/soc.h REG_WRITE
+void     native_serial_mute(bool on);                      // drop console output
+
+long random(long max);
+long random(long min, long max);
+void randomSeed(unsigned long seed);
+
+// ─── String (the little the firmware uses) ───────────────────────────────────
+class String {
+  std::string s;
+public:
+  String(const char *c = "") : s(c ? c : "") {}
+  const char *c_str() const { return s.c_str(); }
+  size_t      length() const { return s.size(); }
+};
+
+// ─── Print / Stream ──────────────────────────────────────────────────────────
+class Print {
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t *b, size_t n) {
+    size_t i = 0;
+    while (i < n && write(b[i])) ++i;
+    return i;
+  }
+  size_t write(const char *s) { return write((const uint8_t *)s, strlen(s)); }
+  size_t print(const char *s) { return write((const uint8_t *)s, strlen(s)); }
+  size_t print(char c)        { return write((uint8_t)c); }
+  size_t print(int v)         { char b[16]; snprintf(b, sizeof(b), "%d", v); return print(b); }
+  size_t print(unsigned v)    { char b[16]; snprintf(b, sizeof(b), "%u", v); return print(b); }
+  size_t print(long v)        { char b[24]; snprintf(b, sizeof(b), "%ld", v); return print(b); }
+  size_t print(unsigned long v) { char b[24]; snprintf(b, sizeof(b), "%lu", v); return print(b); }
+  size_t print(const String &s) { return print(s.c_str()); }
+  size_t println()            { return print("\r\n"); }
+  template <typename T> size_t println(T v) { return print(v) + println(); }
+  size_t printf(const char *fmt, ...) __attribute__((format(printf, 2, 3))) {
+    char buf[1024];
+    va_list a;
+    va_start(a, fmt);
+    int n = vsnprintf(buf, sizeof(buf), fmt, a);
+    va_end(a);
+    if (n < 0) return 0;
+    return write((const uint8_t *)buf, (size_t)n < sizeof(buf) ? (size_t)n : sizeof(buf) - 1);
+  }
+  virtual void flush() {}
+};
+
+class Stream : public Print {
+protected:
+  unsigned long _timeout = 1000;
+public:
+  virtual int  available() = 0;
+  virtual int  read() = 0;
+  virtual int  peek() { return -1; }
+  void   setTimeout(unsigned long ms) { _timeout = ms; }
+  size_t readBytes(char *b, size_t n) {
+    size_t i = 0;
+    unsigned long t0 = millis();
+    while (i < n && millis() - t0 < _timeout) {
+      int c = read();
+      if (c < 0) { delay(1); continue; }
+      b[i++] = (char)c;
+    }
+    return i;
+  }
+};
+
+// ─── Serial ──────────────────────────────────────────────────────────────────
+enum hardwareSerial_error_t {
+  UART_NO_ERROR, UART_BREAK_ERROR, UART_BUFFER_FULL_ERROR,
+  UART_FIFO_OVF_ERROR, UART_FRAME_ERROR, UART_PARITY_ERROR
+};
+
+class HardwareSerial : public Stream {
+  int8_t _num;                  // 0 = console (stdin / stdout)
+public:
+  explicit HardwareSerial(int8_t num) : _num(num) {}
+  void   begin(unsigned long baud, uint32_t config = SERIAL_8N1, int8_t rx = -1, int8_t tx = -1);
+  void   end() {}
+  int    available() override;
+  int    read() override;
+  size_t write(uint8_t c) override { return write(&c, 1); }
+  size_t write(const uint8_t *b, size_t n) override;
+  using Print::write;
+  void   flush() override;
+  operator bool() const { return true; }
+  void   setRxBufferSize(size_t) {}
+  void   onReceive(std::function<void(void)>, bool = false) {}
+  void   onReceiveError(std::function<void(hardwareSerial_error_t)>) {}
+};
+
+extern HardwareSerial Serial, Serial1, Serial2;
+
+// ─── ESP / FreeRTOS ──────────────────────────────────────────────────────────
+// Fixed heap figures: the firmware's low-heap guards never trip on a host.
+struct EspClass {
+  uint32_t getFreeHeap()    { return 256 * 1024; }
+  uint32_t getMinFreeHeap() { return 256 * 1024; }
+  uint32_t getMaxAllocHeap(){ return 128 * 1024; }
+  uint32_t getHeapSize()    { return 320 * 1024; }
+  void     restart();
+};
+extern EspClass ESP;
+
+typedef void    *TaskHandle_t;
+typedef int      BaseType_t;
+typedef unsigned UBaseType_t;
+#define pdPASS 1
+BaseType_t xTaskCreatePinnedToCore(void (*fn)(void *), const char *name, uint32_t stack,
+                                   void *arg, unsigned prio, TaskHandle_t *handle, int core);
+// Host threads have no painted stacks: high-water marks read as 0.
+inline TaskHandle_t xTaskGetCurrentTaskHandle()              { return nullptr; }
+inline UBaseType_t  uxTaskGetStackHighWaterMark(TaskHandle_t) { return 0; }
+
+void setup();
+void loop();
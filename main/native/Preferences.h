@@ -0,0 +1,63 @@
+/*
+ * ─────────────────────────────────────────────────────────────
+ * FemtoClaw : native (Linux) Preferences shim.
+ *
+ * One file per namespace, <FC_NATIVE_DIR>/<namespace>.nvs (default
+ * directory ./native_data), rewritten at end() when something changed,
+ * so a cfg_save() of 30 keys is one write. Same typed get / put calls
+ * and defaults as the ESP32 NVS wrapper.
+ * ─────────────────────────────────────────────────────────────
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <map>
+#include <vector>
+
+class Preferences {
+  std::map<std::string, std::vector<uint8_t>> _kv;
+  std::string _file;
+  bool        _ro   = false;
+  bool        _open = false;
+  bool        _dirty = false;
+
+  void   _save();
+  size_t _put(const char *key, const void *v, size_t n);
+  size_t _get(const char *key, void *v, size_t n) const;
+  template <typename T> T _get_or(const char *key, T def) const {
+    T v;
+    return _get(key, &v, sizeof(v)) == sizeof(v) ? v : def;
+  }
+
+public:
+  bool   begin(const char *name, bool read_only = false, const char *partition = nullptr);
+  void   end() { if (_dirty) _save(); _dirty = _open = false; _kv.clear(); }
+  bool   clear();
+  bool   remove(const char *key);
+  bool   isKey(const char *key) const { return _kv.count(key) != 0; }
+
+  size_t putBool  (const char *k, bool v)     { uint8_t b = v; return _put(k, &b, 1); }
+  size_t putUChar (const char *k, uint8_t v)  { return _put(k, &v, sizeof(v)); }
+  size_t putUShort(const char *k, uint16_t v) { return _put(k, &v, sizeof(v)); }
+  size_t putInt   (const char *k, int32_t v)  { return _put(k, &v, sizeof(v)); }
+  size_t putUInt  (const char *k, uint32_t v) { return _put(k, &v, sizeof(v)); }
+  size_t putLong  (const char *k, int32_t v)  { return _put(k, &v, sizeof(v)); }
+  size_t putLong64(const char *k, int64_t v)  { return _put(k, &v, sizeof(v)); }
+  size_t putFloat (const char *k, float v)    { return _put(k, &v, sizeof(v)); }
+  size_t putString(const char *k, const char *v) { return _put(k, v, strlen(v) + 1) ? strlen(v) : 0; }
+  size_t putBytes (const char *k, const void *v, size_t n) { return _put(k, v, n); }
+
+  bool     getBool  (const char *k, bool d = false)    const { return _get_or<uint8_t>(k, d) != 0; }
+  uint8_t  getUChar (const char *k, uint8_t d = 0)     const { return _get_or(k, d); }
+  uint16_t getUShort(const char *k, uint16_t d = 0)    const { return _get_or(k, d); }
+  int32_t  getInt   (const char *k, int32_t d = 0)     const { return _get_or(k, d); }
+  uint32_t getUInt  (const char *k, uint32_t d = 0)    const { return _get_or(k, d); }
+  int32_t  getLong  (const char *k, int32_t d = 0)     const { return _get_or(k, d); }
+  int64_t  getLong64(const char *k, int64_t d = 0)     const { return _get_or(k, d); }
+  float    getFloat (const char *k, float d = NAN)     const { return _get_or(k, d); }
+  size_t   getString(const char *k, char *v, size_t n) const;
+  String   getString(const char *k, const String &d = String()) const;
+  size_t   getBytesLength(const char *k) const;
+  size_t   getBytes (const char *k, void *v, size_t n) const { return _get(k, v, n); }
+};
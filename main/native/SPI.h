@@ -0,0 +1,2 @@
+#pragma once
+// Native build: no SPI peripherals.
@@ -0,0 +1,82 @@
+/*
+ * ─────────────────────────────────────────────────────────────
+ * FemtoClaw : native (Linux) WiFi shim.
+ *
+ * The host network is always "connected". WiFiClient is a POSIX TCP
+ * socket (blocking connect with the Stream timeout, non-blocking reads),
+ * WiFiServer a non-blocking listening socket. Copies of a client share
+ * the socket, like the ESP32 core's.
+ * ─────────────────────────────────────────────────────────────
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <memory>
+
+#define WL_IDLE_STATUS   0
+#define WL_NO_SSID_AVAIL 1
+#define WL_CONNECTED     3
+#define WL_DISCONNECTED  6
+#define WIFI_OFF         0
+#define WIFI_STA         1
+
+struct IPAddress {
+  uint8_t b[4] = {127, 0, 0, 1};
+  String toString() const {
+    char s[16];
+    snprintf(s, sizeof(s), "%u.%u.%u.%u", b[0], b[1], b[2], b[3]);
+    return String(s);
+  }
+};
+
+struct WiFiClass {
+  int       status()                             { return WL_CONNECTED; }
+  void      mode(int)                            {}
+  void      setSleep(bool)                       {}
+  int       begin(const char *, const char * = nullptr) { return WL_CONNECTED; }
+  bool      disconnect(bool = false)             { return true; }
+  IPAddress localIP();
+  int       hostByName(const char *host, IPAddress &ip);   // getaddrinfo, IPv4
+  int8_t    RSSI()                               { return -40; }
+  String    SSID()                               { return String("native"); }
+};
+extern WiFiClass WiFi;
+
+struct NativeSock {
+  int fd;
+  explicit NativeSock(int f) : fd(f) {}
+  ~NativeSock();
+};
+
+class WiFiClient : public Stream {
+protected:
+  std::shared_ptr<NativeSock> _sock;
+public:
+  WiFiClient() {}
+  explicit WiFiClient(int fd) : _sock(std::make_shared<NativeSock>(fd)) {}
+  virtual int     connect(const char *host, uint16_t port);
+  virtual uint8_t connected();
+  virtual void    stop();
+  int     available() override;
+  int     read() override;
+  virtual int read(uint8_t *buf, size_t n);
+  size_t  write(uint8_t c) override { return write(&c, 1); }
+  size_t  write(const uint8_t *b, size_t n) override;
+  using Print::write;
+  void    setNoDelay(bool on);
+  int     fd() const { return _sock ? _sock->fd : -1; }
+  operator bool() { return connected(); }
+};
+
+class WiFiServer {
+  uint16_t _port;
+  int      _fd = -1;
+public:
+  explicit WiFiServer(uint16_t port) : _port(port) {}
+  ~WiFiServer() { stop(); }
+  void       begin(uint16_t port = 0);
+  WiFiClient accept();
+  WiFiClient available() { return accept(); }
+  void       stop();
+};
@@ -0,0 +1,20 @@
+/*
+ * ─────────────────────────────────────────────────────────────
+ * FemtoClaw : native (Linux) WiFiClientSecure shim.
+ *
+ * Plain TCP: the native build talks to local stand-in servers, not to
+ * the real APIs, so there is no TLS layer. The trust settings are
+ * accepted and ignored.
+ * ─────────────────────────────────────────────────────────────
+ */
+
+#pragma once
+
+#include <WiFi.h>
+
+class WiFiClientSecure : public WiFiClient {
+public:
+  void setInsecure() {}
+  void setCACert(const char *) {}
+  void setHandshakeTimeout(unsigned long) {}
+};
@@ -0,0 +1,64 @@
+/*
+ * ─────────────────────────────────────────────────────────────
+ * FemtoClaw : native (Linux) Wire shim : a simulated I2C bus.
+ *
+ * With nothing attached every address NACKs (endTransmission() == 2)
+ * and reads return no bytes. sim_attach() puts one register-file device
+ * on the bus (first written byte sets the pointer, which auto-increments
+ * on every read / write, like most sensors), and every transfer is
+ * appended to sim_log() as text:
+ *
+ *   "S 68 W 6B 00 P"            write, STOP
+ *   "S 68 W 3B Sr 68 R 01 02 P" write, repeated START, read, STOP
+ *
+ * Calls behave like arduino-esp32 2.x: endTransmission(false) only
+ * queues the write for the next requestFrom() to the same address, and
+ * a beginTransmission() in between drops it; a read always ends in STOP.
+ * ─────────────────────────────────────────────────────────────
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <string>
+
+struct SimI2cDevice {
+  uint8_t addr;
+  uint8_t reg[256];
+  uint8_t ptr;
+};
+
+class TwoWire : public Stream {
+  SimI2cDevice *_dev = nullptr;
+  std::string   _log;
+  uint8_t       _addr = 0;
+  uint8_t       _tx[128];
+  size_t        _tx_len = 0;
+  bool          _queued = false;      // write waiting for a repeated-START read
+  uint8_t       _rx[256];
+  size_t        _rx_len = 0, _rx_pos = 0;
+
+  bool _ack(uint8_t a) const { return _dev && _dev->addr == a; }
+  void _put_write();
+public:
+  bool    begin(int sda = -1, int scl = -1, uint32_t freq = 0) { (void)sda; (void)scl; (void)freq; return true; }
+  void    setClock(uint32_t) {}
+  void    setTimeOut(uint16_t) {}
+  void    beginTransmission(uint8_t a) { _addr = a; _tx_len = 0; _queued = false; }
+  uint8_t endTransmission(bool stop = true);
+  uint8_t requestFrom(uint8_t a, size_t n, bool stop = true);
+  uint8_t requestFrom(int a, int n) { return requestFrom((uint8_t)a, (size_t)n); }
+  size_t  write(uint8_t b) override {
+    if (_tx_len >= sizeof(_tx)) return 0;
+    _tx[_tx_len++] = b;
+    return 1;
+  }
+  using Print::write;
+  int     available() override { return (int)(_rx_len - _rx_pos); }
+  int     read() override { return _rx_pos < _rx_len ? _rx[_rx_pos++] : -1; }
+
+  void         sim_attach(SimI2cDevice *d) { _dev = d; }
+  std::string &sim_log() { return _log; }
+};
+
+extern TwoWire Wire, Wire1;
@@ -0,0 +1,545 @@
+/*
+ * ─────────────────────────────────────────────────────────────
+ * FemtoClaw : native (Linux) Arduino shim, implementation.
+ *
+ * Built only by [env:native] (build_src_filter). main() calls setup()
+ * once and then loop() forever, like the Arduino core. FC_NATIVE_NO_MAIN
+ * leaves main() out for programs that bring their own ([env:native_bench]).
+ *
+ * Environment:
+ *   FC_NATIVE_DIR    Preferences directory (default ./native_data)
+ *   FC_NATIVE_GPIO   1 = trace pin writes on stderr
+ * ─────────────────────────────────────────────────────────────
+ */
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <Wire.h>
+#include <Preferences.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <signal.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <random>
+#include <thread>
+
+HardwareSerial Serial(0), Serial1(1), Serial2(2);
+EspClass       ESP;
+WiFiClass      WiFi;
+TwoWire        Wire, Wire1;
+
+#if !defined(__GLIBC__) || __GLIBC__ < 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ < 38)
+size_t strlcpy(char *dst, const char *src, size_t size) {
+  size_t n = strlen(src);
+  if (size) {
+    size_t c = n < size - 1 ? n : size - 1;
+    memcpy(dst, src, c);
+    dst[c] = '\0';
+  }
+  return n;
+}
+
+size_t strlcat(char *dst, const char *src, size_t size) {
+  size_t d = strnlen(dst, size);
+  if (d == size) return size + strlen(src);
+  return d + strlcpy(dst + d, src, size - d);
+}
+#endif
+
+/*
+*   ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+*                                 Timing
+*   ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+*/
+static uint64_t _mono_us() {
+  static struct timespec t0;
+  static bool            init = false;
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  if (!init) { t0 = t; init = true; }
+  return (uint64_t)(t.tv_sec - t0.tv_sec) * 1000000ULL + (t.tv_nsec - t0.tv_nsec) / 1000;
+}
+
+unsigned long millis() { return (unsigned long)(_mono_us() / 1000); }
+unsigned long micros() { return (unsigned long)_mono_us(); }
+
+void delayMicroseconds(unsigned int us) {
+  struct timespec t = { (time_t)(us / 1000000), (long)(us % 1000000) * 1000 };
+  while (nanosleep(&t, &t) && errno == EINTR) {}
+}
+
+void delay(unsigned long ms) { delayMicroseconds((unsigned int)(ms * 1000)); }
+void yield() { std::this_thread::yield(); }
+
+/*
+*   ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+*                          Simulated pin table
+*   ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+*/
+struct NativePin {
+  uint8_t  mode;
+  uint8_t  level;
+  uint16_t analog;              // analogRead() value
+  uint32_t duty;                // ledcWrite / analogWrite
+  int8_t   ledc;                // attached LEDC channel, -1 none
+};
+
+static NativePin s_pins[NATIVE_PINS];
+static uint32_t  s_ledc_duty[16];
+static bool      s_gpio_trace = false;
+
+static void _pin_trace(uint8_t pin, const char *what, uint32_t v) {
+  if (s_gpio_trace) fprintf(stderr, "[gpio] %u %s %lu\n", pin, what, (unsigned long)v);
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+  if (pin >= NATIVE_PINS) return;
+  s_pins[pin].mode = mode;
+  if (mode == INPUT_PULLUP) s_pins[pin].level = HIGH;
+  if (mode == INPUT_PULLDOWN) s_pins[pin].level = LOW;
+}
+
+void digitalWrite(uint8_t pin, uint8_t val) {
+  if (pin >= NATIVE_PINS) return;
+  s_pins[pin].level = val ? HIGH : LOW;
+  _pin_trace(pin, "=", s_pins[pin].level);
+}
+
+int digitalRead(uint8_t pin) { return pin < NATIVE_PINS ? s_pins[pin].level : LOW; }
+uint16_t analogRead(uint8_t pin) { return pin < NATIVE_PINS ? s_pins[pin].analog : 0; }
+
+void analogWrite(uint8_t pin, int val) {
+  if (pin >= NATIVE_PINS) return;
+  s_pins[pin].duty = (uint32_t)val;
+  _pin_trace(pin, "pwm", (uint32_t)val);
+}
+
+uint32_t ledcSetup(uint8_t, uint32_t freq, uint8_t) { return freq; }
+
+void ledcAttachPin(uint8_t pin, uint8_t chan) {
+  if (pin < NATIVE_PINS && chan < 16) s_pins[pin].ledc = (int8_t)chan;
+}
+
+void ledcDetachPin(uint8_t pin) {
+  if (pin < NATIVE_PINS) s_pins[pin].ledc = -1;
+}
+
+void ledcWrite(uint8_t chan, uint32_t duty) {
+  if (chan >= 16) return;
+  s_ledc_duty[chan] = duty;
+  for (uint8_t p = 0; p < NATIVE_PINS; ++p)
+    if (s_pins[p].ledc == chan) { s_pins[p].duty = duty; _pin_trace(p, "pwm", duty); }
+}
+
+void native_pin_set(uint8_t pin, uint8_t level, uint16_t analog) {
+  if (pin >= NATIVE_PINS) return;
+  s_pins[pin].level  = level;
+  s_pins[pin].analog = analog;
+}
+
+uint8_t native_pin_level(uint8_t pin) { return pin < NATIVE_PINS ? s_pins[pin].level : LOW; }
+
+// GPIO_OUT_W1TS / W1TC (pins 0..31) and the OUT1 bank (32..63).
+void native_reg_write(uint32_t reg, uint32_t val) {
+  uint8_t base  = (reg == 0x3FF44014 || reg == 0x3FF44018) ? 32 : 0;
+  uint8_t level = (reg == 0x3FF44008 || reg == 0x3FF44014) ? HIGH : LOW;
+  for (uint8_t i = 0; i < 32; ++i)
+    if (val & (1UL << i)) digitalWrite(base + i, level);
+}
+
+static std::mt19937 s_rng(12345);
+
+void randomSeed(unsigned long seed) { s_rng.seed((uint32_t)seed); }
+long random(long max) { return max > 0 ? (long)(s_rng() % (unsigned long)max) : 0; }
+long random(long min, long max) { return max > min ? min + random(max - min) : min; }
+
+/*
+*   ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+*                          Serial (stdin / stdout)
+*   ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+*/
+static struct termios s_tty_saved;
+static bool           s_tty_raw = false;
+static bool           s_stdin_eof = false;
+static bool           s_mute = false;
+
+void native_serial_mute(bool on) { s_mute = on; }
+
+static void _tty_restore() {
+  if (s_tty_raw) tcsetattr(0, TCSANOW, &s_tty_saved);
+}
+
+// Console only: keystrokes unbuffered and unechoed, the shell echoes.
+void HardwareSerial::begin(unsigned long, uint32_t, int8_t, int8_t) {
+  if (_num != 0 || s_tty_raw || !isatty(0)) return;
+  if (tcgetattr(0, &s_tty_saved)) return;
+  struct termios t = s_tty_saved;
+  t.c_lflag &= ~(ICANON | ECHO);
+  t.c_cc[VMIN]  = 0;
+  t.c_cc[VTIME] = 0;
+  if (tcsetattr(0, TCSANOW, &t)) return;
+  s_tty_raw = true;
+  atexit(_tty_restore);
+}
+
+int HardwareSerial::available() {
+  if (_num != 0 || s_stdin_eof) return 0;
+  int n = 0;
+  if (ioctl(0, FIONREAD, &n) == 0 && n > 0) return n;
+  struct pollfd p = { 0, POLLIN, 0 };
+  if (poll(&p, 1, 0) == 1 && (p.revents & (POLLIN | POLLHUP))) {
+    if (ioctl(0, FIONREAD, &n) == 0 && n > 0) return n;
+    s_stdin_eof = true;           // piped input ran out: keep running headless
+  }
+  return 0;
+}
+
+int HardwareSerial::read() {
+  if (!available()) return -1;
+  unsigned char c;
+  return ::read(0, &c, 1) == 1 ? c : -1;
+}
+
+size_t HardwareSerial::write(const uint8_t *b, size_t n) {
+  if (_num != 0 || s_mute) return n;
+  size_t w = 0;
+  while (w < n) {
+    ssize_t k = ::write(1, b + w, n - w);
+    if (k <= 0) { if (errno == EINTR) continue; break; }
+    w += (size_t)k;
+  }
+  return w;
+}
+
+void HardwareSerial::flush() {}
+
+/*
+*   ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+*                              ESP / FreeRTOS
+*   ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+*/
+void EspClass::restart() {
+  fprintf(stderr, "[native] ESP.restart() : exiting\n");
+  exit(0);
+}
+
+BaseType_t xTaskCreatePinnedToCore(void (*fn)(void *), const char *, uint32_t,
+                                   void *arg, unsigned, TaskHandle_t *handle, int) {
+  std::thread(fn, arg).detach();
+  if (handle) *handle = nullptr;
+  return pdPASS;
+}
+
+/*
+*   ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+*                                 Sockets
+*   ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+*/
+IPAddress WiFiClass::localIP() { return IPAddress(); }
+
+int WiFiClass::hostByName(const char *host, IPAddress &ip) {
+  struct addrinfo hints = {}, *res = nullptr;
+  hints.ai_family = AF_INET;
+  if (getaddrinfo(host, nullptr, &hints, &res) != 0) return 0;
+  memcpy(ip.b, &((struct sockaddr_in *)res->ai_addr)->sin_addr, 4);
+  freeaddrinfo(res);
+  return 1;
+}
+
+NativeSock::~NativeSock() { if (fd >= 0) ::close(fd); }
+
+int WiFiClient::connect(const char *host, uint16_t port) {
+  stop();
+  char service[8];
+  snprintf(service, sizeof(service), "%u", port);
+  struct addrinfo hints = {}, *res = nullptr;
+  hints.ai_family   = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  if (getaddrinfo(host, service, &hints, &res) != 0) return 0;
+
+  int fd = -1;
+  for (struct addrinfo *a = res; a && fd < 0; a = a->ai_next) {
+    fd = ::socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+    if (fd < 0) continue;
+    // non-blocking connect bounded by the Stream timeout, then blocking writes
+    fcntl(fd, F_SETFL, O_NONBLOCK);
+    int rc = ::connect(fd, a->ai_addr, a->ai_addrlen);
+    if (rc < 0 && errno == EINPROGRESS) {
+      struct pollfd p = { fd, POLLOUT, 0 };
+      int err = 0;
+      socklen_t len = sizeof(err);
+      if (poll(&p, 1, (int)_timeout) == 1 &&
+          getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len) == 0 && err == 0)
+        rc = 0;
+    }
+    if (rc < 0) { ::close(fd); fd = -1; continue; }
+    fcntl(fd, F_SETFL, 0);
+  }
+  freeaddrinfo(res);
+  if (fd < 0) return 0;
+  _sock = std::make_shared<NativeSock>(fd);
+  setNoDelay(true);
+  return 1;
+}
+
+uint8_t WiFiClient::connected() {
+  if (!_sock) return 0;
+  char c;
+  ssize_t n = ::recv(_sock->fd, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+  if (n > 0) return 1;
+  if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) return 1;
+  return 0;
+}
+
+void WiFiClient::stop() { _sock.reset(); }
+
+int WiFiClient::available() {
+  if (!_sock) return 0;
+  int n = 0;
+  return ioctl(_sock->fd, FIONREAD, &n) == 0 ? n : 0;
+}
+
+int WiFiClient::read() {
+  uint8_t c;
+  return read(&c, 1) == 1 ? c : -1;
+}
+
+int WiFiClient::read(uint8_t *buf, size_t n) {
+  if (!_sock) return -1;
+  ssize_t k = ::recv(_sock->fd, buf, n, MSG_DONTWAIT);
+  return k > 0 ? (int)k : -1;
+}
+
+size_t WiFiClient::write(const uint8_t *b, size_t n) {
+  if (!_sock) return 0;
+  size_t w = 0;
+  while (w < n) {
+    ssize_t k = ::send(_sock->fd, b + w, n - w, MSG_NOSIGNAL);
+    if (k <= 0) { if (k < 0 && errno == EINTR) continue; break; }
+    w += (size_t)k;
+  }
+  return w;
+}
+
+void WiFiClient::setNoDelay(bool on) {
+  if (!_sock) return;
+  int v = on ? 1 : 0;
+  setsockopt(_sock->fd, IPPROTO_TCP, TCP_NODELAY, &v, sizeof(v));
+}
+
+void WiFiServer::begin(uint16_t port) {
+  if (port) _port = port;
+  stop();
+  _fd = ::socket(AF_INET, SOCK_STREAM, 0);
+  if (_fd < 0) return;
+  int one = 1;
+  setsockopt(_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  struct sockaddr_in a = {};
+  a.sin_family      = AF_INET;
+  a.sin_port        = htons(_port);
+  a.sin_addr.s_addr = htonl(INADDR_ANY);
+  if (::bind(_fd, (struct sockaddr *)&a, sizeof(a)) || ::listen(_fd, 4)) {
+    fprintf(stderr, "[native] listen on port %u failed: %s\n", _port, strerror(errno));
+    ::close(_fd);
+    _fd = -1;
+    return;
+  }
+  fcntl(_fd, F_SETFL, O_NONBLOCK);
+}
+
+WiFiClient WiFiServer::accept() {
+  if (_fd < 0) return WiFiClient();
+  int fd = ::accept(_fd, nullptr, nullptr);
+  if (fd < 0) return WiFiClient();
+  fcntl(fd, F_SETFL, 0);
+  return WiFiClient(fd);
+}
+
+void WiFiServer::stop() {
+  if (_fd >= 0) ::close(_fd);
+  _fd = -1;
+}
+
+/*
+*   ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+*                          Preferences (files)
+*   ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+* File format: per key, u8 key length, key, u32 value length, value.
+*/
+static const char *_data_dir() {
+  const char *d = getenv("FC_NATIVE_DIR");
+  return d && d[0] ? d : "native_data";
+}
+
+bool Preferences::begin(const char *name, bool read_only, const char *) {
+  _kv.clear();
+  _dirty = false;
+  _ro   = read_only;
+  _file = std::string(_data_dir()) + "/" + name + ".nvs";
+  _open = true;
+  FILE *f = fopen(_file.c_str(), "rb");
+  if (!f) return true;
+  uint8_t kl;
+  while (fread(&kl, 1, 1, f) == 1) {
+    std::string k(kl, '\0');
+    uint32_t    vl;
+    if (fread(&k[0], 1, kl, f) != kl || fread(&vl, 4, 1, f) != 1) break;
+    std::vector<uint8_t> v(vl);
+    if (vl && fread(v.data(), 1, vl, f) != vl) break;
+    _kv[k] = std::move(v);
+  }
+  fclose(f);
+  return true;
+}
+
+void Preferences::_save() {
+  mkdir(_data_dir(), 0755);
+  std::string tmp = _file + ".tmp";
+  FILE *f = fopen(tmp.c_str(), "wb");
+  if (!f) return;
+  for (const auto &kv : _kv) {
+    uint8_t  kl = (uint8_t)kv.first.size();
+    uint32_t vl = (uint32_t)kv.second.size();
+    fwrite(&kl, 1, 1, f);
+    fwrite(kv.first.data(), 1, kl, f);
+    fwrite(&vl, 4, 1, f);
+    if (vl) fwrite(kv.second.data(), 1, vl, f);
+  }
+  fclose(f);
+  rename(tmp.c_str(), _file.c_str());
+}
+
+size_t Preferences::_put(const char *key, const void *v, size_t n) {
+  if (!_open || _ro || strlen(key) > 15) return 0;     // NVS key limit
+  const uint8_t *p = (const uint8_t *)v;
+  _kv[key].assign(p, p + n);
+  _dirty = true;
+  return n;
+}
+
+size_t Preferences::_get(const char *key, void *v, size_t n) const {
+  auto it = _kv.find(key);
+  if (it == _kv.end() || it->second.size() > n) return 0;
+  memcpy(v, it->second.data(), it->second.size());
+  return it->second.size();
+}
+
+bool Preferences::clear() {
+  if (!_open || _ro) return false;
+  _kv.clear();
+  _dirty = true;
+  return true;
+}
+
+bool Preferences::remove(const char *key) {
+  if (!_open || _ro || !_kv.erase(key)) return false;
+  _dirty = true;
+  return true;
+}
+
+size_t Preferences::getString(const char *k, char *v, size_t n) const {
+  auto it = _kv.find(k);
+  if (it == _kv.end() || it->second.size() > n) return 0;
+  memcpy(v, it->second.data(), it->second.size());
+  return it->second.size();
+}
+
+String Preferences::getString(const char *k, const String &d) const {
+  auto it = _kv.find(k);
+  return it == _kv.end() ? d : String((const char *)it->second.data());
+}
+
+size_t Preferences::getBytesLength(const char *k) const {
+  auto it = _kv.find(k);
+  return it == _kv.end() ? 0 : it->second.size();
+}
+
+/*
+*   ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+*                          Wire (simulated bus)
+*   ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+*/
+static void _i2c_log(std::string &log, const char *fmt, unsigned v) {
+  char b[16];
+  snprintf(b, sizeof(b), fmt, v);
+  if (!log.empty() && fmt[0] != ' ') log += ' ';
+  log += b;
+}
+
+// START, address + W, the queued bytes; the device takes the first as its
+// register pointer and stores the rest from there.
+void TwoWire::_put_write() {
+  _i2c_log(_log, "S %02X W", _addr);
+  for (size_t i = 0; i < _tx_len; ++i) {
+    _i2c_log(_log, " %02X", _tx[i]);
+    if (!_ack(_addr)) continue;
+    if (i == 0) _dev->ptr = _tx[0];
+    else        _dev->reg[_dev->ptr++] = _tx[i];
+  }
+}
+
+uint8_t TwoWire::endTransmission(bool stop) {
+  if (!stop) {                                  // 2.x: held for requestFrom()
+    _queued = true;
+    return 0;
+  }
+  _put_write();
+  _log += " P";
+  _tx_len = 0;
+  return _ack(_addr) ? 0 : 2;
+}
+
+uint8_t TwoWire::requestFrom(uint8_t a, size_t n, bool stop) {
+  (void)stop;                                   // 2.x always ends a read with STOP
+  _rx_len = _rx_pos = 0;
+  if (_queued && a == _addr) {
+    _put_write();
+    _i2c_log(_log, " Sr %02X R", a);
+  } else {
+    _i2c_log(_log, "S %02X R", a);
+  }
+  _queued = false;
+  _tx_len = 0;
+  if (_ack(a)) {
+    for (; _rx_len < n && _rx_len < sizeof(_rx); ++_rx_len) {
+      _rx[_rx_len] = _dev->reg[_dev->ptr++];
+      _i2c_log(_log, " %02X", _rx[_rx_len]);
+    }
+  }
+  _log += " P";
+  return (uint8_t)_rx_len;
+}
+
+/*
+*   ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+*                                 main()
+*   ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━
+*/
+#ifndef FC_NATIVE_NO_MAIN
+static void _on_signal(int) { _tty_restore(); _exit(130); }
+
+int main() {
+  const char *g = getenv("FC_NATIVE_GPIO");
+  s_gpio_trace = g && g[0] == '1';
+  for (uint8_t p = 0; p < NATIVE_PINS; ++p) s_pins[p].ledc = -1;
+  signal(SIGINT,  _on_signal);
+  signal(SIGTERM, _on_signal);
+  signal(SIGPIPE, SIG_IGN);
+  _mono_us();
+  setup();
+  for (;;) {
+    loop();
+    delayMicroseconds(100);       // a pass per ~0.1 ms instead of a spinning core
+  }
+}
+#endif
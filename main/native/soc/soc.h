@@ -0,0 +1,5 @@
+#pragma once
+// Native build: register writes land in the simulated pin table.
+#include <stdint.h>
+void native_reg_write(uint32_t reg, uint32_t val);
+#define REG_WRITE(reg, val) native_reg_write((uint32_t)(reg), (uint32_t)(val))
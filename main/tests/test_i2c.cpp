@@ -0,0 +1,134 @@
+/*
+ * ─────────────────────────────────────────────────────────────
+ * FemtoClaw : I2C transaction test on the simulated Wire bus.
+ *
+ * Built by [env:native_test_i2c]. Runs the i2c_write / i2c_read /
+ * i2c_xfer step lists through i2c_run() against one register-file
+ * device (native/Wire.h) and compares what went on the wire, START to
+ * STOP, with what the device ended up holding.
+ *
+ * Usage (from main/):
+ *   pio run -e native_test_i2c && .pio/build/native_test_i2c/program
+ * ─────────────────────────────────────────────────────────────
+ */
+
+#include "platform.h"
+#include "constants.h"
+#include "config.h"
+#include "board_parser.h"
+#include "json.h"
+#include "arena.h"
+#include "mcu_wifi.h"
+#include "persist.h"
+#include "spsc.h"
+#include "hist.h"
+#include "mem.h"
+#include "http.h"
+#include "scheduler.h"
+#include "llm.h"
+#include "actions.h"
+
+static SimI2cDevice s_mpu;              // MPU-6050 stand-in at 0x68
+static uint8_t      s_fails = 0;
+
+static void _reset_mpu() {
+  memset(&s_mpu, 0, sizeof(s_mpu));
+  s_mpu.addr = 0x68;
+  for (uint16_t r = 0; r < 256; ++r) s_mpu.reg[r] = (uint8_t)r;
+  s_mpu.reg[0x6B] = 0x40;               // PWR_MGMT_1 : asleep
+  Wire.sim_log().clear();
+}
+
+static void _check(const char *what, bool ok, const char *detail = "") {
+  printf("  %-46s %s%s%s\n", what, ok ? "PASS" : "FAIL", detail[0] ? "  " : "", detail);
+  if (!ok) ++s_fails;
+}
+
+// Compile seq, run it, and compare the bus log and read data.
+static void _xfer(const char *seq, uint8_t addr, uint8_t want_err,
+                  const char *want_bus, const char *want_hex) {
+  char buf[128];
+  I2cStep steps[I2C_MAX_STEPS];
+  uint8_t wbuf[I2C_BURST_MAX];
+  char    hex[I2C_BURST_MAX * 2 + 1];
+  strlcpy(buf, seq, sizeof(buf));
+  int n = i2c_parse_seq(buf, steps, wbuf);
+  if (n <= 0) { _check(seq, false, "parse failed"); return; }
+  uint8_t err = i2c_run(0, addr, steps, (uint8_t)n, wbuf, hex, sizeof(hex));
+  const std::string &bus = Wire.sim_log();
+  char detail[320];
+  snprintf(detail, sizeof(detail), "err=%u bus=\"%s\" data=%s", err, bus.c_str(), hex);
+  _check(seq, err == want_err && bus == want_bus && !strcmp(hex, want_hex), detail);
+}
+
+int main() {
+  Wire.sim_attach(&s_mpu);
+  printf("i2c_run on the simulated bus (arduino-esp32 2.x semantics)\n");
+
+  // Wake, then burst-read accel X/Y: the wake write must reach the device.
+  _reset_mpu();
+  _xfer("w:0x6B,0x00;w:0x3B;r:4", 0x68, 0,
+        "S 68 W 6B 00 P S 68 W 3B Sr 68 R 3B 3C 3D 3E P", "3B3C3D3E");
+  _check("  PWR_MGMT_1 cleared by the wake write", s_mpu.reg[0x6B] == 0x00);
+
+  // i2c_read: pointer write, repeated START, read.
+  _reset_mpu();
+  {
+    uint8_t reg = 0x75;                 // WHO_AM_I
+    I2cStep steps[2] = {{false, 1, 0}, {true, 2, 0}};
+    char hex[8];
+    uint8_t err = i2c_run(0, 0x68, steps, 2, &reg, hex, sizeof(hex));
+    _check("i2c_read reg=0x75 len=2",
+           !err && Wire.sim_log() == "S 68 W 75 Sr 68 R 75 76 P" && !strcmp(hex, "7576"),
+           Wire.sim_log().c_str());
+  }
+
+  // i2c_write: one transmission, register then data.
+  _reset_mpu();
+  {
+    uint8_t wbuf[3] = {0x1B, 0x18, 0x10};
+    I2cStep st = {false, 3, 0};
+    char none[1];
+    uint8_t err = i2c_run(0, 0x68, &st, 1, wbuf, none, sizeof(none));
+    _check("i2c_write reg=0x1B data=0x18,0x10",
+           !err && Wire.sim_log() == "S 68 W 1B 18 10 P" &&
+           s_mpu.reg[0x1B] == 0x18 && s_mpu.reg[0x1C] == 0x10,
+           Wire.sim_log().c_str());
+  }
+
+  // Consecutive writes stay separate register writes.
+  _reset_mpu();
+  _xfer("w:0x6B,0x01;w:0x1A,0x03;w:0x19,0x07", 0x68, 0,
+        "S 68 W 6B 01 P S 68 W 1A 03 P S 68 W 19 07 P", "");
+  _check("  0x6B / 0x1A / 0x19 written, 0x6C untouched",
+         s_mpu.reg[0x6B] == 0x01 && s_mpu.reg[0x1A] == 0x03 &&
+         s_mpu.reg[0x19] == 0x07 && s_mpu.reg[0x6C] == 0x6C);
+
+  // Read → read continues from the device's pointer after a STOP.
+  _reset_mpu();
+  _xfer("w:0x41;r:2;r:2", 0x68, 0, "S 68 W 41 Sr 68 R 41 42 P S 68 R 43 44 P", "41424344");
+
+  // Read → write: STOP, then a fresh write.
+  _reset_mpu();
+  _xfer("w:0x3B;r:1;w:0x6B,0x00", 0x68, 0, "S 68 W 3B Sr 68 R 3B P S 68 W 6B 00 P", "3B");
+
+  // Nothing at 0x69: the first step NACKs and nothing else is sent.
+  _reset_mpu();
+  _xfer("w:0x6B,0x00;w:0x3B;r:2", 0x69, 2, "S 69 W 6B 00 P", "");
+  _reset_mpu();
+  _xfer("w:0x3B;r:2", 0x69, 2, "S 69 W 3B Sr 69 R P", "");
+
+  // A read length with anything after it is a bad seq, not a shorter read.
+  for (const char *bad : {"w:0x3B;r:4x", "w:0x3B;r:4,5", "r:", "r:0x"}) {
+    char buf[32];
+    I2cStep steps[I2C_MAX_STEPS];
+    uint8_t wbuf[I2C_BURST_MAX];
+    strlcpy(buf, bad, sizeof(buf));
+    char what[48];
+    snprintf(what, sizeof(what), "rejects \"%s\"", bad);
+    _check(what, i2c_parse_seq(buf, steps, wbuf) < 0);
+  }
+
+  printf(s_fails ? "%u FAILED\n" : "all passed\n", s_fails);
+  return s_fails ? 1 : 0;
+}
@@ -0,0 +1,161 @@
+/*
+ * ─────────────────────────────────────────────────────────────
+ * FemtoClaw : SpscQueue stress test, one producer and one consumer thread.
+ *
+ * Built by [env:native_test_spsc] with -fsanitize=thread, so a missing
+ * acquire / release on head or tail shows up as a data race on the slot.
+ * Each run pushes a numbered sequence through the ring and the consumer
+ * checks it arrives complete, in order and exactly once. Every record's
+ * payload is derived from its number, which also catches torn slots. With
+ * uint8_t indices, a few million items wrap head and tail tens of
+ * thousands of times.
+ *
+ * Usage (from main/):
+ *   pio run -e native_test_spsc && .pio/build/native_test_spsc/program [items]
+ * ─────────────────────────────────────────────────────────────
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <thread>
+
+#include "spsc.h"
+
+static uint8_t s_fails = 0;
+
+static void _check(const char *what, bool ok, const char *detail = "") {
+  printf("  %-40s %s%s%s\n", what, ok ? "PASS" : "FAIL", detail[0] ? "  " : "", detail);
+  if (!ok) ++s_fails;
+}
+
+// Big enough that a torn copy is likely to be caught, like an InMsg slot.
+struct Rec {
+  uint32_t seq;
+  uint8_t  fill[60];
+};
+
+static void _rec_make(Rec &r, uint32_t seq) {
+  r.seq = seq;
+  for (uint8_t i = 0; i < sizeof(r.fill); ++i) r.fill[i] = (uint8_t)(seq * 31u + i);
+}
+
+static bool _rec_ok(const Rec &r, uint32_t seq) {
+  if (r.seq != seq) return false;
+  for (uint8_t i = 0; i < sizeof(r.fill); ++i)
+    if (r.fill[i] != (uint8_t)(seq * 31u + i)) return false;
+  return true;
+}
+
+struct RunStats {
+  uint32_t got, bad_at, full, empty;
+  uint8_t  max_size;
+};
+
+/*
+ * Producer: push() for even numbers, back() + commit() for odd ones.
+ * Consumer: pop() and front() + drop() in turn.
+ * Both spin (yielding) on full / empty, which is where the races live.
+ */
+template <uint8_t N>
+static RunStats _run(uint32_t items, bool in_place) {
+  static SpscQueue<Rec, N> q;
+  q.head.store(0); q.tail.store(0);
+  RunStats rs = {0, UINT32_MAX, 0, 0, 0};
+
+  std::thread prod([&] {
+    uint32_t full = 0;
+    for (uint32_t s = 0; s < items; ++s) {
+      if (in_place && (s & 1)) {
+        Rec *r;
+        while (!(r = q.back())) { ++full; std::this_thread::yield(); }
+        _rec_make(*r, s);
+        q.commit();
+      } else {
+        Rec r;
+        _rec_make(r, s);
+        while (!q.push(r)) { ++full; std::this_thread::yield(); }
+      }
+    }
+    rs.full = full;
+  });
+
+  for (uint32_t s = 0; s < items; ++s) {
+    bool ok;
+    if (in_place && (s & 1)) {
+      Rec *r;
+      while (!(r = q.front())) { ++rs.empty; std::this_thread::yield(); }
+      ok = _rec_ok(*r, s);
+      q.drop();
+    } else {
+      Rec r;
+      while (!q.pop(r)) { ++rs.empty; std::this_thread::yield(); }
+      ok = _rec_ok(r, s);
+    }
+    uint8_t n = q.size();
+    if (n > rs.max_size) rs.max_size = n;
+    if (!ok) { rs.bad_at = s; break; }
+    ++rs.got;
+  }
+  prod.join();
+  if (rs.bad_at == UINT32_MAX && !q.empty()) rs.bad_at = items;     // extra items: duplicates
+  return rs;
+}
+
+template <uint8_t N>
+static void _stress(const char *name, uint32_t items, bool in_place) {
+  auto t0 = std::chrono::steady_clock::now();
+  RunStats rs = _run<N>(items, in_place);
+  double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+  char detail[160];
+  snprintf(detail, sizeof(detail), "%lu items  %.0f ms  full %lu  empty %lu  max size %u%s",
+           (unsigned long)rs.got, ms, (unsigned long)rs.full, (unsigned long)rs.empty,
+           (unsigned)rs.max_size, rs.bad_at != UINT32_MAX ? "  (out of order / corrupt)" : "");
+  _check(name, rs.got == items && rs.bad_at == UINT32_MAX && rs.max_size <= N, detail);
+}
+
+// Single thread: walk head / tail across the uint8_t wrap with the ring
+// full, so the "h - t >= N" test is exercised at 255 → 0.
+static void _wrap_edges() {
+  static SpscQueue<uint32_t, 128> q;
+  uint32_t v, next_in = 0, next_out = 0;
+  bool ok = true;
+  for (uint8_t half = 0; half < 2; ++half) {            // indices to 200, ring empty
+    for (uint8_t i = 0; i < 100; ++i) ok &= q.push(next_in++);
+    for (uint8_t i = 0; i < 100; ++i) ok &= q.pop(v) && v == next_out++;
+  }
+  ok &= q.empty() && q.head.load() == 200;
+  for (uint16_t round = 0; round < 600; ++round) {       // head passes 255 → 0 many times
+    while (q.push(next_in)) ++next_in;
+    ok &= q.size() == 128 && q.back() == nullptr;
+    for (uint8_t i = 0; i < 128; ++i) ok &= q.peek(i) && *q.peek(i) == next_out + i;
+    ok &= q.peek(128) == nullptr && q.peek(255) == nullptr;
+    uint8_t k = (uint8_t)(1 + round % 128);
+    for (uint8_t i = 0; i < k; ++i) ok &= q.pop(v) && v == next_out++;
+    uint32_t *b = q.back();
+    ok &= b != nullptr;
+    if (b) { *b = next_in++; q.commit(); }
+  }
+  while (uint32_t *f = q.front()) { ok &= *f == next_out++; q.drop(); }
+  ok &= q.empty() && next_in == next_out && !q.pop(v);
+  q.drop();                                               // drop() on empty is a no-op
+  ok &= q.empty();
+  char detail[64];
+  snprintf(detail, sizeof(detail), "%lu items, head %u", (unsigned long)next_in, (unsigned)q.head.load());
+  _check("wrap at 255 → 0, full / empty edges, peek", ok, detail);
+}
+
+int main(int argc, char **argv) {
+  uint32_t items = argc > 1 ? (uint32_t)strtoul(argv[1], nullptr, 0) : 2000000;
+  printf("SpscQueue : 1 producer, 1 consumer thread, %lu items per run\n", (unsigned long)items);
+  _wrap_edges();
+  _stress<2>  ("N=2   push / pop",                 items, false);
+  _stress<4>  ("N=4   push / pop",                 items, false);
+  _stress<4>  ("N=4   back+commit / front+drop",   items, true);
+  _stress<128>("N=128 push / pop",                 items, false);
+  _stress<128>("N=128 back+commit / front+drop",   items, true);
+  printf(s_fails ? "%u FAILED\n" : "all passed\n", s_fails);
+  return s_fails ? 1 : 0;
+}